@@ -0,0 +1,271 @@
+// CellPainter::paint against drawing straight onto the plane, one colour pair and putstr per
+// cell, on a 300x100 grid. Built against the mock notcurses in bench/mock, which counts
+// calls and copies what is written into an in-memory plane: the call counts are exact, but
+// the times only cover the painter's own work and the mock's, not real notcurses.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <notcurses/notcurses.h>
+
+#include "animations/cell_painter.h"
+#include "animations/glyph_table.h"
+
+struct ncplane {
+    struct Cell {
+        std::uint32_t codepoint = 0;
+        std::uint32_t fg = 0;
+        std::uint32_t bg = 0;
+    };
+
+    int rows = 0;
+    int cols = 0;
+    std::uint32_t fg = 0;
+    std::uint32_t bg = 0;
+    std::vector<Cell> cells;
+};
+
+namespace bench {
+namespace {
+
+constexpr unsigned int kRows = 100;
+constexpr unsigned int kCols = 300;
+constexpr int kFrames = 200;
+
+struct CallCounts {
+    std::uint64_t set_fg = 0;
+    std::uint64_t set_bg = 0;
+    std::uint64_t putstr = 0;
+
+    std::uint64_t total() const { return set_fg + set_bg + putstr; }
+};
+
+CallCounts calls;
+
+// Decodes one UTF-8 sequence at `text`; returns its length in bytes, 0 when invalid.
+int decode_utf8(const char* text, std::uint32_t* codepoint) {
+    const auto lead = static_cast<unsigned char>(text[0]);
+    int length = 0;
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    }
+    if ((lead & 0xe0) == 0xc0) {
+        length = 2;
+        *codepoint = lead & 0x1f;
+    } else if ((lead & 0xf0) == 0xe0) {
+        length = 3;
+        *codepoint = lead & 0x0f;
+    } else if ((lead & 0xf8) == 0xf0) {
+        length = 4;
+        *codepoint = lead & 0x07;
+    } else {
+        return 0;
+    }
+    for (int i = 1; i < length; ++i) {
+        const auto next = static_cast<unsigned char>(text[i]);
+        if ((next & 0xc0) != 0x80) {
+            return 0;
+        }
+        *codepoint = (*codepoint << 6) | (next & 0x3f);
+    }
+    return length;
+}
+
+int codepoint_width(std::uint32_t codepoint) {
+    const bool wide = (codepoint >= 0x1100 && codepoint <= 0x115f) || (codepoint >= 0x2e80 && codepoint <= 0xa4cf) ||
+                      (codepoint >= 0xac00 && codepoint <= 0xd7a3) || (codepoint >= 0xf900 && codepoint <= 0xfaff) ||
+                      (codepoint >= 0xff00 && codepoint <= 0xff60) || (codepoint >= 0x1f300 && codepoint <= 0x1faff);
+    return wide ? 2 : 1;
+}
+
+} // namespace
+} // namespace bench
+
+extern "C" {
+
+int ncplane_set_fg_rgb(ncplane* n, std::uint32_t channel) {
+    ++bench::calls.set_fg;
+    n->fg = channel;
+    return 0;
+}
+
+int ncplane_set_bg_rgb(ncplane* n, std::uint32_t channel) {
+    ++bench::calls.set_bg;
+    n->bg = channel;
+    return 0;
+}
+
+int ncplane_putstr_yx(ncplane* n, int y, int x, const char* gclusters) {
+    ++bench::calls.putstr;
+    if (y < 0 || y >= n->rows) {
+        return -1;
+    }
+    int written = 0;
+    while (*gclusters && x < n->cols) {
+        std::uint32_t codepoint = 0;
+        const int length = bench::decode_utf8(gclusters, &codepoint);
+        if (length == 0) {
+            return -1;
+        }
+        n->cells[static_cast<std::size_t>(y) * n->cols + x] = ncplane::Cell{codepoint, n->fg, n->bg};
+        x += bench::codepoint_width(codepoint);
+        gclusters += length;
+        ++written;
+    }
+    return written;
+}
+
+int ncstrwidth(const char* egcs, int* validbytes, int* validwidth) {
+    int bytes = 0;
+    int width = 0;
+    while (egcs[bytes]) {
+        std::uint32_t codepoint = 0;
+        const int length = bench::decode_utf8(egcs + bytes, &codepoint);
+        if (length == 0) {
+            break;
+        }
+        bytes += length;
+        width += bench::codepoint_width(codepoint);
+    }
+    if (validbytes) {
+        *validbytes = bytes;
+    }
+    if (validwidth) {
+        *validwidth = width;
+    }
+    return egcs[bytes] ? -1 : width;
+}
+
+} // extern "C"
+
+namespace bench {
+namespace {
+
+using why::animations::CellPainter;
+using why::animations::GlyphId;
+
+struct Scene {
+    const char* name;
+    std::vector<CellPainter::Cell> cells; // kRows * kCols
+};
+
+std::vector<Scene> make_scenes() {
+    const GlyphId block = why::animations::GlyphTable::instance().intern("█");
+    const std::size_t count = static_cast<std::size_t>(kRows) * kCols;
+
+    std::vector<std::uint32_t> palette;
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        palette.push_back(CellPainter::pack_rgb(static_cast<std::uint8_t>(40 + i * 13),
+                                                static_cast<std::uint8_t>(220 - i * 11),
+                                                static_cast<std::uint8_t>(90 + i * 9)));
+    }
+
+    std::vector<Scene> scenes;
+    scenes.push_back(Scene{"bars, one colour", std::vector<CellPainter::Cell>(count, {block, 0x30c0ff})});
+
+    Scene bands{"20-column colour bands", std::vector<CellPainter::Cell>(count)};
+    for (std::size_t i = 0; i < count; ++i) {
+        bands.cells[i] = {block, palette[(i % kCols) / 20]};
+    }
+    scenes.push_back(std::move(bands));
+
+    Scene random{"random colour every cell", std::vector<CellPainter::Cell>(count)};
+    std::uint32_t state = 0x9e3779b9u;
+    for (std::size_t i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        random.cells[i] = {block, palette[state >> 28]};
+    }
+    scenes.push_back(std::move(random));
+    return scenes;
+}
+
+// How the animations drew before CellPainter.
+void draw_per_cell(ncplane* plane, const Scene& scene) {
+    const auto& table = why::animations::GlyphTable::instance();
+    for (unsigned int row = 0; row < kRows; ++row) {
+        for (unsigned int col = 0; col < kCols; ++col) {
+            const CellPainter::Cell& cell = scene.cells[static_cast<std::size_t>(row) * kCols + col];
+            ncplane_set_fg_rgb(plane, cell.rgb);
+            ncplane_set_bg_rgb(plane, 0x000000);
+            ncplane_putstr_yx(plane, static_cast<int>(row), static_cast<int>(col), table.text(cell.glyph).c_str());
+        }
+    }
+}
+
+void draw_painter(ncplane* plane, CellPainter& painter, const Scene& scene) {
+    for (unsigned int row = 0; row < kRows; ++row) {
+        for (unsigned int col = 0; col < kCols; ++col) {
+            const CellPainter::Cell& cell = scene.cells[static_cast<std::size_t>(row) * kCols + col];
+            painter.put(row, col, cell.glyph, cell.rgb);
+        }
+    }
+    painter.paint(plane, 0, kRows);
+}
+
+template<typename Draw>
+void measure(Draw&& draw, std::uint64_t* calls_per_frame, double* us_per_frame) {
+    calls = {};
+    draw();
+    *calls_per_frame = calls.total();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; ++frame) {
+        draw();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    *us_per_frame = std::chrono::duration<double, std::micro>(elapsed).count() / kFrames;
+}
+
+} // namespace
+} // namespace bench
+
+int main() {
+    ncplane per_cell_plane;
+    per_cell_plane.rows = static_cast<int>(bench::kRows);
+    per_cell_plane.cols = static_cast<int>(bench::kCols);
+    per_cell_plane.cells.resize(static_cast<std::size_t>(bench::kRows) * bench::kCols);
+    ncplane painter_plane = per_cell_plane;
+
+    why::animations::CellPainter painter;
+    painter.resize(bench::kRows, bench::kCols);
+    painter.set_background(0x000000);
+
+    std::printf("%-26s %10s %10s %12s %12s\n", "scene (300x100)", "per-cell", "painter", "per-cell_us", "painter_us");
+    bool identical = true;
+    for (const bench::Scene& scene : bench::make_scenes()) {
+        std::uint64_t per_cell_calls = 0;
+        std::uint64_t painter_calls = 0;
+        double per_cell_us = 0.0;
+        double painter_us = 0.0;
+        bench::measure([&] { bench::draw_per_cell(&per_cell_plane, scene); }, &per_cell_calls, &per_cell_us);
+        bench::measure([&] { bench::draw_painter(&painter_plane, painter, scene); }, &painter_calls, &painter_us);
+
+        const auto same_cell = [](const ncplane::Cell& a, const ncplane::Cell& b) {
+            return a.codepoint == b.codepoint && a.fg == b.fg && a.bg == b.bg;
+        };
+        const bool same = std::equal(per_cell_plane.cells.begin(),
+                                     per_cell_plane.cells.end(),
+                                     painter_plane.cells.begin(),
+                                     same_cell);
+        identical = identical && same;
+        std::printf("%-26s %10llu %10llu %12.1f %12.1f%s\n",
+                    scene.name,
+                    static_cast<unsigned long long>(per_cell_calls),
+                    static_cast<unsigned long long>(painter_calls),
+                    per_cell_us,
+                    painter_us,
+                    same ? "" : "  MISMATCH");
+    }
+
+    if (!identical) {
+        std::fprintf(stderr, "[bench] the painter produced a different plane than per-cell drawing\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Per-hop cost of the generic kiss_fft spectrum path against the compile-time specialised
+// DspKernel for the 1024/32, 2048/64 and 4096/128 presets (hop = fft / 4), plus the largest
+// band energy difference between the two paths on the same input.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+#include "dsp.h"
+
+namespace {
+
+constexpr std::uint32_t kSampleRate = 48000;
+constexpr std::size_t kHops = 4000;
+constexpr int kRepeats = 5;
+constexpr float kTolerance = 1.5e-8f;
+
+struct Preset {
+    std::size_t fft_size;
+    std::size_t bands;
+};
+
+// A few tones with a slow amplitude wobble and a little deterministic noise, so every band
+// sees some energy.
+std::vector<float> make_signal(std::size_t length) {
+    std::vector<float> signal(length);
+    std::uint32_t noise = 0x12345678u;
+    for (std::size_t i = 0; i < length; ++i) {
+        const double t = static_cast<double>(i) / kSampleRate;
+        noise = noise * 1664525u + 1013904223u;
+        const double white = static_cast<double>(noise >> 8) / static_cast<double>(1u << 24) - 0.5;
+        const double wobble = 0.6 + 0.4 * std::sin(2.0 * 3.14159265358979 * 0.7 * t);
+        signal[i] = static_cast<float>(wobble * (0.4 * std::sin(2.0 * 3.14159265358979 * 55.0 * t) +
+                                                 0.25 * std::sin(2.0 * 3.14159265358979 * 440.0 * t) +
+                                                 0.15 * std::sin(2.0 * 3.14159265358979 * 3520.0 * t)) +
+                                       0.05 * white);
+    }
+    return signal;
+}
+
+// Mean microseconds per hop over the whole signal; best of kRepeats runs.
+double time_per_hop(const Preset& preset, bool specialized, const std::vector<float>& signal) {
+    const std::size_t hop = preset.fft_size / 4;
+    double best_us = 0.0;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        why::DspEngine engine(kSampleRate, 1, preset.fft_size, hop, preset.bands, specialized);
+        // One window of warm-up so every timed push runs exactly one hop.
+        engine.push_samples(signal.data(), preset.fft_size);
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t offset = preset.fft_size; offset + hop <= signal.size(); offset += hop) {
+            engine.push_samples(signal.data() + offset, hop);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double us = std::chrono::duration<double, std::micro>(elapsed).count() /
+                          static_cast<double>((signal.size() - preset.fft_size) / hop);
+        best_us = repeat == 0 ? us : std::min(best_us, us);
+    }
+    return best_us;
+}
+
+// Largest |generic - specialised| band energy after any hop.
+float max_band_difference(const Preset& preset, const std::vector<float>& signal) {
+    const std::size_t hop = preset.fft_size / 4;
+    why::DspEngine generic(kSampleRate, 1, preset.fft_size, hop, preset.bands, false);
+    why::DspEngine specialized(kSampleRate, 1, preset.fft_size, hop, preset.bands, true);
+    float max_difference = 0.0f;
+    for (std::size_t offset = 0; offset + hop <= signal.size(); offset += hop) {
+        generic.push_samples(signal.data() + offset, hop);
+        specialized.push_samples(signal.data() + offset, hop);
+        const std::vector<float>& a = generic.band_energies();
+        const std::vector<float>& b = specialized.band_energies();
+        for (std::size_t band = 0; band < a.size(); ++band) {
+            max_difference = std::max(max_difference, std::fabs(a[band] - b[band]));
+        }
+    }
+    return max_difference;
+}
+
+} // namespace
+
+int main() {
+    const Preset presets[] = {{1024, 32}, {2048, 64}, {4096, 128}};
+
+    bool all_match = true;
+    std::printf("%-10s %12s %12s %8s %14s\n", "preset", "generic_us", "special_us", "speedup", "max_band_diff");
+    for (const Preset& preset : presets) {
+        const std::vector<float> signal = make_signal(preset.fft_size + kHops * (preset.fft_size / 4));
+        {
+            why::DspEngine probe(kSampleRate, 1, preset.fft_size, preset.fft_size / 4, preset.bands, true);
+            if (!probe.using_specialized_kernel()) {
+                std::fprintf(stderr, "[bench] no specialised kernel for %zu/%zu\n", preset.fft_size, preset.bands);
+                return 1;
+            }
+        }
+
+        const double generic_us = time_per_hop(preset, false, signal);
+        const double specialized_us = time_per_hop(preset, true, signal);
+        const float difference = max_band_difference(preset, signal);
+        all_match = all_match && difference <= kTolerance;
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%zu/%zu", preset.fft_size, preset.bands);
+        std::printf("%-10s %12.2f %12.2f %7.2fx %14.3g%s\n",
+                    name,
+                    generic_us,
+                    specialized_us,
+                    specialized_us > 0.0 ? generic_us / specialized_us : 0.0,
+                    static_cast<double>(difference),
+                    difference <= kTolerance ? "" : "  MISMATCH");
+    }
+
+    if (!all_match) {
+        std::fprintf(stderr, "[bench] band energies differ by more than %g\n", static_cast<double>(kTolerance));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Cost of one EventBus::publish to 8 subscribers: the dense-slot InlineDelegate dispatch
+// against the previous std::type_index map with nested std::function handlers, which is
+// reproduced below as LegacyEventBus.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "events/event_bus.h"
+
+namespace bench {
+
+struct BenchEvent {
+    float value;
+    std::size_t index;
+};
+
+} // namespace bench
+
+namespace why {
+namespace events {
+template<> struct EventSlot<bench::BenchEvent> : std::integral_constant<std::size_t, kMaxEventSlots - 1> {
+    static constexpr const char* name = "BenchEvent";
+};
+} // namespace events
+} // namespace why
+
+namespace bench {
+namespace {
+
+constexpr std::size_t kSubscribers = 8;
+constexpr std::size_t kPublishes = 5'000'000;
+constexpr int kRepeats = 5;
+
+// Dispatch path of EventBus before dense slots: a type_index lookup per publish and a
+// std::function wrapping the typed std::function handler per subscriber.
+class LegacyEventBus {
+public:
+    template<typename EventT>
+    using Handler = std::function<void(const EventT&)>;
+
+    template<typename EventT>
+    void subscribe(Handler<EventT> handler) {
+        auto wrapper = [handler = std::move(handler)](const void* event_ptr) {
+            handler(*static_cast<const EventT*>(event_ptr));
+        };
+        subscribers_[std::type_index(typeid(EventT))].push_back(SubscriberEntry{next_id_++, true, std::move(wrapper)});
+    }
+
+    template<typename EventT>
+    void publish(const EventT& event) const {
+        auto it = subscribers_.find(std::type_index(typeid(EventT)));
+        if (it == subscribers_.end()) {
+            return;
+        }
+        for (const auto& entry : it->second) {
+            if (entry.active) {
+                entry.handler(&event);
+            }
+        }
+    }
+
+private:
+    struct SubscriberEntry {
+        std::size_t id;
+        bool active;
+        std::function<void(const void*)> handler;
+    };
+
+    std::unordered_map<std::type_index, std::vector<SubscriberEntry>> subscribers_;
+    std::size_t next_id_ = 0;
+};
+
+// What a typical frame handler touches: a little state on its owner.
+struct Counter {
+    float total = 0.0f;
+    std::size_t last_index = 0;
+
+    void on_event(const BenchEvent& event) {
+        total += event.value;
+        last_index = event.index;
+    }
+};
+
+template<typename Publish>
+double ns_per_publish(Publish&& publish) {
+    double best_ns = 0.0;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < kPublishes; ++i) {
+            publish(BenchEvent{1.0f, i});
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(kPublishes);
+        best_ns = repeat == 0 ? ns : std::min(best_ns, ns);
+    }
+    return best_ns;
+}
+
+} // namespace
+} // namespace bench
+
+int main() {
+    using bench::BenchEvent;
+    using bench::Counter;
+
+    std::vector<Counter> legacy_counters(bench::kSubscribers);
+    bench::LegacyEventBus legacy_bus;
+    for (Counter& counter : legacy_counters) {
+        legacy_bus.subscribe<BenchEvent>([&counter](const BenchEvent& event) { counter.on_event(event); });
+    }
+
+    std::vector<Counter> counters(bench::kSubscribers);
+    why::events::EventBus bus;
+    std::vector<why::events::EventBus::SubscriptionHandle> handles;
+    for (Counter& counter : counters) {
+        Counter* target = &counter;
+        handles.push_back(bus.subscribe<BenchEvent>([target](const BenchEvent& event) { target->on_event(event); }));
+    }
+
+    const double legacy_ns = bench::ns_per_publish([&](const BenchEvent& event) { legacy_bus.publish(event); });
+    const double dense_ns = bench::ns_per_publish([&](const BenchEvent& event) { bus.publish(event); });
+
+    float checksum = 0.0f;
+    for (std::size_t i = 0; i < bench::kSubscribers; ++i) {
+        checksum += legacy_counters[i].total - counters[i].total;
+    }
+
+    std::printf("%-36s %12s %16s\n", "dispatch (8 subscribers)", "ns/publish", "ns/subscriber");
+    std::printf("%-36s %12.1f %16.2f\n", "type_index map + std::function", legacy_ns, legacy_ns / bench::kSubscribers);
+    std::printf("%-36s %12.1f %16.2f\n", "dense slot + InlineDelegate", dense_ns, dense_ns / bench::kSubscribers);
+    if (checksum != 0.0f) {
+        std::fprintf(stderr, "[bench] the two buses delivered different events\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Stand-in for the handful of notcurses calls CellPainter makes, for
+// bench/cell_painter_bench.cpp. The definitions count calls and copy what is written into
+// an in-memory plane so the two drawing paths can be compared call for call.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ncplane;
+
+int ncplane_set_fg_rgb(struct ncplane* n, uint32_t channel);
+int ncplane_set_bg_rgb(struct ncplane* n, uint32_t channel);
+int ncplane_putstr_yx(struct ncplane* n, int y, int x, const char* gclusters);
+int ncstrwidth(const char* egcs, int* validbytes, int* validwidth);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,271 @@
+#include "analysis_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <miniaudio.h>
+
+#include "dsp.h"
+
+namespace why {
+
+namespace {
+
+constexpr char kMagic[8] = {'W', 'H', 'Y', 'A', 'N', 'L', 'Y', 'S'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::size_t kTrailingFloats = 3; // beat strength, rms, onset
+constexpr std::uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+
+struct AnalysisCacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t sample_rate;
+    std::uint32_t fft_size;
+    std::uint32_t hop_size;
+    std::uint32_t bands;
+    std::uint32_t record_floats;
+    std::uint64_t key;
+    std::uint64_t hop_count;
+    std::uint64_t total_frames;
+};
+
+static_assert(sizeof(AnalysisCacheHeader) % alignof(float) == 0, "Records must stay float aligned");
+
+std::uint64_t fnv1a(std::uint64_t hash, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+template<typename T>
+std::uint64_t fnv1a_value(std::uint64_t hash, T value) {
+    return fnv1a(hash, &value, sizeof(value));
+}
+
+std::string cache_path_for(const std::string& track_path, const std::string& cache_directory, std::uint64_t key) {
+    const std::filesystem::path track(track_path);
+    std::filesystem::path directory = cache_directory.empty() ? track.parent_path()
+                                                              : std::filesystem::path(cache_directory);
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), "-%016llx.whya", static_cast<unsigned long long>(key));
+    return (directory / (track.stem().string() + suffix)).string();
+}
+
+bool run_analysis_pass(const std::string& track_path,
+                       const AnalysisSettings& settings,
+                       std::uint64_t key,
+                       const std::string& out_path,
+                       std::string& error,
+                       const std::atomic<bool>* cancel) {
+    ma_decoder_config decoder_config = ma_decoder_config_init(ma_format_f32, 1, settings.sample_rate);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(track_path.c_str(), &decoder_config, &decoder) != MA_SUCCESS) {
+        error = "failed to decode '" + track_path + "'";
+        return false;
+    }
+
+    DspEngine dsp(settings.sample_rate,
+                  1,
+                  settings.fft_size,
+                  settings.hop_size,
+                  settings.bands,
+                  settings.specialized_kernels,
+                  settings.zero_pad_factor);
+
+    const std::size_t record_floats = settings.bands + kTrailingFloats;
+    std::vector<float> records;
+    std::vector<float> hop_buffer(settings.hop_size);
+    std::uint64_t total_frames = 0;
+
+    while (true) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            ma_decoder_uninit(&decoder);
+            error = "analysis cancelled";
+            return false;
+        }
+
+        ma_uint64 frames_read = 0;
+        const ma_result result = ma_decoder_read_pcm_frames(&decoder, hop_buffer.data(), hop_buffer.size(), &frames_read);
+        total_frames += frames_read;
+        if (result != MA_SUCCESS || frames_read < hop_buffer.size()) {
+            break;
+        }
+
+        // Exactly one hop per push, so the engine analyses exactly one frame.
+        dsp.push_samples(hop_buffer.data(), hop_buffer.size());
+
+        double sum_squares = 0.0;
+        for (float sample : hop_buffer) {
+            sum_squares += static_cast<double>(sample) * static_cast<double>(sample);
+        }
+
+        const std::vector<float>& bands = dsp.band_energies();
+        records.insert(records.end(), bands.begin(), bands.end());
+        records.push_back(dsp.beat_strength());
+        records.push_back(static_cast<float>(std::sqrt(sum_squares / static_cast<double>(hop_buffer.size()))));
+        records.push_back(dsp.onset() ? 1.0f : 0.0f);
+    }
+    ma_decoder_uninit(&decoder);
+
+    if (records.empty()) {
+        error = "track '" + track_path + "' is shorter than one hop";
+        return false;
+    }
+
+    AnalysisCacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.sample_rate = settings.sample_rate;
+    header.fft_size = static_cast<std::uint32_t>(settings.fft_size);
+    header.hop_size = static_cast<std::uint32_t>(settings.hop_size);
+    header.bands = static_cast<std::uint32_t>(settings.bands);
+    header.record_floats = static_cast<std::uint32_t>(record_floats);
+    header.key = key;
+    header.hop_count = records.size() / record_floats;
+    header.total_frames = total_frames;
+
+    std::error_code ec;
+    const std::filesystem::path target(out_path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+
+    // Write next to the destination and rename so readers never map a partial file.
+    const std::string temp_path = out_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "cannot write '" + temp_path + "'";
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(float)));
+        if (!out) {
+            error = "failed writing '" + temp_path + "'";
+            return false;
+        }
+    }
+    std::filesystem::rename(temp_path, target, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        error = "cannot move analysis cache into '" + out_path + "'";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool AnalysisCache::open(const std::string& path, std::uint64_t expected_key, const AnalysisSettings& settings) {
+    records_ = nullptr;
+    if (!file_.open(path) || file_.size() < sizeof(AnalysisCacheHeader)) {
+        return false;
+    }
+
+    AnalysisCacheHeader header{};
+    std::memcpy(&header, file_.data(), sizeof(header));
+    const std::size_t record_floats = settings.bands + kTrailingFloats;
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kFormatVersion ||
+        header.key != expected_key ||
+        header.sample_rate != settings.sample_rate ||
+        header.fft_size != settings.fft_size ||
+        header.hop_size != settings.hop_size ||
+        header.bands != settings.bands ||
+        header.record_floats != record_floats ||
+        header.hop_count == 0) {
+        file_.close();
+        return false;
+    }
+
+    const std::size_t payload = file_.size() - sizeof(AnalysisCacheHeader);
+    if (payload / sizeof(float) / record_floats < header.hop_count) {
+        file_.close();
+        return false;
+    }
+
+    records_ = reinterpret_cast<const float*>(file_.data() + sizeof(AnalysisCacheHeader));
+    record_floats_ = record_floats;
+    hop_count_ = static_cast<std::size_t>(header.hop_count);
+    band_count_ = settings.bands;
+    hop_size_ = settings.hop_size;
+    total_frames_ = std::max<std::uint64_t>(header.total_frames, header.hop_count * header.hop_size);
+    return true;
+}
+
+std::size_t AnalysisCache::hop_for_frame(std::uint64_t frame_position) const {
+    if (hop_count_ == 0 || hop_size_ == 0) {
+        return 0;
+    }
+    const std::uint64_t position = total_frames_ > 0 ? frame_position % total_frames_ : frame_position;
+    const std::uint64_t completed_hops = position / hop_size_;
+    return completed_hops == 0 ? 0 : static_cast<std::size_t>(completed_hops - 1);
+}
+
+AnalysisHop AnalysisCache::hop(std::size_t index) const {
+    AnalysisHop result;
+    if (!records_) {
+        return result;
+    }
+    const std::size_t clamped = std::min(index, hop_count_ - 1);
+    const float* record = records_ + clamped * record_floats_;
+    result.bands = record;
+    result.beat_strength = record[band_count_];
+    result.rms = record[band_count_ + 1];
+    result.onset = record[band_count_ + 2] > 0.5f;
+    return result;
+}
+
+std::uint64_t analysis_cache_key(const MappedFile& track, const AnalysisSettings& settings) {
+    std::uint64_t hash = fnv1a(kFnvOffset, track.data(), track.size());
+    hash = fnv1a_value(hash, kFormatVersion);
+    hash = fnv1a_value(hash, settings.sample_rate);
+    hash = fnv1a_value(hash, static_cast<std::uint64_t>(settings.fft_size));
+    hash = fnv1a_value(hash, static_cast<std::uint64_t>(settings.hop_size));
+    hash = fnv1a_value(hash, static_cast<std::uint64_t>(settings.bands));
+    hash = fnv1a_value(hash, static_cast<std::uint64_t>(settings.zero_pad_factor));
+    return hash;
+}
+
+bool load_or_build_analysis_cache(const std::string& track_path,
+                                  const std::string& cache_directory,
+                                  const AnalysisSettings& settings,
+                                  AnalysisCache& cache,
+                                  std::string& error,
+                                  const std::atomic<bool>* cancel) {
+    std::uint64_t key = 0;
+    {
+        MappedFile track;
+        if (!track.open(track_path)) {
+            error = "cannot read '" + track_path + "'";
+            return false;
+        }
+        key = analysis_cache_key(track, settings);
+    }
+
+    const std::string path = cache_path_for(track_path, cache_directory, key);
+    if (cache.open(path, key, settings)) {
+        return true;
+    }
+    if (!run_analysis_pass(track_path, settings, key, path, error, cancel)) {
+        return false;
+    }
+    if (!cache.open(path, key, settings)) {
+        error = "analysis cache '" + path + "' is unreadable after writing";
+        return false;
+    }
+    return true;
+}
+
+} // namespace why
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.h"
+
+namespace why {
+
+// DSP parameters that determine the cached analysis; any change invalidates the cache.
+struct AnalysisSettings {
+    std::uint32_t sample_rate = 48000;
+    std::size_t fft_size = 1024;
+    std::size_t hop_size = 256;
+    std::size_t bands = 32;
+    bool specialized_kernels = true;
+    std::size_t zero_pad_factor = 1;
+
+    bool operator==(const AnalysisSettings&) const = default;
+};
+
+// One analysed hop as stored in the sidecar file.
+struct AnalysisHop {
+    const float* bands = nullptr;
+    float beat_strength = 0.0f;
+    float rms = 0.0f;
+    bool onset = false;
+};
+
+// Whole-track analysis produced by an offline DspEngine pass and read back through a
+// memory mapping. The file is a fixed header followed by one record per hop:
+// `bands` smoothed band energies, then beat strength, RMS and an onset flag (all float32).
+class AnalysisCache {
+public:
+    bool open(const std::string& path, std::uint64_t expected_key, const AnalysisSettings& settings);
+
+    bool is_open() const { return records_ != nullptr; }
+    std::size_t hop_count() const { return hop_count_; }
+    std::size_t band_count() const { return band_count_; }
+    std::size_t hop_size() const { return hop_size_; }
+    std::uint64_t total_frames() const { return total_frames_; }
+
+    // Hop whose analysis matches what a live DspEngine would report after consuming
+    // `frame_position` frames; positions past the end wrap, as file playback loops.
+    std::size_t hop_for_frame(std::uint64_t frame_position) const;
+
+    // Index is clamped to the track, so callers may look ahead freely.
+    AnalysisHop hop(std::size_t index) const;
+
+private:
+    MappedFile file_;
+    const float* records_ = nullptr;
+    std::size_t record_floats_ = 0;
+    std::size_t hop_count_ = 0;
+    std::size_t band_count_ = 0;
+    std::size_t hop_size_ = 0;
+    std::uint64_t total_frames_ = 0;
+};
+
+// Hash of the track contents and the analysis settings.
+std::uint64_t analysis_cache_key(const MappedFile& track, const AnalysisSettings& settings);
+
+// Opens the sidecar for `track_path` from `cache_directory`, running the analysis pre-pass
+// and writing the sidecar first when it is missing or stale. Setting `cancel` abandons the
+// pre-pass without writing anything.
+bool load_or_build_analysis_cache(const std::string& track_path,
+                                  const std::string& cache_directory,
+                                  const AnalysisSettings& settings,
+                                  AnalysisCache& cache,
+                                  std::string& error,
+                                  const std::atomic<bool>* cancel = nullptr);
+
+} // namespace why
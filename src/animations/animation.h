@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -8,6 +12,7 @@
 #include "../audio_engine.h"
 #include "../config.h" // Include AppConfig
 #include "../events/event_bus.h"
+#include "../events/frame_events.h"
 
 namespace why {
 namespace animations {
@@ -36,11 +41,108 @@ public:
     virtual int get_z_index() const = 0;
     virtual ncplane* get_plane() const = 0; // Or a way to get the primary plane
 
+    // Band indices update() reads, or std::nullopt when it needs the whole spectrum. The
+    // configured trigger band is added by the manager, so only extra bands belong here.
+    virtual std::optional<std::vector<std::size_t>> required_bands() const { return std::nullopt; }
+
+    // Whether update() only touches this animation's own state (reading its plane's size is
+    // fine), so it may run on a worker thread alongside other animations' updates.
+    virtual bool supports_parallel_update() const { return false; }
+
+    // Whether init() reads [dsp] (beyond the animation's own entry), so a config reload
+    // that changes it has to create the animation again.
+    virtual bool depends_on_dsp_config() const { return false; }
+
+    // Adaptive quality. Level 0 is the configured look; each level above it trades detail
+    // for time (fewer particles, no glow, ...). quality_levels() is the highest level the
+    // animation implements; set_quality() is only called with 0..quality_levels().
+    virtual int quality_levels() const { return 0; }
+    virtual void set_quality(int level) { (void)level; }
+
+    // Event handlers call this instead of update(). Normally it updates right away; once
+    // the manager enables deferral the call is recorded and run by run_deferred_update()
+    // during the manager's parallel update phase. The referenced metrics and bands must
+    // stay valid until then (they belong to the audio sources for the whole frame).
+    //
+    // With an update stride above 1 only every stride-th call gets through, carrying the
+    // time of the calls skipped before it.
+    void request_update(float delta_time,
+                        const AudioMetrics& metrics,
+                        const std::vector<float>& bands,
+                        float beat_strength) {
+        if (update_stride_ > 1u) {
+            skipped_delta_time_ += delta_time;
+            if (++update_phase_ < update_stride_) {
+                return;
+            }
+            delta_time = skipped_delta_time_;
+            skipped_delta_time_ = 0.0f;
+            update_phase_ = 0u;
+        }
+        if (!defer_updates_) {
+            timed_update(delta_time, metrics, bands, beat_strength);
+            return;
+        }
+        if (deferred_.pending) {
+            run_deferred_update();
+        }
+        deferred_ = DeferredUpdate{true, delta_time, &metrics, &bands, beat_strength};
+    }
+
+    void set_defer_updates(bool defer) { defer_updates_ = defer; }
+    bool has_deferred_update() const { return deferred_.pending; }
+
+    // Runs the recorded update, if any; skipped when the animation was deactivated since.
+    void run_deferred_update() {
+        if (!deferred_.pending) {
+            return;
+        }
+        deferred_.pending = false;
+        if (is_active()) {
+            timed_update(deferred_.delta_time, *deferred_.metrics, *deferred_.bands, deferred_.beat_strength);
+        }
+    }
+
+    // Lets only every `stride`-th update request through (1 updates every frame).
+    void set_update_stride(unsigned int stride) {
+        update_stride_ = std::max(1u, stride);
+        update_phase_ = 0u;
+    }
+
+    // While on, time spent in update() adds up until take_update_time() collects it.
+    void set_track_update_time(bool track) { track_update_time_ = track; }
+    std::chrono::steady_clock::duration take_update_time() { return std::exchange(update_time_, {}); }
+
     virtual void bind_events(const AnimationConfig& config, events::EventBus& bus) {
         (void)config;
         (void)bus;
     }
 
+    // Lays the plane out again for a std_rows x std_cols standard plane, resizes it and
+    // carries the animation's state over. Delivered through ResizeEvent, so planes are
+    // only measured when the terminal actually changed size.
+    virtual void on_resize(unsigned int std_rows, unsigned int std_cols) {
+        (void)std_rows;
+        (void)std_cols;
+    }
+
+    // The manager binds every animation's on_resize() to ResizeEvent.
+    void bind_resize_events(events::EventBus& bus) {
+        track_subscription(bus.subscribe<events::ResizeEvent>(
+            [this](const events::ResizeEvent& event) { on_resize(event.rows, event.cols); }));
+    }
+
+    // Damage tracking. Animations that opt in mark what their updates change; the manager
+    // skips render() while nothing is damaged and clears the damage after each render.
+    // Others are rendered every frame as before.
+    virtual bool tracks_damage() const { return false; }
+    bool needs_render() const { return !tracks_damage() || damage_full_ || !damaged_rows_.empty(); }
+    void mark_dirty() { damage_full_ = true; }
+    void clear_damage() {
+        damage_full_ = false;
+        damaged_rows_.clear();
+    }
+
     void clear_event_subscriptions() {
         for (auto& handle : event_subscriptions_) {
             handle.reset();
@@ -49,12 +151,83 @@ public:
     }
 
 protected:
+    // Plane rows [begin, end).
+    struct RowSpan {
+        unsigned int begin;
+        unsigned int end;
+    };
+
     void track_subscription(events::EventBus::SubscriptionHandle handle) {
         event_subscriptions_.push_back(std::move(handle));
     }
 
+    void mark_row_dirty(unsigned int row) { mark_rows_dirty(row, row + 1u); }
+
+    void mark_rows_dirty(unsigned int begin, unsigned int end) {
+        if (damage_full_ || begin >= end) {
+            return;
+        }
+        // Kept sorted and disjoint; touching spans are merged.
+        auto it = std::lower_bound(damaged_rows_.begin(), damaged_rows_.end(), begin,
+                                   [](const RowSpan& span, unsigned int row) { return span.end < row; });
+        auto last = it;
+        while (last != damaged_rows_.end() && last->begin <= end) {
+            begin = std::min(begin, last->begin);
+            end = std::max(end, last->end);
+            ++last;
+        }
+        it = damaged_rows_.erase(it, last);
+        damaged_rows_.insert(it, RowSpan{begin, end});
+    }
+
+    // When true the whole plane has to be repainted and damaged_rows() is meaningless.
+    bool fully_damaged() const { return damage_full_; }
+    const std::vector<RowSpan>& damaged_rows() const { return damaged_rows_; }
+
+    // Erases whatever render() is about to repaint: every damaged row, or the whole plane.
+    void erase_damage(ncplane* plane) const {
+        if (damage_full_) {
+            ncplane_erase(plane);
+            return;
+        }
+        for (const RowSpan& span : damaged_rows_) {
+            ncplane_erase_region(plane, static_cast<int>(span.begin), 0,
+                                 static_cast<int>(span.end - span.begin), 0);
+        }
+    }
+
 private:
+    void timed_update(float delta_time,
+                      const AudioMetrics& metrics,
+                      const std::vector<float>& bands,
+                      float beat_strength) {
+        if (!track_update_time_) {
+            update(delta_time, metrics, bands, beat_strength);
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        update(delta_time, metrics, bands, beat_strength);
+        update_time_ += std::chrono::steady_clock::now() - start;
+    }
+
+    struct DeferredUpdate {
+        bool pending = false;
+        float delta_time = 0.0f;
+        const AudioMetrics* metrics = nullptr;
+        const std::vector<float>* bands = nullptr;
+        float beat_strength = 0.0f;
+    };
+
     std::vector<events::EventBus::SubscriptionHandle> event_subscriptions_;
+    DeferredUpdate deferred_;
+    bool defer_updates_ = false;
+    unsigned int update_stride_ = 1u;
+    unsigned int update_phase_ = 0u;
+    float skipped_delta_time_ = 0.0f;
+    bool track_update_time_ = false;
+    std::chrono::steady_clock::duration update_time_{}; // Only written by whoever runs update()
+    bool damage_full_ = true;
+    std::vector<RowSpan> damaged_rows_;
 
     template<typename AnimationT>
     friend void bind_standard_frame_updates(AnimationT* animation,
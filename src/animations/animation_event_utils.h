@@ -8,6 +8,37 @@
 namespace why {
 namespace animations {
 
+// Animations without a `source` follow the primary (first) audio source.
+inline bool matches_source(const std::string& wanted_source,
+                           const std::string& source_id,
+                           std::size_t source_index) {
+    if (wanted_source.empty()) {
+        return source_index == 0;
+    }
+    return wanted_source == source_id;
+}
+
+// Whether an event for the given source and analysis profile is meant for this animation.
+inline bool matches_analysis(const AnimationConfig& config,
+                             const std::string& source_id,
+                             std::size_t source_index,
+                             const std::string& profile) {
+    return config.analysis_profile == profile && matches_source(config.source, source_id, source_index);
+}
+
+// The band stream an animation reads: the full mix, or with dsp.hpss its harmonic or
+// percussive part.
+inline const std::vector<float>& select_bands(const AnimationConfig& config,
+                                              const events::FrameUpdateEvent& event) {
+    if (config.band_stream == "harmonic" && !event.harmonic_bands.empty()) {
+        return event.harmonic_bands;
+    }
+    if (config.band_stream == "percussive" && !event.percussive_bands.empty()) {
+        return event.percussive_bands;
+    }
+    return event.bands;
+}
+
 inline bool has_custom_triggers(const AnimationConfig& config) {
     return config.trigger_band_index != -1 ||
            config.trigger_beat_min > 0.0f ||
@@ -41,10 +72,17 @@ template<typename AnimationT>
 void bind_standard_frame_updates(AnimationT* animation,
                                  const AnimationConfig& config,
                                  events::EventBus& bus) {
-    AnimationConfig captured_config = config;
+    // `config` is owned by the AnimationManager entry and outlives the subscription.
+    const AnimationConfig* config_ptr = &config;
     auto handle = bus.subscribe<events::FrameUpdateEvent>(
-        [animation, captured_config](const events::FrameUpdateEvent& event) {
-            const bool meets_band = evaluate_band_condition(captured_config, event.bands);
+        [animation, config_ptr](const events::FrameUpdateEvent& event) {
+            const AnimationConfig& captured_config = *config_ptr;
+            if (!matches_analysis(captured_config, event.source_id, event.source_index, event.profile)) {
+                return;
+            }
+
+            const std::vector<float>& bands = select_bands(captured_config, event);
+            const bool meets_band = evaluate_band_condition(captured_config, bands);
             const bool meets_beat = evaluate_beat_condition(captured_config, event.beat_strength);
             const bool should_be_active = has_custom_triggers(captured_config)
                                               ? (meets_band && meets_beat)
@@ -57,10 +95,10 @@ void bind_standard_frame_updates(AnimationT* animation,
             }
 
             if (animation->is_active()) {
-                animation->update(event.delta_time,
-                                  event.metrics,
-                                  event.bands,
-                                  event.beat_strength);
+                animation->request_update(event.delta_time,
+                                          event.metrics,
+                                          bands,
+                                          event.beat_strength);
             }
         });
     animation->track_subscription(std::move(handle));
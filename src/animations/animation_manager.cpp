@@ -1,7 +1,9 @@
 #include "animation_manager.h"
 
 #include <iostream>
+#include <string>
 
+#include "animation_event_utils.h"
 #include "random_text_animation.h"
 #include "bar_visual_animation.h"
 #include "ascii_matrix_animation.h"
@@ -15,74 +17,425 @@
 namespace why {
 namespace animations {
 
+namespace {
+constexpr std::uint32_t kGovernorWindowFrames = 30;
+constexpr std::uint32_t kMaxOverrunsPerWindow = 3;
+constexpr std::uint32_t kCalmWindowsBeforeRaise = 4;
+constexpr int kStrideLevels = 2; // Past an animation's own levels: update every 2nd, then 3rd frame
+} // namespace
+
 void AnimationManager::load_animations(notcurses* nc, const AppConfig& app_config) {
     event_bus_.reset();
     animations_.clear();
+    lowered_.clear();
+    needs_restack_ = true;
     animations_.reserve(app_config.animations.size());
 
-    for (const auto& anim_config : app_config.animations) {
-        std::unique_ptr<Animation> new_animation;
-        std::string cleaned_type = config::detail::sanitize_string_value(anim_config.type);
-
-        if (cleaned_type == "RandomText") {
-            new_animation = std::make_unique<RandomTextAnimation>();
-        } else if (cleaned_type == "BarVisual") {
-            new_animation = std::make_unique<BarVisualAnimation>();
-        } else if (cleaned_type == "AsciiMatrix") {
-            new_animation = std::make_unique<AsciiMatrixAnimation>();
-        } else if (cleaned_type == "CyberRain") {
-            new_animation = std::make_unique<CyberRainAnimation>();
-        } else if (cleaned_type == "LightningWave") {
-            new_animation = std::make_unique<LightningWaveAnimation>();
-        } else if (cleaned_type == "Breathe") {
-            new_animation = std::make_unique<BreatheAnimation>();
-        } else if (cleaned_type == "Logging") {
-            new_animation = std::make_unique<LoggingAnimation>();
-        }
-
-        if (new_animation) {
-            new_animation->init(nc, app_config);
-            new_animation->clear_event_subscriptions();
-
-            auto managed = std::make_unique<ManagedAnimation>();
-            managed->config = anim_config;
-            managed->animation = std::move(new_animation);
-
-            managed->animation->bind_events(managed->config, event_bus_);
+    for (std::size_t config_index = 0; config_index < app_config.animations.size(); ++config_index) {
+        if (auto managed = create_animation(nc, app_config, config_index)) {
             animations_.push_back(std::move(managed));
-        } else {
-            // std::cerr << "[AnimationManager::load_animations] Unknown animation type: " << anim_config.type << std::endl;
         }
     }
 }
 
-void AnimationManager::update_all(float delta_time,
-                                  const AudioMetrics& metrics,
-                                  const std::vector<float>& bands,
-                                  float beat_strength) {
-    events::BeatDetectedEvent beat_event{beat_strength};
-    event_bus_.publish(beat_event);
+std::size_t AnimationManager::reload_animations(notcurses* nc, const AppConfig& before, const AppConfig& after) {
+    const bool dsp_changed = before.dsp != after.dsp;
+    // init() reads the first [[animations]] entry of its type, whichever entry created it.
+    const auto first_of_type = [](const AppConfig& config, const std::string& type) -> const AnimationConfig* {
+        for (const AnimationConfig& anim_config : config.animations) {
+            if (anim_config.type == type) {
+                return &anim_config;
+            }
+        }
+        return nullptr;
+    };
+    const auto unchanged = [&](const ManagedAnimation& managed) {
+        const std::size_t index = managed.config_index;
+        if (index >= after.animations.size() || managed.config != after.animations[index]) {
+            return false;
+        }
+        const AnimationConfig* old_first = first_of_type(before, managed.config.type);
+        const AnimationConfig* new_first = first_of_type(after, managed.config.type);
+        if (!old_first || !new_first || *old_first != *new_first) {
+            return false;
+        }
+        return !(dsp_changed && managed.animation->depends_on_dsp_config());
+    };
+
+    std::vector<std::unique_ptr<ManagedAnimation>> previous;
+    previous.swap(animations_);
+    animations_.reserve(after.animations.size());
+    std::size_t rebuilt = 0;
+    for (std::size_t config_index = 0; config_index < after.animations.size(); ++config_index) {
+        auto kept = std::find_if(previous.begin(), previous.end(), [&](const auto& managed) {
+            return managed && managed->config_index == config_index && unchanged(*managed);
+        });
+        if (kept != previous.end()) {
+            animations_.push_back(std::move(*kept));
+            continue;
+        }
+        if (auto managed = create_animation(nc, after, config_index)) {
+            animations_.push_back(std::move(managed));
+            ++rebuilt;
+        }
+    }
+
+    // Whatever is left in `previous` is destroyed below, planes and subscriptions with it.
+    lowered_.erase(std::remove_if(lowered_.begin(),
+                                  lowered_.end(),
+                                  [this](const ManagedAnimation* managed) {
+                                      return std::none_of(animations_.begin(),
+                                                          animations_.end(),
+                                                          [managed](const auto& kept) { return kept.get() == managed; });
+                                  }),
+                   lowered_.end());
+    needs_restack_ = true;
+    return rebuilt;
+}
 
-    events::FrameUpdateEvent frame_event{delta_time, metrics, bands, beat_strength};
-    event_bus_.publish(frame_event);
+void AnimationManager::clear() {
+    deferred_updates_.clear();
+    lowered_.clear();
+    animations_.clear();
+    needs_restack_ = true;
 }
 
-void AnimationManager::render_all(notcurses* nc) {
-    std::sort(animations_.begin(), animations_.end(), [](const auto& a, const auto& b) {
-        return a->animation->get_z_index() < b->animation->get_z_index();
+std::unique_ptr<AnimationManager::ManagedAnimation> AnimationManager::create_animation(notcurses* nc,
+                                                                                       const AppConfig& app_config,
+                                                                                       std::size_t config_index) {
+    const AnimationConfig& anim_config = app_config.animations[config_index];
+    std::unique_ptr<Animation> new_animation;
+    std::string cleaned_type = config::detail::sanitize_string_value(anim_config.type);
+
+    if (cleaned_type == "RandomText") {
+        new_animation = std::make_unique<RandomTextAnimation>();
+    } else if (cleaned_type == "BarVisual") {
+        new_animation = std::make_unique<BarVisualAnimation>();
+    } else if (cleaned_type == "AsciiMatrix") {
+        new_animation = std::make_unique<AsciiMatrixAnimation>();
+    } else if (cleaned_type == "CyberRain") {
+        new_animation = std::make_unique<CyberRainAnimation>();
+    } else if (cleaned_type == "LightningWave") {
+        new_animation = std::make_unique<LightningWaveAnimation>();
+    } else if (cleaned_type == "Breathe") {
+        new_animation = std::make_unique<BreatheAnimation>();
+    } else if (cleaned_type == "Logging") {
+        new_animation = std::make_unique<LoggingAnimation>();
+    }
+
+    if (!new_animation) {
+        // std::cerr << "[AnimationManager::load_animations] Unknown animation type: " << anim_config.type << std::endl;
+        return nullptr;
+    }
+
+    new_animation->init(nc, app_config);
+    new_animation->clear_event_subscriptions();
+
+    auto managed = std::make_unique<ManagedAnimation>();
+    managed->config = anim_config;
+    managed->animation = std::move(new_animation);
+    managed->config_index = config_index;
+    managed->z_index = managed->animation->get_z_index();
+    managed->label = cleaned_type + "#" + std::to_string(config_index);
+    managed->animation->set_track_update_time(frame_budget_.count() > 0);
+
+    if (profiler_) {
+        managed->update_probe = profiler_->probe(managed->label + " update");
+        managed->render_probe = profiler_->probe(managed->label + " render");
+        event_bus_.set_subscriber_label(managed->label);
+    }
+    managed->animation->bind_events(managed->config, event_bus_);
+    managed->animation->bind_resize_events(event_bus_);
+    event_bus_.set_subscriber_label({});
+    managed->animation->set_defer_updates(worker_pool_ && managed->animation->supports_parallel_update());
+    return managed;
+}
+
+void AnimationManager::update_all(float delta_time, const std::vector<std::unique_ptr<AudioSource>>& sources) {
+    ProfileScope scope(profiler_, update_all_probe_);
+
+    // Events posted from the analysis threads (e.g. PitchEvent) are delivered first, so
+    // animations see them before this frame's updates.
+    event_bus_.dispatch_deferred();
+
+    for (std::size_t index = 0; index < sources.size(); ++index) {
+        const AudioSource& source = *sources[index];
+        for (std::size_t profile = 0; profile < source.profile_count(); ++profile) {
+            if (!source.profile_subscribed(profile)) {
+                continue;
+            }
+            events::BeatDetectedEvent beat_event{source.profile_beat_strength(profile),
+                                                 source.id(),
+                                                 index,
+                                                 source.profile_name(profile)};
+            event_bus_.publish(beat_event);
+        }
+    }
+
+    for (std::size_t index = 0; index < sources.size(); ++index) {
+        const AudioSource& source = *sources[index];
+        for (std::size_t profile = 0; profile < source.profile_count(); ++profile) {
+            if (!source.profile_subscribed(profile)) {
+                continue;
+            }
+            events::FrameUpdateEvent frame_event{delta_time,
+                                                 source.metrics(),
+                                                 source.profile_bands(profile),
+                                                 source.profile_harmonic_bands(profile),
+                                                 source.profile_percussive_bands(profile),
+                                                 source.profile_beat_strength(profile),
+                                                 source.id(),
+                                                 index,
+                                                 source.profile_name(profile),
+                                                 profile == 0 ? source.analysis() : nullptr,
+                                                 source.analysis_hop()};
+            event_bus_.publish(frame_event);
+        }
+    }
+
+    if (!worker_pool_) {
+        return;
+    }
+    deferred_updates_.clear();
+    for (const auto& managed_anim : animations_) {
+        if (managed_anim->animation->has_deferred_update()) {
+            deferred_updates_.push_back(managed_anim.get());
+        }
+    }
+    if (!profiler_) {
+        worker_pool_->parallel_for(deferred_updates_.size(), [this](std::size_t index) {
+            deferred_updates_[index]->animation->run_deferred_update();
+        });
+        return;
+    }
+
+    // The profiler belongs to this thread; workers only fill in their own slot.
+    deferred_timings_.assign(deferred_updates_.size(), Profiler::Clock::duration::zero());
+    worker_pool_->parallel_for(deferred_updates_.size(), [this](std::size_t index) {
+        const auto start = Profiler::Clock::now();
+        deferred_updates_[index]->animation->run_deferred_update();
+        deferred_timings_[index] = Profiler::Clock::now() - start;
+    });
+    for (std::size_t index = 0; index < deferred_updates_.size(); ++index) {
+        profiler_->record(deferred_updates_[index]->update_probe, deferred_timings_[index]);
+    }
+}
+
+void AnimationManager::resize(unsigned int std_rows, unsigned int std_cols) {
+    event_bus_.publish(events::ResizeEvent{std_rows, std_cols});
+}
+
+void AnimationManager::set_profiler(Profiler* profiler) {
+    profiler_ = profiler;
+    event_bus_.set_profiler(profiler);
+    if (profiler_) {
+        update_all_probe_ = profiler_->probe("AnimationManager::update_all");
+        render_all_probe_ = profiler_->probe("AnimationManager::render_all");
+    }
+}
+
+void AnimationManager::set_worker_pool(WorkerPool* pool) {
+    worker_pool_ = pool;
+    for (const auto& managed_anim : animations_) {
+        managed_anim->animation->set_defer_updates(pool && managed_anim->animation->supports_parallel_update());
+    }
+}
+
+bool AnimationManager::has_subscribers(const std::string& source_id,
+                                       std::size_t source_index,
+                                       const std::string& profile) const {
+    return std::any_of(animations_.begin(), animations_.end(), [&](const auto& managed_anim) {
+        return matches_analysis(managed_anim->config, source_id, source_index, profile);
+    });
+}
+
+std::optional<std::vector<std::size_t>> AnimationManager::required_bands(const std::string& source_id,
+                                                                          std::size_t source_index,
+                                                                          const std::string& profile) const {
+    std::vector<std::size_t> bands;
+    for (const auto& managed_anim : animations_) {
+        if (!matches_analysis(managed_anim->config, source_id, source_index, profile)) {
+            continue;
+        }
+        auto animation_bands = managed_anim->animation->required_bands();
+        if (!animation_bands.has_value()) {
+            return std::nullopt;
+        }
+        bands.insert(bands.end(), animation_bands->begin(), animation_bands->end());
+        if (managed_anim->config.trigger_band_index >= 0) {
+            bands.push_back(static_cast<std::size_t>(managed_anim->config.trigger_band_index));
+        }
+    }
+    return bands;
+}
+
+void AnimationManager::sync_plane_visibility(ncplane* stdplane) {
+    for (const auto& managed_anim : animations_) {
+        const int z_index = managed_anim->animation->get_z_index();
+        if (z_index != managed_anim->z_index) {
+            managed_anim->z_index = z_index;
+            needs_restack_ = true;
+        }
+
+        ncplane* plane = managed_anim->animation->get_plane();
+        const bool visible = managed_anim->animation->is_active();
+        if (!plane || visible != managed_anim->parked) {
+            continue;
+        }
+        if (visible) {
+            // Rejoins the pile on top, so the stacking order has to be rebuilt.
+            ncplane_reparent_family(plane, stdplane);
+            managed_anim->animation->mark_dirty();
+            needs_restack_ = true;
+        } else {
+            // A plane reparented to itself becomes the root of its own pile, which
+            // notcurses_render() never composites.
+            ncplane_reparent_family(plane, plane);
+        }
+        managed_anim->parked = !visible;
+    }
+}
+
+void AnimationManager::restack() {
+    std::stable_sort(animations_.begin(), animations_.end(), [](const auto& a, const auto& b) {
+        return a->z_index < b->z_index;
     });
 
     for (const auto& managed_anim : animations_) {
-        if (auto* plane = managed_anim->animation->get_plane()) {
+        ncplane* plane = managed_anim->animation->get_plane();
+        if (plane && !managed_anim->parked) {
             ncplane_move_bottom(plane);
         }
     }
+    needs_restack_ = false;
+}
+
+void AnimationManager::render_all(notcurses* nc) {
+    ProfileScope scope(profiler_, render_all_probe_);
+
+    sync_plane_visibility(notcurses_stdplane(nc));
+    if (needs_restack_) {
+        restack();
+    }
+
+    const bool governed = frame_budget_.count() > 0;
+    for (const auto& managed_anim : animations_) {
+        Animation& animation = *managed_anim->animation;
+        if (governed) {
+            managed_anim->cost += animation.take_update_time();
+        }
+        if (animation.is_active() && animation.needs_render()) {
+            ProfileScope render_scope(profiler_, managed_anim->render_probe);
+            const auto start = governed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            animation.render(nc);
+            animation.clear_damage();
+            if (governed) {
+                managed_anim->cost += std::chrono::steady_clock::now() - start;
+            }
+        }
+    }
+}
 
+void AnimationManager::set_frame_budget(std::chrono::steady_clock::duration budget) {
+    frame_budget_ = budget;
+    window_frames_ = 0;
+    window_overruns_ = 0;
+    window_work_ = {};
+    calm_windows_ = 0;
+    const bool governed = budget.count() > 0;
     for (const auto& managed_anim : animations_) {
-        if (managed_anim->animation->is_active()) {
-            managed_anim->animation->render(nc);
+        managed_anim->animation->set_track_update_time(governed);
+        managed_anim->animation->take_update_time();
+        managed_anim->cost = {};
+        if (!governed && managed_anim->quality != 0) {
+            managed_anim->quality = 0;
+            apply_quality(*managed_anim);
+        }
+    }
+    if (!governed) {
+        lowered_.clear();
+    }
+}
+
+void AnimationManager::report_frame_time(std::chrono::steady_clock::duration work) {
+    if (frame_budget_.count() <= 0) {
+        return;
+    }
+    ++window_frames_;
+    window_work_ += work;
+    if (work > frame_budget_) {
+        ++window_overruns_;
+    }
+    if (window_frames_ < kGovernorWindowFrames) {
+        return;
+    }
+
+    const auto mean_work = window_work_ / window_frames_;
+    if (window_overruns_ > kMaxOverrunsPerWindow) {
+        lower_quality();
+        calm_windows_ = 0;
+    } else if (window_overruns_ == 0 && ++calm_windows_ >= kCalmWindowsBeforeRaise &&
+               mean_work * 5 < frame_budget_ * 3) {
+        raise_quality();
+        calm_windows_ = 0;
+    }
+
+    window_frames_ = 0;
+    window_overruns_ = 0;
+    window_work_ = {};
+    for (const auto& managed_anim : animations_) {
+        managed_anim->cost = {};
+    }
+}
+
+void AnimationManager::lower_quality() {
+    ManagedAnimation* costliest = nullptr;
+    for (const auto& managed_anim : animations_) {
+        const Animation& animation = *managed_anim->animation;
+        if (!animation.is_active() || managed_anim->quality >= animation.quality_levels() + kStrideLevels) {
+            continue;
+        }
+        if (!costliest || managed_anim->cost > costliest->cost) {
+            costliest = managed_anim.get();
+        }
+    }
+    if (!costliest || costliest->cost.count() == 0) {
+        return;
+    }
+    ++costliest->quality;
+    apply_quality(*costliest);
+    lowered_.push_back(costliest);
+}
+
+void AnimationManager::raise_quality() {
+    if (lowered_.empty()) {
+        return;
+    }
+    ManagedAnimation& managed = *lowered_.back();
+    lowered_.pop_back();
+    --managed.quality;
+    apply_quality(managed);
+}
+
+void AnimationManager::apply_quality(ManagedAnimation& managed) {
+    Animation& animation = *managed.animation;
+    const int own_levels = animation.quality_levels();
+    animation.set_quality(std::min(managed.quality, own_levels));
+    animation.set_update_stride(1u + static_cast<unsigned int>(std::max(0, managed.quality - own_levels)));
+}
+
+std::string AnimationManager::quality_summary() const {
+    std::string summary;
+    for (const auto& managed_anim : animations_) {
+        if (managed_anim->quality == 0) {
+            continue;
+        }
+        if (!summary.empty()) {
+            summary += ", ";
         }
+        summary += managed_anim->label + " -" + std::to_string(managed_anim->quality);
     }
+    return summary;
 }
 
 } // namespace animations
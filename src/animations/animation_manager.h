@@ -1,15 +1,23 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include <notcurses/notcurses.h>
 
 #include "animation.h"
+#include "../audio_sources.h"
 #include "../config.h"
 #include "../events/event_bus.h"
 #include "../events/frame_events.h"
+#include "../profiler.h"
+#include "../worker_pool.h"
 
 namespace why {
 namespace animations {
@@ -20,23 +28,98 @@ public:
     ~AnimationManager() = default;
 
     void load_animations(notcurses* nc, const AppConfig& config);
-    void update_all(float delta_time,
-                    const AudioMetrics& metrics,
-                    const std::vector<float>& bands,
-                    float beat_strength);
+
+    // Applies a reloaded config. An animation keeps running, with its state, as long as
+    // its [[animations]] entry at the same position, the first entry of its type (which
+    // init() reads) and, if depends_on_dsp_config(), [dsp] are all unchanged. Every other
+    // entry gets a fresh animation, and animations whose entry is gone are destroyed.
+    // Returns how many animations were created.
+    std::size_t reload_animations(notcurses* nc, const AppConfig& before, const AppConfig& after);
+    // Destroys every animation and its plane. Call before notcurses_stop(), which frees
+    // the planes the animations would otherwise destroy again.
+    void clear();
+    void update_all(float delta_time, const std::vector<std::unique_ptr<AudioSource>>& sources);
     void render_all(notcurses* nc);
 
+    // With a pool, animations that support it defer their update() out of the event
+    // handlers and update_all() runs those updates across the pool once every frame event
+    // has been published. Plane writes stay in render_all() on the calling thread.
+    void set_worker_pool(WorkerPool* pool);
+
+    // Times update_all/render_all and, per animation, its event handlers, deferred update
+    // and render. Set before load_animations() so the handlers get probes.
+    void set_profiler(Profiler* profiler);
+
+    // Publishes ResizeEvent so every animation lays its plane out for the new size.
+    void resize(unsigned int std_rows, unsigned int std_cols);
+
+    // Whether any animation follows the given source and analysis profile.
+    bool has_subscribers(const std::string& source_id, std::size_t source_index, const std::string& profile) const;
+
+    // Union of the bands those animations read, or std::nullopt when any of them needs the
+    // full spectrum.
+    std::optional<std::vector<std::size_t>> required_bands(const std::string& source_id,
+                                                            std::size_t source_index,
+                                                            const std::string& profile) const;
+
+    // Adaptive quality. With a non-zero budget every animation's update and render time
+    // is measured; when more than three frames of a 30-frame window overrun the budget,
+    // the animation that cost the most in it drops one quality level (its own levels
+    // first, then updating only every second and third frame). After four windows without
+    // a single overrun and with frames averaging under 60% of the budget, the animation
+    // lowered last steps back up. A zero budget turns it off and restores full quality.
+    void set_frame_budget(std::chrono::steady_clock::duration budget);
+    // Work time of the last frame, reported once per frame.
+    void report_frame_time(std::chrono::steady_clock::duration work);
+    // "CyberRain#2 -1, Breathe#4 -3" for lowered animations; empty at full quality.
+    std::string quality_summary() const;
+
     events::EventBus& event_bus() { return event_bus_; }
     const events::EventBus& event_bus() const { return event_bus_; }
 
 private:
+    // Subscriptions point at `config`, so it is declared (and outlives) the animation.
     struct ManagedAnimation {
-        std::unique_ptr<Animation> animation;
         AnimationConfig config;
+        std::unique_ptr<Animation> animation;
+        Profiler::ProbeId update_probe = 0; // Only meaningful while profiling
+        Profiler::ProbeId render_probe = 0;
+        std::string label;   // "<type>#<config index>"
+        std::size_t config_index = 0;
+        int z_index = 0;     // As of the last restack
+        bool parked = false; // Plane moved out of the rendering pile while inactive
+        int quality = 0;     // Governor level; above quality_levels() the update stride grows
+        std::chrono::steady_clock::duration cost{}; // Update and render time this window
     };
 
-    std::vector<std::unique_ptr<ManagedAnimation>> animations_;
+    std::unique_ptr<ManagedAnimation> create_animation(notcurses* nc,
+                                                       const AppConfig& app_config,
+                                                       std::size_t config_index);
+
+    void apply_quality(ManagedAnimation& managed);
+    void lower_quality();
+    void raise_quality();
+
+    void sync_plane_visibility(ncplane* stdplane);
+    void restack();
+
+    // Declared first so it outlives the subscription handles the animations hold.
     events::EventBus event_bus_;
+    std::vector<std::unique_ptr<ManagedAnimation>> animations_;
+    bool needs_restack_ = true;
+    WorkerPool* worker_pool_ = nullptr;
+    std::vector<ManagedAnimation*> deferred_updates_;
+    Profiler* profiler_ = nullptr;
+    Profiler::ProbeId update_all_probe_ = 0;
+    Profiler::ProbeId render_all_probe_ = 0;
+    std::vector<Profiler::Clock::duration> deferred_timings_; // Written by pool workers
+
+    std::chrono::steady_clock::duration frame_budget_{}; // Zero while the governor is off
+    std::uint32_t window_frames_ = 0;
+    std::uint32_t window_overruns_ = 0;
+    std::chrono::steady_clock::duration window_work_{};
+    std::uint32_t calm_windows_ = 0;        // Windows in a row without enough overruns to act
+    std::vector<ManagedAnimation*> lowered_; // In the order they were lowered
 };
 
 } // namespace animations
@@ -1,12 +1,11 @@
 #include "ascii_matrix_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 #include "glyph_utils.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
-#include <fstream>
-#include <sstream>
 
 namespace why {
 namespace animations {
@@ -22,7 +21,7 @@ constexpr float kDefaultBeatThreshold = 0.6f;
 } // namespace
 
 AsciiMatrixAnimation::AsciiMatrixAnimation()
-    : glyphs_(parse_glyphs(kDefaultGlyphs)),
+    : glyphs_(intern_glyphs(parse_glyphs(kDefaultGlyphs))),
       glyphs_file_path_(kDefaultGlyphFilePath) {}
 
 AsciiMatrixAnimation::~AsciiMatrixAnimation() {
@@ -52,10 +51,10 @@ void AsciiMatrixAnimation::init(notcurses* nc, const AppConfig& config) {
     unsigned int std_cols = 0;
     ncplane_dim_yx(stdplane, &std_rows, &std_cols);
 
-    int desired_y = plane_origin_y_;
-    int desired_x = plane_origin_x_;
-    int desired_rows = static_cast<int>(matrix_rows_ + (show_border_ ? 2 : 0));
-    int desired_cols = static_cast<int>(matrix_cols_ + (show_border_ ? 2 : 0));
+    plane_request_ = PlaneRequest{plane_origin_y_,
+                                  plane_origin_x_,
+                                  static_cast<unsigned int>(matrix_rows_ + (show_border_ ? 2 : 0)),
+                                  static_cast<unsigned int>(matrix_cols_ + (show_border_ ? 2 : 0))};
 
     for (const auto& anim_config : config.animations) {
         if (anim_config.type == "AsciiMatrix") {
@@ -83,70 +82,34 @@ void AsciiMatrixAnimation::init(notcurses* nc, const AppConfig& config) {
             beat_threshold_ = anim_config.matrix_beat_threshold;
 
             if (anim_config.plane_y) {
-                desired_y = *anim_config.plane_y;
+                plane_request_.y = *anim_config.plane_y;
             }
             if (anim_config.plane_x) {
-                desired_x = *anim_config.plane_x;
-            }
-            if (anim_config.plane_rows) {
-                desired_rows = std::max(*anim_config.plane_rows, show_border_ ? 3 : 1);
-            } else {
-                desired_rows = matrix_rows_ + (show_border_ ? 2 : 0);
-            }
-            if (anim_config.plane_cols) {
-                desired_cols = std::max(*anim_config.plane_cols, show_border_ ? 3 : 1);
-            } else {
-                desired_cols = matrix_cols_ + (show_border_ ? 2 : 0);
+                plane_request_.x = *anim_config.plane_x;
             }
+            plane_request_.rows = static_cast<unsigned int>(
+                anim_config.plane_rows ? std::max(*anim_config.plane_rows, show_border_ ? 3 : 1)
+                                       : matrix_rows_ + (show_border_ ? 2 : 0));
+            plane_request_.cols = static_cast<unsigned int>(
+                anim_config.plane_cols ? std::max(*anim_config.plane_cols, show_border_ ? 3 : 1)
+                                       : matrix_cols_ + (show_border_ ? 2 : 0));
             break;
         }
     }
 
-    if (std_rows > 0) {
-        plane_origin_y_ = std::clamp(desired_y, 0, static_cast<int>(std_rows) - 1);
-    } else {
-        plane_origin_y_ = 0;
-    }
-
-    if (std_cols > 0) {
-        plane_origin_x_ = std::clamp(desired_x, 0, static_cast<int>(std_cols) - 1);
-    } else {
-        plane_origin_x_ = 0;
-    }
-
-    plane_rows_ = 0;
-    plane_cols_ = 0;
-
-    const unsigned int available_rows = (std_rows > static_cast<unsigned int>(plane_origin_y_))
-                                            ? std_rows - static_cast<unsigned int>(plane_origin_y_)
-                                            : 0u;
-    const unsigned int available_cols = (std_cols > static_cast<unsigned int>(plane_origin_x_))
-                                            ? std_cols - static_cast<unsigned int>(plane_origin_x_)
-                                            : 0u;
-
-    if (available_rows > 0u) {
-        plane_rows_ = std::clamp(static_cast<unsigned int>(desired_rows), 1u, available_rows);
-    }
-    if (available_cols > 0u) {
-        plane_cols_ = std::clamp(static_cast<unsigned int>(desired_cols), 1u, available_cols);
-    }
-
-    if (plane_rows_ == 0u) {
-        plane_rows_ = std_rows;
-        plane_origin_y_ = 0;
-    }
-    if (plane_cols_ == 0u) {
-        plane_cols_ = std_cols;
-        plane_origin_x_ = 0;
-    }
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
 
     if (!load_glyphs_from_file(glyphs_file_path_)) {
         if (glyphs_file_path_ != kDefaultGlyphFilePath) {
             if (!load_glyphs_from_file(kDefaultGlyphFilePath)) {
-                glyphs_ = parse_glyphs(kDefaultGlyphs);
+                glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
             }
         } else {
-            glyphs_ = parse_glyphs(kDefaultGlyphs);
+            glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
         }
     }
 
@@ -170,6 +133,7 @@ void AsciiMatrixAnimation::init(notcurses* nc, const AppConfig& config) {
 
 void AsciiMatrixAnimation::activate() {
     is_active_ = true;
+    mark_dirty();
 }
 
 void AsciiMatrixAnimation::deactivate() {
@@ -187,14 +151,24 @@ void AsciiMatrixAnimation::update(float /*delta_time*/,
         return;
     }
 
+    // The beat changes the colour of every cell.
+    if ((beat_strength >= beat_threshold_) != (latest_beat_strength_ >= beat_threshold_)) {
+        mark_dirty();
+    }
     latest_beat_strength_ = beat_strength;
 
     const std::size_t cell_count = static_cast<std::size_t>(matrix_rows_) * static_cast<std::size_t>(matrix_cols_);
     if (cell_values_.size() != cell_count) {
         cell_values_.assign(cell_count, 0.0f);
+        mark_dirty();
     }
 
+    const unsigned int y_offset = show_border_ ? 1u : 0u;
+
     if (bands.empty()) {
+        if (std::any_of(cell_values_.begin(), cell_values_.end(), [](float value) { return value != 0.0f; })) {
+            mark_dirty();
+        }
         std::fill(cell_values_.begin(), cell_values_.end(), 0.0f);
         return;
     }
@@ -222,7 +196,10 @@ void AsciiMatrixAnimation::update(float /*delta_time*/,
             value = std::min(1.0f, value * beat_boost_);
         }
 
-        cell_values_[idx] = value;
+        if (cell_values_[idx] != value) {
+            cell_values_[idx] = value;
+            mark_row_dirty(y_offset + static_cast<unsigned int>(idx / static_cast<std::size_t>(matrix_cols_)));
+        }
     }
 }
 
@@ -231,41 +208,54 @@ void AsciiMatrixAnimation::render(notcurses* /*nc*/) {
         return;
     }
 
-    ncplane_erase(plane_);
-    ncplane_dim_yx(plane_, &plane_rows_, &plane_cols_);
-
-    ensure_dimensions_fit();
+    erase_damage(plane_);
 
     if (plane_rows_ == 0u || plane_cols_ == 0u || glyphs_.empty()) {
         return;
     }
 
+    // Erasing damaged rows also takes out their border cells; the border is cheap to
+    // redraw whole.
     if (show_border_) {
         draw_border();
     }
 
-    draw_matrix();
+    if (fully_damaged()) {
+        draw_matrix(0, matrix_rows_);
+        return;
+    }
+    const int y_offset = show_border_ ? 1 : 0;
+    for (const RowSpan& span : damaged_rows()) {
+        draw_matrix(static_cast<int>(span.begin) - y_offset, static_cast<int>(span.end) - y_offset);
+    }
 }
 
 bool AsciiMatrixAnimation::load_glyphs_from_file(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
+    auto glyphs = AssetCache::instance().glyphs(path);
+    if (!glyphs) {
         return false;
     }
+    glyphs_ = *glyphs;
+    return true;
+}
 
-    std::ostringstream buffer;
-    buffer << file.rdbuf();
-    std::string contents = buffer.str();
-    contents.erase(std::remove(contents.begin(), contents.end(), '\n'), contents.end());
-    contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
-
-    std::vector<std::string> parsed = parse_glyphs(contents);
-    if (parsed.empty()) {
-        return false;
+void AsciiMatrixAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
+    if (!plane_) {
+        return;
     }
 
-    glyphs_ = std::move(parsed);
-    return true;
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    if (!apply_plane_geometry(plane_, geometry)) {
+        return;
+    }
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    if (geometry.rows != plane_rows_ || geometry.cols != plane_cols_) {
+        plane_rows_ = geometry.rows;
+        plane_cols_ = geometry.cols;
+        ensure_dimensions_fit();
+        mark_dirty();
+    }
 }
 
 void AsciiMatrixAnimation::ensure_dimensions_fit() {
@@ -284,13 +274,18 @@ void AsciiMatrixAnimation::ensure_dimensions_fit() {
         return;
     }
 
+    const int old_rows = matrix_rows_;
+    const int old_cols = matrix_cols_;
     matrix_rows_ = std::clamp(configured_matrix_rows_, 1, available_rows);
     matrix_cols_ = std::clamp(configured_matrix_cols_, 1, available_cols);
 
-    const std::size_t desired_cells = static_cast<std::size_t>(matrix_rows_) * static_cast<std::size_t>(matrix_cols_);
-    if (cell_values_.size() != desired_cells) {
-        cell_values_.assign(desired_cells, 0.0f);
-    }
+    // Cells that still fit keep their values.
+    remap_grid(cell_values_,
+               static_cast<unsigned int>(std::max(0, old_rows)),
+               static_cast<unsigned int>(std::max(0, old_cols)),
+               static_cast<unsigned int>(matrix_rows_),
+               static_cast<unsigned int>(matrix_cols_),
+               0.0f);
 }
 
 void AsciiMatrixAnimation::draw_border() {
@@ -318,7 +313,7 @@ void AsciiMatrixAnimation::draw_border() {
     }
 }
 
-void AsciiMatrixAnimation::draw_matrix() {
+void AsciiMatrixAnimation::draw_matrix(int first_row, int end_row) {
     if (!plane_ || matrix_rows_ <= 0 || matrix_cols_ <= 0 || glyphs_.empty()) {
         return;
     }
@@ -332,7 +327,19 @@ void AsciiMatrixAnimation::draw_matrix() {
     const unsigned int y_offset = show_border_ ? 1u : 0u;
     const unsigned int x_offset = show_border_ ? 1u : 0u;
 
-    for (int row = 0; row < matrix_rows_; ++row) {
+    first_row = std::max(0, first_row);
+    end_row = std::min(end_row, matrix_rows_);
+    if (first_row >= end_row) {
+        return;
+    }
+    if (painter_.rows() != plane_rows_ || painter_.cols() != plane_cols_) {
+        painter_.resize(plane_rows_, plane_cols_);
+    }
+    const unsigned int paint_begin = y_offset + static_cast<unsigned int>(first_row);
+    const unsigned int paint_end = y_offset + static_cast<unsigned int>(end_row);
+    painter_.clear_rows(paint_begin, paint_end);
+
+    for (int row = first_row; row < end_row; ++row) {
         for (int col = 0; col < matrix_cols_; ++col) {
             const std::size_t cell_index = static_cast<std::size_t>(row) * static_cast<std::size_t>(matrix_cols_) + static_cast<std::size_t>(col);
             if (cell_index >= cell_values_.size()) {
@@ -345,27 +352,31 @@ void AsciiMatrixAnimation::draw_matrix() {
                 glyph_index = std::min<std::size_t>(glyph_count - 1,
                                                      static_cast<std::size_t>(std::round(value * static_cast<float>(glyph_count - 1))));
             }
-            const std::string& glyph = glyphs_[glyph_index];
+            const GlyphId glyph = glyphs_[glyph_index];
 
             const float color_value = std::clamp(value, 0.0f, 1.0f);
             const float boosted_color = beat_active ? std::min(1.0f, color_value * beat_boost_) : color_value;
             const uint8_t intensity = static_cast<uint8_t>(std::round(boosted_color * 255.0f));
 
+            std::uint32_t rgb = 0;
             if (beat_active) {
                 const uint8_t r = intensity;
                 const uint8_t g = static_cast<uint8_t>(std::min(255.0f, intensity * 0.6f));
-                ncplane_set_fg_rgb8(plane_, r, g, 0u);
+                rgb = CellPainter::pack_rgb(r, g, 0u);
             } else {
                 const uint8_t g = intensity;
                 const uint8_t b = static_cast<uint8_t>(std::min(255.0f, intensity * 0.8f));
-                ncplane_set_fg_rgb8(plane_, 0u, g, b);
+                rgb = CellPainter::pack_rgb(0u, g, b);
             }
 
-            ncplane_putstr_yx(plane_, static_cast<int>(y_offset + static_cast<unsigned int>(row)),
-                              static_cast<int>(x_offset + static_cast<unsigned int>(col)),
-                              glyph.c_str());
+            painter_.put(y_offset + static_cast<unsigned int>(row),
+                         x_offset + static_cast<unsigned int>(col),
+                         glyph,
+                         rgb);
         }
     }
+
+    painter_.paint(plane_, paint_begin, paint_end);
 }
 
 void AsciiMatrixAnimation::bind_events(const AnimationConfig& config, events::EventBus& bus) {
@@ -6,6 +6,8 @@
 #include <notcurses/notcurses.h>
 
 #include "animation.h"
+#include "cell_painter.h"
+#include "plane_layout.h"
 #include "../config.h"
 
 namespace why {
@@ -29,8 +31,10 @@ public:
     bool is_active() const override { return is_active_; }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool tracks_damage() const override { return true; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     ncplane* plane_ = nullptr;
@@ -41,6 +45,7 @@ private:
     unsigned int plane_cols_ = 0;
     int plane_origin_y_ = 0;
     int plane_origin_x_ = 0;
+    PlaneRequest plane_request_; // Always sized: the matrix plus its border, or the config
 
     int matrix_rows_ = 16;
     int matrix_cols_ = 32;
@@ -54,13 +59,14 @@ private:
     std::vector<float> cell_values_;
     float latest_beat_strength_ = 0.0f;
 
-    std::vector<std::string> glyphs_;
+    std::vector<GlyphId> glyphs_;
+    CellPainter painter_;
     std::string glyphs_file_path_;
 
     bool load_glyphs_from_file(const std::string& path);
     void ensure_dimensions_fit();
     void draw_border();
-    void draw_matrix();
+    void draw_matrix(int first_row, int end_row); // Matrix rows [first_row, end_row)
 };
 
 } // namespace animations
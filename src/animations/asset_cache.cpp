@@ -0,0 +1,87 @@
+#include "asset_cache.h"
+
+#include <algorithm>
+
+#include "glyph_utils.h"
+#include "../mapped_file.h"
+
+namespace why {
+namespace animations {
+
+namespace {
+
+bool read_file(const std::string& path, std::string& contents) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    contents.assign(reinterpret_cast<const char*>(file.data()), file.size());
+    return true;
+}
+
+} // namespace
+
+AssetCache& AssetCache::instance() {
+    static AssetCache cache;
+    return cache;
+}
+
+std::shared_ptr<const AssetCache::GlyphList> AssetCache::glyphs(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[path];
+    if (entry.glyphs_loaded) {
+        return entry.glyphs;
+    }
+    entry.glyphs_loaded = true;
+
+    std::string contents;
+    if (!read_file(path, contents)) {
+        return nullptr;
+    }
+    contents.erase(std::remove(contents.begin(), contents.end(), '\n'), contents.end());
+    contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
+
+    auto parsed = std::make_shared<GlyphList>(intern_glyphs(parse_glyphs(contents)));
+    if (!parsed->empty()) {
+        entry.glyphs = std::move(parsed);
+    }
+    return entry.glyphs;
+}
+
+std::shared_ptr<const AssetCache::LineList> AssetCache::lines(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[path];
+    if (entry.lines_loaded) {
+        return entry.lines;
+    }
+    entry.lines_loaded = true;
+
+    std::string contents;
+    if (!read_file(path, contents)) {
+        return nullptr;
+    }
+
+    auto parsed = std::make_shared<LineList>();
+    std::size_t start = 0;
+    while (start < contents.size()) {
+        std::size_t end = contents.find('\n', start);
+        if (end == std::string::npos) {
+            end = contents.size();
+        }
+        std::size_t length = end - start;
+        if (length > 0 && contents[start + length - 1] == '\r') {
+            --length;
+        }
+        if (length > 0) {
+            parsed->emplace_back(contents, start, length);
+        }
+        start = end + 1;
+    }
+    if (!parsed->empty()) {
+        entry.lines = std::move(parsed);
+    }
+    return entry.lines;
+}
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glyph_table.h"
+
+namespace why {
+namespace animations {
+
+// Glyph and text files the animations read (assets/*.txt or paths from the config),
+// loaded on first use and shared afterwards. A file is mapped and parsed once per
+// process; re-running init() on resize or scene changes hands out the same views.
+//
+// Views are immutable, so they can be held across frames and read from any thread.
+class AssetCache {
+public:
+    using GlyphList = std::vector<GlyphId>;
+    using LineList = std::vector<std::string>;
+
+    static AssetCache& instance();
+
+    // The file's glyphs in order, interned, with line breaks dropped. nullptr when the
+    // file is missing or holds no glyphs.
+    std::shared_ptr<const GlyphList> glyphs(const std::string& path);
+
+    // The file's non-empty lines without line terminators. nullptr when the file is
+    // missing or holds no lines.
+    std::shared_ptr<const LineList> lines(const std::string& path);
+
+private:
+    struct Entry {
+        bool glyphs_loaded = false;
+        bool lines_loaded = false;
+        std::shared_ptr<const GlyphList> glyphs;
+        std::shared_ptr<const LineList> lines;
+    };
+
+    AssetCache() = default;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+} // namespace animations
+} // namespace why
@@ -1,11 +1,10 @@
 #include "bar_visual_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 #include "glyph_utils.h"
 
 #include <algorithm>
 #include <cmath>
-#include <fstream>
-#include <sstream>
 
 namespace why {
 namespace animations {
@@ -17,7 +16,7 @@ constexpr const char* kDefaultGlyphs = R"( .'`^",:;Il!i><~+_-?][}{1)(|\/tfjrxnuv
 } // namespace
 
 BarVisualAnimation::BarVisualAnimation()
-    : glyphs_(parse_glyphs(kDefaultGlyphs)),
+    : glyphs_(intern_glyphs(parse_glyphs(kDefaultGlyphs))),
       glyphs_file_path_(kDefaultGlyphFilePath) {}
 
 BarVisualAnimation::~BarVisualAnimation() {
@@ -32,12 +31,8 @@ void BarVisualAnimation::init(notcurses* nc, const AppConfig& config) {
     unsigned int std_cols = 0;
     ncplane_dim_yx(stdplane, &std_rows, &std_cols);
 
-    int desired_y = plane_origin_y_;
-    int desired_x = plane_origin_x_;
-    int desired_rows = static_cast<int>(std_rows);
-    int desired_cols = static_cast<int>(std_cols);
-    bool has_custom_rows = false;
-    bool has_custom_cols = false;
+    plane_request_ = PlaneRequest{plane_origin_y_, plane_origin_x_, std::nullopt, std::nullopt};
+    std::string blitter;
 
     for (const auto& anim_config : config.animations) {
         if (anim_config.type == "BarVisual") { // Assuming type is used to identify
@@ -46,81 +41,39 @@ void BarVisualAnimation::init(notcurses* nc, const AppConfig& config) {
             if (!anim_config.text_file_path.empty()) {
                 glyphs_file_path_ = anim_config.text_file_path;
             }
+            blitter = anim_config.blitter;
             if (anim_config.plane_y) {
-                desired_y = *anim_config.plane_y;
+                plane_request_.y = *anim_config.plane_y;
             }
             if (anim_config.plane_x) {
-                desired_x = *anim_config.plane_x;
+                plane_request_.x = *anim_config.plane_x;
             }
-            if (anim_config.plane_rows) {
-                if (*anim_config.plane_rows > 0) {
-                    desired_rows = *anim_config.plane_rows;
-                    has_custom_rows = true;
-                } else {
-                    has_custom_rows = false;
-                }
+            if (anim_config.plane_rows && *anim_config.plane_rows > 0) {
+                plane_request_.rows = static_cast<unsigned int>(*anim_config.plane_rows);
             }
-            if (anim_config.plane_cols) {
-                if (*anim_config.plane_cols > 0) {
-                    desired_cols = *anim_config.plane_cols;
-                    has_custom_cols = true;
-                } else {
-                    has_custom_cols = false;
-                }
+            if (anim_config.plane_cols && *anim_config.plane_cols > 0) {
+                plane_request_.cols = static_cast<unsigned int>(*anim_config.plane_cols);
             }
             break;
         }
     }
 
-    if (std_rows > 0) {
-        plane_origin_y_ = std::clamp(desired_y, 0, static_cast<int>(std_rows) - 1);
-    } else {
-        plane_origin_y_ = 0;
-    }
-
-    if (std_cols > 0) {
-        plane_origin_x_ = std::clamp(desired_x, 0, static_cast<int>(std_cols) - 1);
-    } else {
-        plane_origin_x_ = 0;
-    }
-
-    const unsigned int available_rows = (std_rows > static_cast<unsigned int>(plane_origin_y_))
-                                            ? std_rows - static_cast<unsigned int>(plane_origin_y_)
-                                            : 0u;
-    const unsigned int available_cols = (std_cols > static_cast<unsigned int>(plane_origin_x_))
-                                            ? std_cols - static_cast<unsigned int>(plane_origin_x_)
-                                            : 0u;
-
-    if (has_custom_rows && available_rows > 0u) {
-        plane_rows_ = static_cast<unsigned int>(std::clamp(desired_rows, 1, static_cast<int>(available_rows)));
-    } else {
-        plane_rows_ = available_rows;
-    }
-
-    if (has_custom_cols && available_cols > 0u) {
-        plane_cols_ = static_cast<unsigned int>(std::clamp(desired_cols, 1, static_cast<int>(available_cols)));
-    } else {
-        plane_cols_ = available_cols;
-    }
-
-    if (plane_rows_ == 0u) {
-        plane_rows_ = std_rows;
-        plane_origin_y_ = 0;
-    }
-    if (plane_cols_ == 0u) {
-        plane_cols_ = std_cols;
-        plane_origin_x_ = 0;
-    }
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
 
     if (!load_glyphs_from_file(glyphs_file_path_)) {
         if (glyphs_file_path_ != kDefaultGlyphFilePath) {
             if (!load_glyphs_from_file(kDefaultGlyphFilePath)) {
-                glyphs_ = parse_glyphs(kDefaultGlyphs);
+                glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
             }
         } else {
-            glyphs_ = parse_glyphs(kDefaultGlyphs);
+            glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
         }
     }
+    painter_.set_background(CellPainter::pack_rgb(0, 0, 0)); // Black background
 
     if (plane_rows_ == 0u || plane_cols_ == 0u) {
         plane_ = nullptr;
@@ -137,13 +90,18 @@ void BarVisualAnimation::init(notcurses* nc, const AppConfig& config) {
     if (plane_) {
         ncplane_dim_yx(plane_, &plane_rows_, &plane_cols_);
     }
+    framebuffer_.configure(nc, blitter);
+    // layout_bars() scales bar heights by the framebuffer's pixels per cell, which are
+    // only known once it has been sized for the plane.
+    if (plane_ && framebuffer_.enabled()) {
+        framebuffer_.resize(plane_, plane_rows_, plane_cols_);
+    }
 }
 
 void BarVisualAnimation::activate() {
     is_active_ = true;
-    if (plane_) {
-        // Optionally reset or re-draw something on activation
-    }
+    // deactivate() erased the plane, so everything has to be painted again.
+    mark_dirty();
 }
 
 void BarVisualAnimation::deactivate() {
@@ -179,18 +137,86 @@ void BarVisualAnimation::update(float delta_time,
     if (beat_strength > 0.5f) {
         // Maybe amplify bands temporarily or change color in render
     }
+
+    layout_bars();
+}
+
+void BarVisualAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
+    if (!plane_) return;
+
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    if (!apply_plane_geometry(plane_, geometry)) {
+        return;
+    }
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    const bool resized = geometry.rows != plane_rows_ || geometry.cols != plane_cols_;
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
+    // In pixel mode the cell size can change without the cell count changing.
+    const unsigned int previous_scale_y = framebuffer_.scale_y();
+    if (framebuffer_.enabled()) {
+        framebuffer_.resize(plane_, plane_rows_, plane_cols_);
+    }
+    if (resized || framebuffer_.scale_y() != previous_scale_y) {
+        // Bar heights are relative to the plane, so they are laid out again from the
+        // last bands.
+        layout_bars();
+        mark_dirty();
+    }
+}
+
+void BarVisualAnimation::layout_bars() {
+    if (current_bands_.empty() || plane_rows_ == 0u || glyphs_.empty()) {
+        bars_.clear();
+        mark_dirty();
+        return;
+    }
+    if (bars_.size() != current_bands_.size()) {
+        bars_.assign(current_bands_.size(), BarLayout{});
+        mark_dirty();
+    }
+
+    // Leave some space for metrics
+    const unsigned int max_bar_height = (plane_rows_ - 1) * (framebuffer_.enabled() ? framebuffer_.scale_y() : 1u);
+    const std::size_t glyph_count = glyphs_.size();
+    for (std::size_t i = 0; i < current_bands_.size(); ++i) {
+        const float band_energy = current_bands_[i];
+        BarLayout layout;
+        // Simple scaling for visualization
+        layout.height = static_cast<unsigned int>(std::round(band_energy * max_bar_height));
+        // Determine glyph based on energy/height
+        layout.glyph_index = (glyph_count > 1)
+                                 ? std::min<std::size_t>(
+                                       glyph_count - 1,
+                                       static_cast<std::size_t>(std::round(
+                                           band_energy * static_cast<float>(glyph_count - 1))))
+                                 : 0;
+
+        const BarLayout& previous = bars_[i];
+        if (framebuffer_.enabled()) {
+            // The image is blitted whole.
+            if (layout.height != previous.height) {
+                mark_dirty();
+            }
+        } else if (layout.glyph_index != previous.glyph_index) {
+            // Every cell of the bar changes glyph.
+            const unsigned int tallest = std::max(layout.height, previous.height);
+            mark_rows_dirty(plane_rows_ - tallest, plane_rows_);
+        } else if (layout.height != previous.height) {
+            // Only the cells between the old and the new top.
+            const unsigned int low = std::min(layout.height, previous.height);
+            const unsigned int high = std::max(layout.height, previous.height);
+            mark_rows_dirty(plane_rows_ - high, plane_rows_ - low);
+        }
+        bars_[i] = layout;
+    }
 }
 
 void BarVisualAnimation::render(notcurses* nc) {
     if (!plane_ || !is_active_) return;
 
-    ncplane_erase(plane_);
-
-    unsigned int current_rows = 0;
-    unsigned int current_cols = 0;
-    ncplane_dim_yx(plane_, &current_rows, &current_cols);
-    plane_rows_ = current_rows;
-    plane_cols_ = current_cols;
+    erase_damage(plane_);
 
     if (plane_rows_ == 0u || plane_cols_ == 0u || glyphs_.empty()) {
         return;
@@ -202,56 +228,75 @@ void BarVisualAnimation::render(notcurses* nc) {
         return;
     }
 
-    const unsigned int num_bands = current_bands_.size();
+    if (framebuffer_.enabled()) {
+        paint_pixels(nc);
+        return;
+    }
+    if (fully_damaged()) {
+        paint_rows(0, plane_rows_);
+        return;
+    }
+    for (const RowSpan& span : damaged_rows()) {
+        paint_rows(span.begin, std::min(span.end, plane_rows_));
+    }
+}
+
+void BarVisualAnimation::paint_rows(unsigned int begin, unsigned int end) {
+    const unsigned int num_bands = static_cast<unsigned int>(bars_.size());
     if (num_bands == 0) return;
 
-    const unsigned int bar_width = std::max(1u, plane_cols_ / num_bands);
-    const unsigned int max_bar_height = plane_rows_ - 1; // Leave some space for metrics
+    if (painter_.rows() != plane_rows_ || painter_.cols() != plane_cols_) {
+        painter_.resize(plane_rows_, plane_cols_);
+    }
+    painter_.clear_rows(begin, end);
 
-    for (unsigned int i = 0; i < num_bands; ++i) {
-        const float band_energy = current_bands_[i];
-        // Simple scaling for visualization
-        const unsigned int bar_height = static_cast<unsigned int>(std::round(band_energy * max_bar_height));
+    constexpr std::uint32_t kBarColour = CellPainter::pack_rgb(0, 255, 0); // Green bars
+    const unsigned int bar_width = std::max(1u, plane_cols_ / num_bands);
 
-        // Determine glyph based on energy/height
-        const std::size_t glyph_count = glyphs_.size();
-        const std::size_t glyph_idx = (glyph_count > 1)
-                                          ? std::min<std::size_t>(
-                                                glyph_count - 1,
-                                                static_cast<std::size_t>(std::round(
-                                                    band_energy * static_cast<float>(glyph_count - 1))))
-                                          : 0;
-        const std::string& glyph = glyphs_[glyph_idx];
-
-        // Draw each bar
-        for (unsigned int h = 0; h < bar_height; ++h) {
+    for (unsigned int row = begin; row < end; ++row) {
+        const unsigned int h = plane_rows_ - 1 - row; // Height of this row above the bottom
+        for (unsigned int i = 0; i < num_bands; ++i) {
+            if (bars_[i].height <= h) {
+                continue;
+            }
+            const GlyphId glyph = glyphs_[bars_[i].glyph_index];
             for (unsigned int w = 0; w < bar_width; ++w) {
-                ncplane_set_fg_rgb8(plane_, 0, 255, 0); // Green bars
-                ncplane_set_bg_rgb8(plane_, 0, 0, 0);   // Black background
-                ncplane_putstr_yx(plane_, plane_rows_ - 1 - h, i * bar_width + w, glyph.c_str());
+                painter_.put(row, i * bar_width + w, glyph, kBarColour);
             }
         }
     }
+
+    painter_.paint(plane_, begin, end);
 }
 
-bool BarVisualAnimation::load_glyphs_from_file(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        return false;
+void BarVisualAnimation::paint_pixels(notcurses* nc) {
+    const unsigned int num_bands = static_cast<unsigned int>(bars_.size());
+    if (num_bands == 0) return;
+
+    if (framebuffer_.height() != plane_rows_ * framebuffer_.scale_y() ||
+        framebuffer_.width() != plane_cols_ * framebuffer_.scale_x()) {
+        framebuffer_.resize(plane_, plane_rows_, plane_cols_);
+    } else {
+        framebuffer_.clear();
+    }
+
+    constexpr std::uint32_t kBarColour = CellPainter::pack_rgb(0, 255, 0); // Green bars
+    const unsigned int height = framebuffer_.height();
+    const unsigned int bar_width = std::max(1u, framebuffer_.width() / num_bands);
+    for (unsigned int i = 0; i < num_bands; ++i) {
+        const unsigned int bar_height = std::min(bars_[i].height, height);
+        framebuffer_.fill_rect(height - bar_height, i * bar_width, bar_height, bar_width, kBarColour);
     }
 
-    std::ostringstream buffer;
-    buffer << file.rdbuf();
-    std::string contents = buffer.str();
-    contents.erase(std::remove(contents.begin(), contents.end(), '\n'), contents.end());
-    contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
+    framebuffer_.blit(nc, plane_);
+}
 
-    std::vector<std::string> parsed = parse_glyphs(contents);
-    if (parsed.empty()) {
+bool BarVisualAnimation::load_glyphs_from_file(const std::string& path) {
+    auto glyphs = AssetCache::instance().glyphs(path);
+    if (!glyphs) {
         return false;
     }
-
-    glyphs_ = std::move(parsed);
+    glyphs_ = *glyphs;
     return true;
 }
 
@@ -6,6 +6,9 @@
 #include <notcurses/notcurses.h>
 
 #include "animation.h"
+#include "cell_painter.h"
+#include "pixel_framebuffer.h"
+#include "plane_layout.h"
 #include "../config.h"
 
 namespace why {
@@ -29,20 +32,35 @@ public:
     bool is_active() const override { return is_active_; }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool tracks_damage() const override { return true; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
+    struct BarLayout {
+        unsigned int height = 0; // Cells, or framebuffer pixels when drawing through one
+        std::size_t glyph_index = 0;
+    };
+
+    void layout_bars();
+    void paint_rows(unsigned int begin, unsigned int end);
+    void paint_pixels(notcurses* nc);
+
     ncplane* plane_ = nullptr;
     int z_index_ = 0;
     bool is_active_ = true; // New: internal active state
     std::vector<float> current_bands_;
+    std::vector<BarLayout> bars_; // As last laid out; rows only change where these do
     unsigned int plane_rows_ = 0;
     unsigned int plane_cols_ = 0;
     int plane_origin_y_ = 0;
     int plane_origin_x_ = 0;
-    std::vector<std::string> glyphs_;
+    PlaneRequest plane_request_; // From the config; laid out again on every resize
+    std::vector<GlyphId> glyphs_;
     std::string glyphs_file_path_;
+    CellPainter painter_;
+    PixelFramebuffer framebuffer_;
 
     bool load_glyphs_from_file(const std::string& path);
 };
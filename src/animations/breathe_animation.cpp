@@ -1,10 +1,10 @@
 #include "breathe_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 #include "glyph_utils.h"
 
 #include <algorithm>
 #include <cmath>
-#include <fstream>
 
 namespace why {
 namespace animations {
@@ -14,10 +14,10 @@ constexpr const char* kDefaultGlyphFilePath = "assets/breathe_animation.txt";
 constexpr const char* kDefaultGlyphs = " .oO@#";
 constexpr float kTwoPi = 6.28318530717958647692f;
 
-std::vector<std::string> parse_glyphs_or_default(const std::string& source) {
-    auto glyphs = parse_glyphs(source);
+std::vector<GlyphId> parse_glyphs_or_default(const std::string& source) {
+    auto glyphs = intern_glyphs(parse_glyphs(source));
     if (glyphs.empty()) {
-        glyphs.emplace_back("#");
+        glyphs.push_back(GlyphTable::instance().intern("#"));
     }
     return glyphs;
 }
@@ -58,6 +58,7 @@ void BreatheAnimation::init(notcurses* nc, const AppConfig& config) {
     plane_cols_ = 0u;
     plane_origin_y_ = 0;
     plane_origin_x_ = 0;
+    plane_request_ = PlaneRequest{};
 
     z_index_ = 0;
     is_active_ = true;
@@ -87,16 +88,19 @@ void BreatheAnimation::init(notcurses* nc, const AppConfig& config) {
 
     configure_from_app(config);
     create_plane(nc);
-    refresh_dimensions();
+    framebuffer_.configure(nc, blitter_);
     reset_buffers();
     update_noise_table();
 }
 
 void BreatheAnimation::configure_from_app(const AppConfig& config) {
+    pitch_min_hz_ = config.dsp.pitch_min_hz;
+    pitch_max_hz_ = config.dsp.pitch_max_hz;
     for (const auto& anim_config : config.animations) {
         if (anim_config.type == "Breathe") {
             z_index_ = anim_config.z_index;
             is_active_ = anim_config.initially_active;
+            blitter_ = anim_config.blitter;
             if (!anim_config.glyphs_file_path.empty()) {
                 if (glyphs_file_path_ != anim_config.glyphs_file_path) {
                     glyphs_file_path_ = anim_config.glyphs_file_path;
@@ -104,16 +108,16 @@ void BreatheAnimation::configure_from_app(const AppConfig& config) {
                 }
             }
             if (anim_config.plane_y) {
-                plane_origin_y_ = *anim_config.plane_y;
+                plane_request_.y = *anim_config.plane_y;
             }
             if (anim_config.plane_x) {
-                plane_origin_x_ = *anim_config.plane_x;
+                plane_request_.x = *anim_config.plane_x;
             }
             if (anim_config.plane_rows) {
-                plane_rows_ = static_cast<unsigned int>(std::max(1, *anim_config.plane_rows));
+                plane_request_.rows = static_cast<unsigned int>(std::max(1, *anim_config.plane_rows));
             }
             if (anim_config.plane_cols) {
-                plane_cols_ = static_cast<unsigned int>(std::max(1, *anim_config.plane_cols));
+                plane_request_.cols = static_cast<unsigned int>(std::max(1, *anim_config.plane_cols));
             }
 
             if (anim_config.breathe_points > 0) {
@@ -158,6 +162,9 @@ void BreatheAnimation::configure_from_app(const AppConfig& config) {
             if (anim_config.breathe_band_weight >= 0.0f) {
                 band_weight_ = anim_config.breathe_band_weight;
             }
+            if (anim_config.breathe_pitch_radius >= 0.0f) {
+                pitch_radius_ = anim_config.breathe_pitch_radius;
+            }
             if (anim_config.display_duration_s > 0.0f) {
                 persistence_duration_s_ = anim_config.display_duration_s;
             }
@@ -179,67 +186,83 @@ void BreatheAnimation::create_plane(notcurses* nc) {
     unsigned int std_cols = 0u;
     ncplane_dim_yx(stdplane, &std_rows, &std_cols);
 
-    unsigned int rows = plane_rows_;
-    unsigned int cols = plane_cols_;
-
-    if (rows == 0u || rows > std_rows) {
-        rows = std_rows;
-    }
-    if (cols == 0u || cols > std_cols) {
-        cols = std_cols;
-    }
-
-    plane_origin_y_ = std::clamp(plane_origin_y_, 0, static_cast<int>(std_rows));
-    plane_origin_x_ = std::clamp(plane_origin_x_, 0, static_cast<int>(std_cols));
+    const PlaneGeometry geometry = fit_plane_loose(plane_request_, std_rows, std_cols);
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
 
     ncplane_options opts{};
-    opts.rows = rows;
-    opts.cols = cols;
+    opts.rows = geometry.rows;
+    opts.cols = geometry.cols;
     opts.y = plane_origin_y_;
     opts.x = plane_origin_x_;
 
     plane_ = ncplane_create(stdplane, &opts);
     if (plane_) {
-        plane_rows_ = rows;
-        plane_cols_ = cols;
+        plane_rows_ = geometry.rows;
+        plane_cols_ = geometry.cols;
         ncplane_set_scrolling(plane_, true);
     }
 }
 
-void BreatheAnimation::refresh_dimensions() {
+void BreatheAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
     if (!plane_) {
         return;
     }
 
-    unsigned int rows = 0u;
-    unsigned int cols = 0u;
-    ncplane_dim_yx(plane_, &rows, &cols);
-    if (rows != plane_rows_ || cols != plane_cols_) {
-        plane_rows_ = rows;
-        plane_cols_ = cols;
-        reset_buffers();
+    const PlaneGeometry geometry = fit_plane_loose(plane_request_, std_rows, std_cols);
+    if (!apply_plane_geometry(plane_, geometry)) {
+        return;
+    }
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    if (geometry.rows == plane_rows_ && geometry.cols == plane_cols_) {
+        return;
     }
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
+
+    // The shape is drawn around the plane's centre, so the trail stays centred too.
+    const unsigned int old_grid_rows = grid_rows_;
+    const unsigned int old_grid_cols = grid_cols_;
+    std::vector<float> trail = std::move(cell_intensities_);
+    reset_buffers();
+    remap_grid(trail,
+               old_grid_rows,
+               old_grid_cols,
+               grid_rows_,
+               grid_cols_,
+               0.0f,
+               (static_cast<int>(grid_rows_) - static_cast<int>(old_grid_rows)) / 2,
+               (static_cast<int>(grid_cols_) - static_cast<int>(old_grid_cols)) / 2);
+    cell_intensities_ = std::move(trail);
 }
 
 void BreatheAnimation::reset_buffers() {
     if (plane_rows_ == 0u || plane_cols_ == 0u) {
         cell_intensities_.clear();
+        grid_rows_ = 0u;
+        grid_cols_ = 0u;
         return;
     }
 
-    cell_intensities_.assign(static_cast<std::size_t>(plane_rows_) * static_cast<std::size_t>(plane_cols_),
-                             0.0f);
+    if (framebuffer_.enabled()) {
+        framebuffer_.resize(plane_, plane_rows_, plane_cols_);
+        grid_rows_ = framebuffer_.height();
+        grid_cols_ = framebuffer_.width();
+    } else {
+        grid_rows_ = plane_rows_;
+        grid_cols_ = plane_cols_;
+    }
+    cell_intensities_.assign(static_cast<std::size_t>(grid_rows_) * static_cast<std::size_t>(grid_cols_), 0.0f);
 }
 
 bool BreatheAnimation::load_glyphs_from_file(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
+    auto glyphs = AssetCache::instance().glyphs(path);
+    if (!glyphs) {
         return false;
     }
-
-    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    glyphs_ = parse_glyphs_or_default(content);
-    return !glyphs_.empty();
+    glyphs_ = *glyphs;
+    return true;
 }
 
 void BreatheAnimation::ensure_glyphs_loaded() {
@@ -300,30 +323,39 @@ void BreatheAnimation::draw_shape(float brightness) {
     if (!plane_ || plane_rows_ == 0u || plane_cols_ == 0u || points_ <= 1) {
         return;
     }
+    // Lower quality levels walk the same noise table with a stride.
+    const int point_stride = quality_ >= 3 ? 4 : (quality_ == 2 ? 2 : 1);
+    const int point_count = std::max(std::min(points_, 8), points_ / point_stride);
 
+    // The outline is laid out in cells and scaled onto the intensity grid.
+    const float scale_y = static_cast<float>(grid_rows_) / static_cast<float>(plane_rows_);
+    const float scale_x = static_cast<float>(grid_cols_) / static_cast<float>(plane_cols_);
     const float center_y = static_cast<float>(plane_rows_) / 2.0f;
     const float center_x = static_cast<float>(plane_cols_) / 2.0f;
 
     std::vector<std::pair<int, int>> points;
-    points.reserve(static_cast<std::size_t>(points_));
+    points.reserve(static_cast<std::size_t>(point_count));
 
-    for (int i = 0; i < points_; ++i) {
-        const float t = static_cast<float>(i) / static_cast<float>(points_);
+    for (int i = 0; i < point_count; ++i) {
+        const float t = static_cast<float>(i) / static_cast<float>(point_count);
         const float angle = kTwoPi * t + rotation_angle_;
+        const std::size_t phase_index = static_cast<std::size_t>(i) * static_cast<std::size_t>(points_) /
+                                        static_cast<std::size_t>(point_count);
         float noise_value = 0.0f;
-        if (i < static_cast<int>(noise_phases_.size())) {
-            noise_value = std::sin(breathing_phase_ * 0.5f + noise_phases_[static_cast<std::size_t>(i)]);
+        if (phase_index < noise_phases_.size()) {
+            noise_value = std::sin(breathing_phase_ * 0.5f + noise_phases_[phase_index]);
         }
         const float radius = std::max(0.0f,
                                       (min_radius_ +
                                        (max_radius_ - min_radius_) * (0.5f + 0.5f * std::sin(breathing_phase_)) +
-                                       audio_radius_influence_ * smoothed_energy_)) *
+                                       audio_radius_influence_ * smoothed_energy_ +
+                                       pitch_radius_ * smoothed_pitch_)) *
                              (1.0f + noise_amount_ * noise_value);
         const float px = center_x + radius * std::cos(angle);
         const float py = center_y + radius * std::sin(angle) * vertical_scale_;
 
-        const int ix = static_cast<int>(std::round(px));
-        const int iy = static_cast<int>(std::round(py));
+        const int ix = static_cast<int>(std::round(px * scale_x));
+        const int iy = static_cast<int>(std::round(py * scale_y));
         points.emplace_back(ix, iy);
     }
 
@@ -366,17 +398,20 @@ void BreatheAnimation::stamp_cell(int x, int y, float intensity) {
     if (x < 0 || y < 0) {
         return;
     }
-    if (plane_cols_ == 0u || plane_rows_ == 0u) {
+    if (grid_cols_ == 0u || grid_rows_ == 0u) {
         return;
     }
-    if (x >= static_cast<int>(plane_cols_) || y >= static_cast<int>(plane_rows_)) {
+    if (x >= static_cast<int>(grid_cols_) || y >= static_cast<int>(grid_rows_)) {
         return;
     }
 
-    const std::size_t idx = static_cast<std::size_t>(y) * static_cast<std::size_t>(plane_cols_) +
+    const std::size_t idx = static_cast<std::size_t>(y) * static_cast<std::size_t>(grid_cols_) +
                             static_cast<std::size_t>(x);
     float& cell = cell_intensities_[idx];
     cell = std::max(cell, clamp01(intensity));
+    if (quality_ >= 1) {
+        return; // No glow
+    }
 
     const float falloff = 0.6f * clamp01(intensity);
     for (int dy = -1; dy <= 1; ++dy) {
@@ -386,10 +421,10 @@ void BreatheAnimation::stamp_cell(int x, int y, float intensity) {
             }
             int nx = x + dx;
             int ny = y + dy;
-            if (nx < 0 || ny < 0 || nx >= static_cast<int>(plane_cols_) || ny >= static_cast<int>(plane_rows_)) {
+            if (nx < 0 || ny < 0 || nx >= static_cast<int>(grid_cols_) || ny >= static_cast<int>(grid_rows_)) {
                 continue;
             }
-            const std::size_t nidx = static_cast<std::size_t>(ny) * static_cast<std::size_t>(plane_cols_) +
+            const std::size_t nidx = static_cast<std::size_t>(ny) * static_cast<std::size_t>(grid_cols_) +
                                      static_cast<std::size_t>(nx);
             float& neighbor = cell_intensities_[nidx];
             neighbor = std::max(neighbor, falloff);
@@ -397,6 +432,14 @@ void BreatheAnimation::stamp_cell(int x, int y, float intensity) {
     }
 }
 
+std::optional<std::vector<std::size_t>> BreatheAnimation::required_bands() const {
+    std::vector<std::size_t> bands;
+    if (audio_band_index_ >= 0) {
+        bands.push_back(static_cast<std::size_t>(audio_band_index_));
+    }
+    return bands;
+}
+
 float BreatheAnimation::compute_audio_energy(const AudioMetrics& metrics,
                                              const std::vector<float>& bands,
                                              float beat_strength) const {
@@ -419,7 +462,6 @@ void BreatheAnimation::update(float delta_time,
         return;
     }
 
-    refresh_dimensions();
     ensure_glyphs_loaded();
     update_noise_table();
 
@@ -428,6 +470,7 @@ void BreatheAnimation::update(float delta_time,
     const float audio_energy = compute_audio_energy(metrics, bands, beat_strength);
     const float smoothing = smoothing_time_s_ > 0.0f ? clamp01(delta_time / (smoothing_time_s_ + delta_time)) : 1.0f;
     smoothed_energy_ = lerp(smoothed_energy_, audio_energy, smoothing);
+    smoothed_pitch_ = lerp(smoothed_pitch_, pitch_target_, smoothing);
 
     const float pulse_rate = base_pulse_hz_ + audio_pulse_weight_ * smoothed_energy_;
     breathing_phase_ += kTwoPi * pulse_rate * delta_time;
@@ -442,9 +485,11 @@ void BreatheAnimation::update(float delta_time,
 
     const float brightness = clamp01(0.35f + 0.65f * smoothed_energy_);
     draw_shape(brightness);
+    // The shape keeps breathing and rotating even in silence.
+    mark_dirty();
 }
 
-void BreatheAnimation::render(notcurses* /*nc*/) {
+void BreatheAnimation::render(notcurses* nc) {
     if (!plane_) {
         return;
     }
@@ -453,6 +498,23 @@ void BreatheAnimation::render(notcurses* /*nc*/) {
 
     ncplane_erase(plane_);
 
+    if (framebuffer_.enabled()) {
+        // Brightness stands in for the glyph ramp.
+        framebuffer_.clear();
+        for (unsigned int y = 0; y < grid_rows_; ++y) {
+            for (unsigned int x = 0; x < grid_cols_; ++x) {
+                const float value = clamp01(cell_intensities_[static_cast<std::size_t>(y) * grid_cols_ + x]);
+                if (value <= 0.0f) {
+                    continue;
+                }
+                const auto level = static_cast<std::uint32_t>(std::lround(value * 255.0f));
+                framebuffer_.set(y, x, (level << 16) | (level << 8) | level);
+            }
+        }
+        framebuffer_.blit(nc, plane_);
+        return;
+    }
+
     if (glyphs_.empty()) {
         return;
     }
@@ -468,7 +530,7 @@ void BreatheAnimation::render(notcurses* /*nc*/) {
                 continue;
             }
             const std::size_t glyph_index = static_cast<std::size_t>(std::floor(value * static_cast<float>(glyph_count - 1)));
-            const std::string& glyph = glyphs_[glyph_index];
+            const std::string& glyph = glyph_text(glyphs_[glyph_index]);
             ncplane_putstr_yx(plane_, static_cast<int>(y), static_cast<int>(x), glyph.c_str());
         }
     }
@@ -487,8 +549,28 @@ void BreatheAnimation::deactivate() {
     std::fill(cell_intensities_.begin(), cell_intensities_.end(), 0.0f);
 }
 
+void BreatheAnimation::handle_pitch(float frequency, float confidence) {
+    // Unvoiced or uncertain windows keep the last pitch so the outline does not collapse
+    // between notes.
+    if (frequency <= 0.0f || confidence < 0.5f) {
+        return;
+    }
+    const float octaves = std::log2(frequency / pitch_min_hz_);
+    const float range = std::log2(pitch_max_hz_ / pitch_min_hz_);
+    pitch_target_ = range > 0.0f ? clamp01(octaves / range) : 0.0f;
+}
+
 void BreatheAnimation::bind_events(const AnimationConfig& config, events::EventBus& bus) {
     bind_standard_frame_updates(this, config, bus);
+    if (pitch_radius_ > 0.0f) {
+        auto handle = bus.subscribe<events::PitchEvent>(
+            [this, source = config.source](const events::PitchEvent& event) {
+                if (matches_source(source, event.source_id, event.source_index)) {
+                    handle_pitch(event.frequency, event.confidence);
+                }
+            });
+        track_subscription(std::move(handle));
+    }
 }
 
 } // namespace animations
@@ -5,6 +5,9 @@
 #include <vector>
 
 #include "animation.h"
+#include "glyph_table.h"
+#include "pixel_framebuffer.h"
+#include "plane_layout.h"
 
 namespace why {
 namespace animations {
@@ -27,13 +30,21 @@ public:
     bool is_active() const override { return is_active_; }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool supports_parallel_update() const override { return true; }
+    bool tracks_damage() const override { return true; }
+    std::optional<std::vector<std::size_t>> required_bands() const override;
+    // 1: no glow around the outline; 2: also half the outline points; 3: a quarter.
+    bool depends_on_dsp_config() const override { return true; } // The pitch range
+
+    int quality_levels() const override { return 3; }
+    void set_quality(int level) override { quality_ = level; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     void configure_from_app(const AppConfig& config);
     void create_plane(notcurses* nc);
-    void refresh_dimensions();
     void reset_buffers();
     bool load_glyphs_from_file(const std::string& path);
     void ensure_glyphs_loaded();
@@ -44,6 +55,8 @@ private:
     void draw_line(int x0, int y0, int x1, int y1, float intensity);
     void stamp_cell(int x, int y, float intensity);
 
+    void handle_pitch(float frequency, float confidence);
+
     float compute_audio_energy(const AudioMetrics& metrics,
                                const std::vector<float>& bands,
                                float beat_strength) const;
@@ -53,17 +66,24 @@ private:
     unsigned int plane_cols_ = 0u;
     int plane_origin_y_ = 0;
     int plane_origin_x_ = 0;
+    PlaneRequest plane_request_; // From the config; laid out again on every resize
 
     int z_index_ = 0;
     bool is_active_ = true;
 
-    std::vector<std::string> glyphs_;
+    std::vector<GlyphId> glyphs_;
     std::string glyphs_file_path_;
     bool glyphs_loaded_ = false;
 
+    // One entry per cell, or per framebuffer pixel when drawing through one.
     std::vector<float> cell_intensities_;
+    unsigned int grid_rows_ = 0u;
+    unsigned int grid_cols_ = 0u;
+    std::string blitter_;
+    PixelFramebuffer framebuffer_;
 
     int points_ = 64;
+    int quality_ = 0;
     float min_radius_ = 6.0f;
     float max_radius_ = 14.0f;
     float audio_radius_influence_ = 10.0f;
@@ -79,6 +99,12 @@ private:
     float beat_weight_ = 0.6f;
     float band_weight_ = 0.5f;
 
+    float pitch_radius_ = 0.0f;
+    float pitch_min_hz_ = 60.0f;
+    float pitch_max_hz_ = 1000.0f;
+    float pitch_target_ = 0.0f;   // Position of the latest voiced pitch in the range, 0..1
+    float smoothed_pitch_ = 0.0f;
+
     float persistence_duration_s_ = 0.8f;
     float fade_duration_s_ = 1.2f;
 
@@ -0,0 +1,104 @@
+#include "cell_painter.h"
+
+#include <algorithm>
+
+namespace why {
+namespace animations {
+
+void CellPainter::resize(unsigned int rows, unsigned int cols) {
+    rows_ = rows;
+    cols_ = cols;
+    cells_.assign(static_cast<std::size_t>(rows_) * cols_, Cell{});
+    painted_rgb_.assign(cells_.size(), kNoColour);
+}
+
+void CellPainter::clear() {
+    std::fill(cells_.begin(), cells_.end(), Cell{});
+}
+
+void CellPainter::clear_rows(unsigned int begin, unsigned int end) {
+    end = std::min(end, rows_);
+    if (begin >= end) {
+        return;
+    }
+    std::fill(cells_.begin() + static_cast<std::ptrdiff_t>(begin) * cols_,
+              cells_.begin() + static_cast<std::ptrdiff_t>(end) * cols_,
+              Cell{});
+}
+
+void CellPainter::quantize_row(unsigned int row, const ColourQuantization& quantization) {
+    const std::size_t offset = static_cast<std::size_t>(row) * cols_;
+    Cell* line = cells_.data() + offset;
+    std::uint32_t* painted = painted_rgb_.data() + offset;
+    for (unsigned int col = 0; col < cols_; ++col) {
+        if (line[col].glyph == kBlank) {
+            painted[col] = kNoColour;
+            continue;
+        }
+        std::uint32_t rgb = quantization.quantize(line[col].rgb);
+        if (painted[col] != kNoColour && quantization.close_enough(rgb, painted[col])) {
+            rgb = painted[col];
+        }
+        line[col].rgb = rgb;
+        painted[col] = rgb;
+    }
+}
+
+void CellPainter::paint(ncplane* plane, unsigned int begin, unsigned int end) {
+    if (!plane) {
+        return;
+    }
+    end = std::min(end, rows_);
+    if (background_) {
+        ncplane_set_bg_rgb(plane, *background_);
+    }
+
+    const ColourQuantization quantization = ColourBudget::instance().current();
+    const GlyphTable& table = GlyphTable::instance();
+    bool have_colour = false;
+    std::uint32_t current_rgb = 0;
+    for (unsigned int row = begin; row < end; ++row) {
+        if (quantization.active()) {
+            quantize_row(row, quantization);
+        }
+        const Cell* line = cells_.data() + static_cast<std::size_t>(row) * cols_;
+        unsigned int col = 0;
+        while (col < cols_) {
+            const Cell& first = line[col];
+            if (first.glyph == kBlank) {
+                ++col;
+                continue;
+            }
+
+            const unsigned int start = col;
+            ++col;
+            if (table.width(first.glyph) == 1) {
+                while (col < cols_) {
+                    const Cell& next = line[col];
+                    if (next.glyph == kBlank || next.rgb != first.rgb || table.width(next.glyph) != 1) {
+                        break;
+                    }
+                    ++col;
+                }
+            }
+
+            if (!have_colour || first.rgb != current_rgb) {
+                ncplane_set_fg_rgb(plane, first.rgb);
+                current_rgb = first.rgb;
+                have_colour = true;
+            }
+            const char* text = table.text(first.glyph).c_str();
+            if (col - start > 1) {
+                run_.clear();
+                for (unsigned int i = start; i < col; ++i) {
+                    run_ += table.text(line[i].glyph);
+                }
+                text = run_.c_str();
+            }
+            ncplane_putstr_yx(plane, static_cast<int>(row), static_cast<int>(start), text);
+        }
+    }
+}
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <notcurses/notcurses.h>
+
+#include "colour_budget.h"
+#include "glyph_table.h"
+
+namespace why {
+namespace animations {
+
+// Off-plane grid of (glyph id, colour) cells that is written to a plane row by row.
+// Adjacent cells sharing a colour form a run that costs one colour change (skipped when
+// the colour is already current) and one string write, instead of the colour calls and
+// putstr per cell that drawing straight onto the plane takes.
+//
+// Colours go through the process-wide ColourBudget first, so under a bandwidth budget
+// runs get longer and cells keep the colour they were last painted with.
+class CellPainter {
+public:
+    static constexpr GlyphId kBlank = GlyphTable::kBlank; // Cell left as the caller erased it
+
+    struct Cell {
+        GlyphId glyph = kBlank; // Interned in GlyphTable
+        std::uint32_t rgb = 0;  // 0xRRGGBB foreground
+    };
+
+    static constexpr std::uint32_t pack_rgb(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+        return (static_cast<std::uint32_t>(r) << 16) | (static_cast<std::uint32_t>(g) << 8) | b;
+    }
+
+    // Background set once per paint; unset keeps the plane's current one.
+    void set_background(std::optional<std::uint32_t> rgb) { background_ = rgb; }
+
+    // Resizes the grid and blanks every cell, forgetting the colours last painted.
+    void resize(unsigned int rows, unsigned int cols);
+    unsigned int rows() const { return rows_; }
+    unsigned int cols() const { return cols_; }
+
+    void clear();
+    void clear_rows(unsigned int begin, unsigned int end);
+
+    void put(unsigned int row, unsigned int col, GlyphId glyph, std::uint32_t rgb) {
+        if (row < rows_ && col < cols_) {
+            cells_[static_cast<std::size_t>(row) * cols_ + col] = Cell{glyph, rgb};
+        }
+    }
+
+    // Writes grid rows [begin, end) to the same rows of `plane`, which the caller has
+    // erased there. Blank cells are skipped; glyphs wider than one column are written on
+    // their own so the rest of a run stays aligned.
+    void paint(ncplane* plane, unsigned int begin, unsigned int end);
+
+private:
+    static constexpr std::uint32_t kNoColour = 0xffffffffu;
+
+    // Quantises the row's colours, snapping each to the colour its cell was last painted
+    // with when close enough, and remembers the result for the next frame.
+    void quantize_row(unsigned int row, const ColourQuantization& quantization);
+
+    std::optional<std::uint32_t> background_;
+
+    unsigned int rows_ = 0;
+    unsigned int cols_ = 0;
+    std::vector<Cell> cells_;
+    std::vector<std::uint32_t> painted_rgb_; // Per cell as last painted; kNoColour when blank
+    std::string run_; // Reused between runs
+};
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,43 @@
+#include "colour_budget.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace why {
+namespace animations {
+
+namespace {
+
+std::uint32_t quantize_channel(std::uint32_t value, std::uint32_t step) {
+    return std::min<std::uint32_t>(255u, (value + step / 2u) / step * step);
+}
+
+} // namespace
+
+std::uint32_t ColourQuantization::quantize(std::uint32_t rgb) const {
+    if (step <= 1u) {
+        return rgb;
+    }
+    return (quantize_channel((rgb >> 16) & 0xffu, step) << 16) |
+           (quantize_channel((rgb >> 8) & 0xffu, step) << 8) |
+           quantize_channel(rgb & 0xffu, step);
+}
+
+bool ColourQuantization::close_enough(std::uint32_t rgb, std::uint32_t previous) const {
+    for (int shift = 0; shift <= 16; shift += 8) {
+        const int a = static_cast<int>((rgb >> shift) & 0xffu);
+        const int b = static_cast<int>((previous >> shift) & 0xffu);
+        if (static_cast<std::uint32_t>(std::abs(a - b)) > reuse_threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ColourBudget& ColourBudget::instance() {
+    static ColourBudget budget;
+    return budget;
+}
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace why {
+namespace animations {
+
+// How CellPainter coarsens foreground colours before writing them. Every colour change
+// between cells costs an SGR sequence of up to 19 bytes, and notcurses only skips a cell
+// whose glyph and colours match the last frame, so fewer distinct colours and colours that
+// stay put mean fewer bytes on the wire.
+struct ColourQuantization {
+    std::uint32_t step = 1;            // Channels rounded to multiples of this; 1 keeps 24-bit colour
+    std::uint32_t reuse_threshold = 0; // A cell keeps last frame's colour while no channel moved further
+
+    bool active() const { return step > 1 || reuse_threshold > 0; }
+
+    std::uint32_t quantize(std::uint32_t rgb) const;
+    bool close_enough(std::uint32_t rgb, std::uint32_t previous) const;
+};
+
+// Process-wide quantisation every CellPainter applies, set by the renderer from the
+// visual config and raised or lowered as output runs over or under its byte budget.
+class ColourBudget {
+public:
+    static ColourBudget& instance();
+
+    ColourQuantization current() const {
+        return ColourQuantization{step_.load(std::memory_order_relaxed),
+                                  reuse_threshold_.load(std::memory_order_relaxed)};
+    }
+    void set(const ColourQuantization& quantization) {
+        step_.store(quantization.step, std::memory_order_relaxed);
+        reuse_threshold_.store(quantization.reuse_threshold, std::memory_order_relaxed);
+    }
+
+private:
+    ColourBudget() = default;
+
+    std::atomic<std::uint32_t> step_{1};
+    std::atomic<std::uint32_t> reuse_threshold_{0};
+};
+
+} // namespace animations
+} // namespace why
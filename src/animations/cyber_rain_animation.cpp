@@ -1,13 +1,12 @@
 #include "cyber_rain_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 #include "glyph_utils.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
-#include <fstream>
-#include <sstream>
 
 namespace why {
 namespace animations {
@@ -18,6 +17,9 @@ constexpr const char* kDefaultGlyphs = R"(|/\\-_=+*<>[]{}())";
 constexpr float kDefaultHighFreqThreshold = 0.55f;
 constexpr float kDefaultPersistenceDuration = 0.6f;
 constexpr float kDefaultFadeDuration = 0.9f;
+// Per quality level: drop rate multiplier and cap on live drops (0 = none).
+constexpr float kQualityDropRateScale[] = {1.0f, 0.5f, 0.25f};
+constexpr std::size_t kQualityDropCap[] = {0, 192, 64};
 constexpr float kDefaultBaseScanSpeed = 10.0f;
 constexpr float kDefaultScanSpeedBoost = 14.0f;
 constexpr float kDefaultDropRateBase = 1.5f;
@@ -34,7 +36,8 @@ constexpr float kDegreesToRadians = 3.14159265358979323846f / 180.0f;
 } // namespace
 
 CyberRainAnimation::CyberRainAnimation()
-    : glyphs_(parse_glyphs(kDefaultGlyphs)),
+    : glyphs_(intern_glyphs(parse_glyphs(kDefaultGlyphs))),
+      fallback_glyph_(GlyphTable::instance().intern("|")),
       glyphs_file_path_(kDefaultGlyphFilePath),
       rng_(static_cast<std::mt19937::result_type>(
           std::chrono::steady_clock::now().time_since_epoch().count())),
@@ -54,7 +57,7 @@ void CyberRainAnimation::init(notcurses* nc, const AppConfig& config) {
     }
 
     glyphs_file_path_ = kDefaultGlyphFilePath;
-    glyphs_ = parse_glyphs(kDefaultGlyphs);
+    glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
     z_index_ = 0;
     is_active_ = true;
     trigger_band_index_ = -1;
@@ -83,12 +86,7 @@ void CyberRainAnimation::init(notcurses* nc, const AppConfig& config) {
     unsigned int std_cols = 0;
     ncplane_dim_yx(stdplane, &std_rows, &std_cols);
 
-    int desired_y = 0;
-    int desired_x = 0;
-    int desired_rows = static_cast<int>(std_rows);
-    int desired_cols = static_cast<int>(std_cols);
-    bool has_custom_rows = false;
-    bool has_custom_cols = false;
+    plane_request_ = PlaneRequest{};
 
     for (const auto& anim_config : config.animations) {
         if (anim_config.type == "CyberRain") {
@@ -120,22 +118,16 @@ void CyberRainAnimation::init(notcurses* nc, const AppConfig& config) {
                                                   kMaxRainAngleDegrees);
             rain_angle_degrees_ = clamped_angle;
             if (anim_config.plane_y) {
-                desired_y = *anim_config.plane_y;
+                plane_request_.y = *anim_config.plane_y;
             }
             if (anim_config.plane_x) {
-                desired_x = *anim_config.plane_x;
+                plane_request_.x = *anim_config.plane_x;
             }
-            if (anim_config.plane_rows) {
-                if (*anim_config.plane_rows > 0) {
-                    desired_rows = *anim_config.plane_rows;
-                    has_custom_rows = true;
-                }
+            if (anim_config.plane_rows && *anim_config.plane_rows > 0) {
+                plane_request_.rows = static_cast<unsigned int>(*anim_config.plane_rows);
             }
-            if (anim_config.plane_cols) {
-                if (*anim_config.plane_cols > 0) {
-                    desired_cols = *anim_config.plane_cols;
-                    has_custom_cols = true;
-                }
+            if (anim_config.plane_cols && *anim_config.plane_cols > 0) {
+                plane_request_.cols = static_cast<unsigned int>(*anim_config.plane_cols);
             }
             break;
         }
@@ -146,52 +138,19 @@ void CyberRainAnimation::init(notcurses* nc, const AppConfig& config) {
     if (!load_glyphs_from_file(glyphs_file_path_)) {
         if (glyphs_file_path_ != kDefaultGlyphFilePath) {
             if (!load_glyphs_from_file(kDefaultGlyphFilePath)) {
-                glyphs_ = parse_glyphs(kDefaultGlyphs);
+                glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
             }
         } else {
-            glyphs_ = parse_glyphs(kDefaultGlyphs);
+            glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
         }
     }
+    painter_.set_background(CellPainter::pack_rgb(0, 0, 0));
 
-    if (std_rows > 0) {
-        plane_origin_y_ = std::clamp(desired_y, 0, static_cast<int>(std_rows) - 1);
-    } else {
-        plane_origin_y_ = 0;
-    }
-
-    if (std_cols > 0) {
-        plane_origin_x_ = std::clamp(desired_x, 0, static_cast<int>(std_cols) - 1);
-    } else {
-        plane_origin_x_ = 0;
-    }
-
-    const unsigned int available_rows = (std_rows > static_cast<unsigned int>(plane_origin_y_))
-                                            ? std_rows - static_cast<unsigned int>(plane_origin_y_)
-                                            : 0u;
-    const unsigned int available_cols = (std_cols > static_cast<unsigned int>(plane_origin_x_))
-                                            ? std_cols - static_cast<unsigned int>(plane_origin_x_)
-                                            : 0u;
-
-    if (has_custom_rows && available_rows > 0u) {
-        plane_rows_ = static_cast<unsigned int>(std::clamp(desired_rows, 1, static_cast<int>(available_rows)));
-    } else {
-        plane_rows_ = available_rows;
-    }
-
-    if (has_custom_cols && available_cols > 0u) {
-        plane_cols_ = static_cast<unsigned int>(std::clamp(desired_cols, 1, static_cast<int>(available_cols)));
-    } else {
-        plane_cols_ = available_cols;
-    }
-
-    if (plane_rows_ == 0u) {
-        plane_rows_ = std_rows;
-        plane_origin_y_ = 0;
-    }
-    if (plane_cols_ == 0u) {
-        plane_cols_ = std_cols;
-        plane_origin_x_ = 0;
-    }
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
 
     if (plane_rows_ == 0u || plane_cols_ == 0u) {
         plane_ = nullptr;
@@ -237,16 +196,26 @@ void CyberRainAnimation::update(float delta_time,
                                 float /*beat_strength*/) {
     if (!plane_) return;
 
-    refresh_dimensions();
-
     if (!cells_.empty()) {
         const float decay = (fade_duration_s_ > 0.0f)
                                 ? std::clamp(delta_time / fade_duration_s_, 0.0f, 1.0f)
                                 : 1.0f;
-        for (auto& cell : cells_) {
-            cell.intensity = std::max(0.0f, cell.intensity - decay);
-            if (cell.intensity <= 0.01f) {
-                cell.glyph.clear();
+        for (unsigned int row = 0; row < plane_rows_; ++row) {
+            bool row_visible = false;
+            for (unsigned int col = 0; col < plane_cols_; ++col) {
+                CellState& cell = cells_[static_cast<std::size_t>(row) * plane_cols_ + col];
+                if (cell.intensity <= 0.0f) {
+                    continue;
+                }
+                // Only cells that were drawn change on screen when they dim.
+                row_visible = row_visible || cell.intensity > 0.01f;
+                cell.intensity = std::max(0.0f, cell.intensity - decay);
+                if (cell.intensity <= 0.01f) {
+                    cell.glyph = GlyphTable::kBlank;
+                }
+            }
+            if (row_visible) {
+                mark_row_dirty(row);
             }
         }
     }
@@ -322,16 +291,28 @@ void CyberRainAnimation::update(float delta_time,
 void CyberRainAnimation::render(notcurses* /*nc*/) {
     if (!plane_) return;
 
-    refresh_dimensions();
-
-    ncplane_erase(plane_);
-    ncplane_set_bg_rgb8(plane_, 0, 0, 0);
+    erase_damage(plane_);
 
     if (plane_rows_ == 0u || plane_cols_ == 0u) {
         return;
     }
 
-    for (unsigned int row = 0; row < plane_rows_; ++row) {
+    if (fully_damaged()) {
+        paint_rows(0, plane_rows_);
+        return;
+    }
+    for (const RowSpan& span : damaged_rows()) {
+        paint_rows(span.begin, std::min(span.end, plane_rows_));
+    }
+}
+
+void CyberRainAnimation::paint_rows(unsigned int begin, unsigned int end) {
+    if (painter_.rows() != plane_rows_ || painter_.cols() != plane_cols_) {
+        painter_.resize(plane_rows_, plane_cols_);
+    }
+    painter_.clear_rows(begin, end);
+
+    for (unsigned int row = begin; row < end; ++row) {
         for (unsigned int col = 0; col < plane_cols_; ++col) {
             const std::size_t index = static_cast<std::size_t>(row) * plane_cols_ + col;
             if (index >= cells_.size()) {
@@ -349,24 +330,29 @@ void CyberRainAnimation::render(notcurses* /*nc*/) {
             const uint8_t g = static_cast<uint8_t>(std::clamp(120.0f + 135.0f * glow, 0.0f, 255.0f));
             const uint8_t b = static_cast<uint8_t>(std::clamp(40.0f + 110.0f * glow, 0.0f, 255.0f));
 
-            ncplane_set_fg_rgb8(plane_, r, g, b);
-            const char* glyph = cell.glyph.empty() ? "|" : cell.glyph.c_str();
-            ncplane_putstr_yx(plane_, row, col, glyph);
+            const GlyphId glyph = cell.glyph == GlyphTable::kBlank ? fallback_glyph_ : cell.glyph;
+            painter_.put(row, col, glyph, CellPainter::pack_rgb(r, g, b));
         }
     }
+
+    painter_.paint(plane_, begin, end);
 }
 
-void CyberRainAnimation::refresh_dimensions() {
+void CyberRainAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
     if (!plane_) return;
 
-    unsigned int rows = 0;
-    unsigned int cols = 0;
-    ncplane_dim_yx(plane_, &rows, &cols);
-
-    if (rows != plane_rows_ || cols != plane_cols_) {
-        plane_rows_ = rows;
-        plane_cols_ = cols;
-        cells_.assign(static_cast<std::size_t>(plane_rows_) * plane_cols_, {});
+    const PlaneGeometry geometry = fit_plane(plane_request_, std_rows, std_cols);
+    if (!apply_plane_geometry(plane_, geometry)) {
+        return;
+    }
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    if (geometry.rows != plane_rows_ || geometry.cols != plane_cols_) {
+        // Trails stay where they were; drops keep falling from where they are.
+        remap_grid(cells_, plane_rows_, plane_cols_, geometry.rows, geometry.cols, CellState{});
+        plane_rows_ = geometry.rows;
+        plane_cols_ = geometry.cols;
+        mark_dirty();
         if (plane_cols_ > 0u) {
             scan_position_ = std::clamp(scan_position_, 0.0f, static_cast<float>(plane_cols_ - 1));
         } else {
@@ -384,19 +370,11 @@ void CyberRainAnimation::refresh_dimensions() {
 }
 
 bool CyberRainAnimation::load_glyphs_from_file(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) {
-        return false;
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    auto parsed = parse_glyphs(buffer.str());
-    if (parsed.empty()) {
+    auto glyphs = AssetCache::instance().glyphs(path);
+    if (!glyphs) {
         return false;
     }
-
-    glyphs_ = std::move(parsed);
+    glyphs_ = *glyphs;
     return true;
 }
 
@@ -410,7 +388,8 @@ void CyberRainAnimation::spawn_rain_column(int column, float activation, float d
 
     const float drop_rate = std::clamp(drop_rate_base_per_s_ + drop_rate_boost_per_s_ * activation,
                                        0.0f,
-                                       100.0f);
+                                       100.0f) *
+                            kQualityDropRateScale[quality_];
     drop_spawn_accumulator_ = std::min(drop_spawn_accumulator_ + drop_rate * delta_time, 8.0f);
 
     int spawn_count = static_cast<int>(drop_spawn_accumulator_);
@@ -425,6 +404,10 @@ void CyberRainAnimation::spawn_rain_column(int column, float activation, float d
     }
 
     spawn_count = std::clamp(spawn_count, 0, 8);
+    if (const std::size_t cap = kQualityDropCap[quality_]; cap > 0) {
+        spawn_count = std::min(spawn_count,
+                               static_cast<int>(cap - std::min(cap, active_drops_.size())));
+    }
 
     std::uniform_int_distribution<int> length_dist(drop_length_min_, drop_length_max_);
     std::uniform_real_distribution<float> speed_dist(drop_speed_min_rows_per_s_, drop_speed_max_rows_per_s_);
@@ -441,9 +424,9 @@ void CyberRainAnimation::spawn_rain_column(int column, float activation, float d
             std::uniform_int_distribution<std::size_t> glyph_dist(0, glyphs_.size() - 1);
             drop.glyph = glyphs_[glyph_dist(rng_)];
         } else {
-            drop.glyph = "|";
+            drop.glyph = fallback_glyph_;
         }
-        active_drops_.push_back(std::move(drop));
+        active_drops_.push_back(drop);
     }
 }
 
@@ -489,6 +472,7 @@ void CyberRainAnimation::update_drops(float delta_time) {
             if (intensity > cell.intensity) {
                 cell.intensity = intensity;
                 cell.glyph = drop.glyph;
+                mark_row_dirty(static_cast<unsigned int>(row));
             }
         }
     }
@@ -520,6 +504,14 @@ void CyberRainAnimation::remove_finished_drops() {
                         active_drops_.end());
 }
 
+std::optional<std::vector<std::size_t>> CyberRainAnimation::required_bands() const {
+    // Without a trigger band the rain follows the average of the upper bands.
+    if (trigger_band_index_ < 0) {
+        return std::nullopt;
+    }
+    return std::vector<std::size_t>{};
+}
+
 float CyberRainAnimation::compute_high_frequency_energy(const std::vector<float>& bands) const {
     if (bands.empty()) {
         return 0.0f;
@@ -5,6 +5,9 @@
 #include <vector>
 
 #include "animation.h"
+#include "cell_painter.h"
+#include "glyph_table.h"
+#include "plane_layout.h"
 
 namespace why {
 namespace animations {
@@ -27,13 +30,20 @@ public:
     bool is_active() const override { return is_active_ || has_visible_cells(); }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool supports_parallel_update() const override { return true; }
+    bool tracks_damage() const override { return true; }
+    std::optional<std::vector<std::size_t>> required_bands() const override;
+    // 1: half the drop rate, at most 192 drops; 2: a quarter, at most 64.
+    int quality_levels() const override { return 2; }
+    void set_quality(int level) override { quality_ = level; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     struct CellState {
         float intensity = 0.0f;
-        std::string glyph;
+        GlyphId glyph = GlyphTable::kBlank;
     };
 
     struct ActiveDrop {
@@ -43,10 +53,10 @@ private:
         float horizontal_speed_cols_per_s = 0.0f;
         int length = 0;
         float strength = 0.0f;
-        std::string glyph;
+        GlyphId glyph = GlyphTable::kBlank;
     };
 
-    void refresh_dimensions();
+    void paint_rows(unsigned int begin, unsigned int end);
     bool load_glyphs_from_file(const std::string& path);
     void spawn_rain_column(int column, float activation, float delta_time);
     void update_drops(float delta_time);
@@ -59,12 +69,15 @@ private:
     unsigned int plane_cols_ = 0;
     int plane_origin_y_ = 0;
     int plane_origin_x_ = 0;
+    PlaneRequest plane_request_; // From the config; laid out again on every resize
 
     std::vector<CellState> cells_;
     std::vector<ActiveDrop> active_drops_;
 
-    std::vector<std::string> glyphs_;
+    std::vector<GlyphId> glyphs_;
+    GlyphId fallback_glyph_ = GlyphTable::kBlank;
     std::string glyphs_file_path_;
+    CellPainter painter_;
 
     int z_index_ = 0;
     bool is_active_ = true;
@@ -91,6 +104,7 @@ private:
     float drop_speed_max_rows_per_s_ = 22.0f;
 
     float drop_spawn_accumulator_ = 0.0f;
+    int quality_ = 0;
 
     float rain_angle_degrees_ = 0.0f;
     float horizontal_slope_ = 0.0f;
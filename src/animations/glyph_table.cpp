@@ -0,0 +1,74 @@
+#include "glyph_table.h"
+
+#include <notcurses/notcurses.h>
+
+namespace why {
+namespace animations {
+
+namespace {
+
+// Column width of `glyph`, or -1 when it is not a single printable cluster.
+int measure_glyph(const std::string& glyph) {
+    int valid_bytes = 0;
+    int valid_width = 0;
+    const int width = ncstrwidth(glyph.c_str(), &valid_bytes, &valid_width);
+    if (width < 1 || valid_bytes != static_cast<int>(glyph.size())) {
+        return -1;
+    }
+    return width;
+}
+
+} // namespace
+
+GlyphTable& GlyphTable::instance() {
+    static GlyphTable table;
+    return table;
+}
+
+GlyphId GlyphTable::intern(const std::string& glyph) {
+    if (glyph.empty()) {
+        return kBlank;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = ids_.find(glyph);
+    if (found != ids_.end()) {
+        return found->second;
+    }
+
+    int width = measure_glyph(glyph);
+    std::string text = glyph;
+    if (width < 0) {
+        text = "?";
+        width = 1;
+    }
+
+    if (size_ >= kBlank) {
+        return kBlank;
+    }
+    const GlyphId id = static_cast<GlyphId>(size_);
+    auto& chunk = chunks_[id >> kChunkBits];
+    if (!chunk) {
+        chunk = std::make_unique<Entry[]>(kChunkSize);
+    }
+    chunk[id & (kChunkSize - 1)] = Entry{std::move(text), width};
+    ++size_;
+    ids_.emplace(glyph, id);
+    return id;
+}
+
+std::vector<GlyphId> intern_glyphs(const std::vector<std::string>& glyphs) {
+    GlyphTable& table = GlyphTable::instance();
+    std::vector<GlyphId> ids;
+    ids.reserve(glyphs.size());
+    for (const std::string& glyph : glyphs) {
+        const GlyphId id = table.intern(glyph);
+        if (id != GlyphTable::kBlank) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace why {
+namespace animations {
+
+using GlyphId = std::uint16_t;
+
+// Process-wide intern table of glyphs (UTF-8 grapheme clusters). Each distinct glyph is
+// stored once, with its column width measured when it is interned, and referred to by a
+// 16-bit id, so cell grids and drops carry two bytes instead of a std::string.
+//
+// Interning takes a lock and normally happens while animations load. Looking an id up is
+// lock-free and safe from any thread once the id has been handed to it: entries live in
+// fixed chunks that never move.
+class GlyphTable {
+public:
+    static constexpr GlyphId kBlank = 0xffff; // Never interned; marks an empty cell
+
+    static GlyphTable& instance();
+
+    // Id of `glyph`, interning it on first use. Glyphs notcurses cannot measure are
+    // replaced with "?"; empty strings and a full table map to kBlank.
+    GlyphId intern(const std::string& glyph);
+
+    const std::string& text(GlyphId id) const { return entry(id).text; }
+    // Columns the glyph occupies (1 for most, 2 for wide CJK or emoji).
+    int width(GlyphId id) const { return entry(id).width; }
+
+private:
+    static constexpr std::size_t kChunkBits = 8;
+    static constexpr std::size_t kChunkSize = std::size_t{1} << kChunkBits;
+    static constexpr std::size_t kChunkCount = (std::size_t{kBlank} + kChunkSize - 1) / kChunkSize;
+
+    struct Entry {
+        std::string text;
+        int width = 1;
+    };
+
+    GlyphTable() = default;
+
+    const Entry& entry(GlyphId id) const {
+        return chunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, GlyphId> ids_;
+    std::array<std::unique_ptr<Entry[]>, kChunkCount> chunks_;
+    std::size_t size_ = 0;
+};
+
+// Interns every glyph of `glyphs`, in order.
+std::vector<GlyphId> intern_glyphs(const std::vector<std::string>& glyphs);
+
+inline const std::string& glyph_text(GlyphId id) {
+    return GlyphTable::instance().text(id);
+}
+
+} // namespace animations
+} // namespace why
@@ -1,4 +1,5 @@
 #include "lightning_wave_animation.h"
+#include "asset_cache.h"
 
 #include "animation_event_utils.h"
 #include "glyph_utils.h"
@@ -6,8 +7,6 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
-#include <fstream>
-#include <sstream>
 
 namespace why {
 namespace animations {
@@ -20,7 +19,7 @@ constexpr float kMaxTriggerThreshold = 1.0f;
 }
 
 LightningWaveAnimation::LightningWaveAnimation()
-    : glyphs_(parse_glyphs(kDefaultGlyphs)),
+    : glyphs_(intern_glyphs(parse_glyphs(kDefaultGlyphs))),
       glyphs_file_path_(kDefaultGlyphFilePath) {}
 
 LightningWaveAnimation::~LightningWaveAnimation() {
@@ -37,13 +36,14 @@ void LightningWaveAnimation::init(notcurses* nc, const AppConfig& config) {
     }
 
     glyphs_file_path_ = kDefaultGlyphFilePath;
-    glyphs_ = parse_glyphs(kDefaultGlyphs);
+    glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
     glyphs_loaded_ = true;
 
     plane_rows_ = 0u;
     plane_cols_ = 0u;
     plane_origin_y_ = 0;
     plane_origin_x_ = 0;
+    plane_request_ = PlaneRequest{};
 
     z_index_ = 0;
     is_active_ = false;
@@ -62,7 +62,6 @@ void LightningWaveAnimation::init(notcurses* nc, const AppConfig& config) {
 
     configure_from_app(config);
     create_plane(nc);
-    refresh_dimensions();
     reset_history();
 }
 
@@ -95,16 +94,16 @@ void LightningWaveAnimation::configure_from_app(const AppConfig& config) {
             }
 
             if (anim_config.plane_y) {
-                plane_origin_y_ = *anim_config.plane_y;
+                plane_request_.y = *anim_config.plane_y;
             }
             if (anim_config.plane_x) {
-                plane_origin_x_ = *anim_config.plane_x;
+                plane_request_.x = *anim_config.plane_x;
             }
             if (anim_config.plane_rows) {
-                plane_rows_ = static_cast<unsigned int>(std::max(1, *anim_config.plane_rows));
+                plane_request_.rows = static_cast<unsigned int>(std::max(1, *anim_config.plane_rows));
             }
             if (anim_config.plane_cols) {
-                plane_cols_ = static_cast<unsigned int>(std::max(1, *anim_config.plane_cols));
+                plane_request_.cols = static_cast<unsigned int>(std::max(1, *anim_config.plane_cols));
             }
 
             break;
@@ -122,15 +121,11 @@ void LightningWaveAnimation::create_plane(notcurses* nc) {
     unsigned int std_cols = 0;
     ncplane_dim_yx(stdplane, &std_rows, &std_cols);
 
-    if (plane_rows_ == 0u || plane_rows_ > std_rows) {
-        plane_rows_ = std_rows;
-    }
-    if (plane_cols_ == 0u || plane_cols_ > std_cols) {
-        plane_cols_ = std_cols;
-    }
-
-    plane_origin_y_ = std::clamp(plane_origin_y_, 0, static_cast<int>(std_rows));
-    plane_origin_x_ = std::clamp(plane_origin_x_, 0, static_cast<int>(std_cols));
+    const PlaneGeometry geometry = fit_plane_loose(plane_request_, std_rows, std_cols);
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
 
     ncplane_options opts{};
     opts.rows = plane_rows_;
@@ -141,19 +136,35 @@ void LightningWaveAnimation::create_plane(notcurses* nc) {
     plane_ = ncplane_create(stdplane, &opts);
 }
 
-void LightningWaveAnimation::refresh_dimensions() {
+void LightningWaveAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
     if (!plane_) {
         return;
     }
 
-    unsigned int rows = 0;
-    unsigned int cols = 0;
-    ncplane_dim_yx(plane_, &rows, &cols);
-    if (rows != plane_rows_ || cols != plane_cols_) {
-        plane_rows_ = rows;
-        plane_cols_ = cols;
-        ensure_history_capacity();
+    const PlaneGeometry geometry = fit_plane_loose(plane_request_, std_rows, std_cols);
+    if (!apply_plane_geometry(plane_, geometry)) {
+        return;
+    }
+    plane_origin_y_ = geometry.y;
+    plane_origin_x_ = geometry.x;
+    if (geometry.rows == plane_rows_ && geometry.cols == plane_cols_) {
+        return;
     }
+
+    // history_ holds one column of plane_rows_ values per plane column, newest last and
+    // counted from the bottom row up: keep the newest columns, anchored bottom right.
+    remap_grid(history_,
+               plane_cols_,
+               plane_rows_,
+               geometry.cols,
+               geometry.rows,
+               0.0f,
+               static_cast<int>(geometry.cols) - static_cast<int>(plane_cols_),
+               0);
+    plane_rows_ = geometry.rows;
+    plane_cols_ = geometry.cols;
+    ensure_history_capacity();
+    mark_dirty();
 }
 
 void LightningWaveAnimation::reset_history() {
@@ -246,20 +257,11 @@ bool LightningWaveAnimation::bands_triggered(const std::vector<float>& bands) co
 }
 
 bool LightningWaveAnimation::load_glyphs_from_file(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return false;
-    }
-
-    std::ostringstream buffer;
-    buffer << file.rdbuf();
-    const std::string contents = buffer.str();
-    auto glyphs = parse_glyphs(contents);
-    if (glyphs.empty()) {
+    auto glyphs = AssetCache::instance().glyphs(path);
+    if (!glyphs) {
         return false;
     }
-
-    glyphs_ = std::move(glyphs);
+    glyphs_ = *glyphs;
     return true;
 }
 
@@ -280,7 +282,7 @@ void LightningWaveAnimation::ensure_glyphs_loaded() {
         }
     }
 
-    glyphs_ = parse_glyphs(kDefaultGlyphs);
+    glyphs_ = intern_glyphs(parse_glyphs(kDefaultGlyphs));
     glyphs_loaded_ = true;
 }
 
@@ -291,6 +293,7 @@ void LightningWaveAnimation::activate() {
 
     is_active_ = true;
     reset_history();
+    mark_dirty();
 }
 
 void LightningWaveAnimation::deactivate() {
@@ -319,7 +322,9 @@ void LightningWaveAnimation::update(float delta_time,
         return;
     }
 
-    refresh_dimensions();
+    // The whole history scrolls, so any visible column means a full repaint.
+    const bool was_visible = has_visible_history();
+
     fade_history(delta_time);
 
     if (activation_timer_s_ > 0.0f) {
@@ -359,6 +364,10 @@ void LightningWaveAnimation::update(float delta_time,
     }
 
     pending_column_injection_ = false;
+
+    if (was_visible || has_visible_history()) {
+        mark_dirty();
+    }
 }
 
 void LightningWaveAnimation::render(notcurses* /*nc*/) {
@@ -385,7 +394,12 @@ void LightningWaveAnimation::render(notcurses* /*nc*/) {
         return;
     }
 
-    ncplane_set_fg_rgb8(plane_, 210, 220, 255);
+    if (painter_.rows() != plane_rows_ || painter_.cols() != plane_cols_) {
+        painter_.resize(plane_rows_, plane_cols_);
+    } else {
+        painter_.clear();
+    }
+    constexpr std::uint32_t kBoltColour = CellPainter::pack_rgb(210, 220, 255);
 
     const std::size_t stride = static_cast<std::size_t>(plane_rows_);
     for (unsigned int col = 0; col < plane_cols_; ++col) {
@@ -402,21 +416,25 @@ void LightningWaveAnimation::render(notcurses* /*nc*/) {
                 glyph_index = glyph_count - 1u;
             }
 
-            const std::string& glyph = glyphs_[glyph_index];
-            const int draw_row = static_cast<int>(plane_rows_ - 1u - row);
-            ncplane_putstr_yx(plane_, draw_row, static_cast<int>(col), glyph.c_str());
+            painter_.put(plane_rows_ - 1u - row, col, glyphs_[glyph_index], kBoltColour);
         }
     }
+
+    painter_.paint(plane_, 0, plane_rows_);
 }
 
 void LightningWaveAnimation::bind_events(const AnimationConfig& config, events::EventBus& bus) {
-    AnimationConfig captured_config = config;
-    captured_config.trigger_threshold = trigger_threshold_;
-
+    const AnimationConfig* config_ptr = &config;
     auto handle = bus.subscribe<events::FrameUpdateEvent>(
-        [this, captured_config](const events::FrameUpdateEvent& event) mutable {
+        [this, config_ptr](const events::FrameUpdateEvent& event) {
+            const AnimationConfig& captured_config = *config_ptr;
+            if (!matches_analysis(captured_config, event.source_id, event.source_index, event.profile)) {
+                return;
+            }
+
+            const std::vector<float>& bands = select_bands(captured_config, event);
             const bool meets_beat = evaluate_beat_condition(captured_config, event.beat_strength);
-            const bool triggered = meets_beat && bands_triggered(event.bands);
+            const bool triggered = meets_beat && bands_triggered(bands);
 
             pending_column_injection_ = triggered;
 
@@ -428,9 +446,11 @@ void LightningWaveAnimation::bind_events(const AnimationConfig& config, events::
             }
 
             if (is_active_) {
-                update(event.delta_time, event.metrics, event.bands, event.beat_strength);
+                request_update(event.delta_time, event.metrics, bands, event.beat_strength);
             }
 
+            // With deferred updates this sees the previous frame's history, so fading out
+            // completes one frame later.
             if (!triggered && is_active_ && activation_timer_s_ <= 0.0f && !has_visible_history()) {
                 deactivate();
             }
@@ -4,6 +4,8 @@
 #include <vector>
 
 #include "animation.h"
+#include "cell_painter.h"
+#include "plane_layout.h"
 
 namespace why {
 namespace animations {
@@ -26,13 +28,15 @@ public:
     bool is_active() const override;
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool supports_parallel_update() const override { return true; }
+    bool tracks_damage() const override { return true; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     void configure_from_app(const AppConfig& config);
     void create_plane(notcurses* nc);
-    void refresh_dimensions();
     void reset_history();
     void ensure_history_capacity();
     void shift_history(int steps);
@@ -48,6 +52,7 @@ private:
     unsigned int plane_cols_ = 0;
     int plane_origin_y_ = 0;
     int plane_origin_x_ = 0;
+    PlaneRequest plane_request_; // From the config; laid out again on every resize
 
     int z_index_ = 0;
     bool is_active_ = false;
@@ -64,7 +69,8 @@ private:
     std::vector<float> history_;
     std::vector<float> column_buffer_;
 
-    std::vector<std::string> glyphs_;
+    std::vector<GlyphId> glyphs_;
+    CellPainter painter_;
     std::string glyphs_file_path_;
     bool glyphs_loaded_ = false;
 };
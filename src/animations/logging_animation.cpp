@@ -1,5 +1,6 @@
 #include "logging_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 
 #include <algorithm>
 #include <cctype>
@@ -189,16 +190,16 @@ void LoggingAnimation::init(notcurses* nc, const AppConfig& config) {
             messages_file_path_ = matched_config->text_file_path;
         }
         if (matched_config->plane_rows) {
-            plane_rows_ = std::max(3, *matched_config->plane_rows);
+            requested_rows_ = std::max(3, *matched_config->plane_rows);
         }
         if (matched_config->plane_cols) {
-            plane_cols_ = std::max(6, *matched_config->plane_cols);
+            requested_cols_ = std::max(6, *matched_config->plane_cols);
         }
         if (matched_config->plane_y) {
-            plane_origin_y_ = *matched_config->plane_y;
+            requested_origin_y_ = *matched_config->plane_y;
         }
         if (matched_config->plane_x) {
-            plane_origin_x_ = *matched_config->plane_x;
+            requested_origin_x_ = *matched_config->plane_x;
         }
     }
 
@@ -222,7 +223,7 @@ void LoggingAnimation::init(notcurses* nc, const AppConfig& config) {
         append_next_line();
         time_since_last_line_ = 0.0f;
     }
-    needs_redraw_ = true;
+    mark_dirty();
 }
 
 void LoggingAnimation::ensure_plane(notcurses* nc) {
@@ -244,11 +245,7 @@ void LoggingAnimation::ensure_plane(notcurses* nc) {
     unsigned int parent_cols = 0;
     ncplane_dim_yx(stdplane, &parent_rows, &parent_cols);
 
-    plane_rows_ = clamp_dimension(plane_rows_, 3, static_cast<int>(parent_rows));
-    plane_cols_ = clamp_dimension(plane_cols_, 6, static_cast<int>(parent_cols));
-
-    plane_origin_y_ = safe_origin(plane_origin_y_, plane_rows_, static_cast<int>(parent_rows));
-    plane_origin_x_ = safe_origin(plane_origin_x_, plane_cols_, static_cast<int>(parent_cols));
+    layout_plane(parent_rows, parent_cols);
 
     ncplane_options opts{};
     opts.y = plane_origin_y_;
@@ -269,21 +266,43 @@ void LoggingAnimation::ensure_plane(notcurses* nc) {
     ncplane_set_bg_rgb8(plane_, 0, 0, 0);
 }
 
+void LoggingAnimation::layout_plane(unsigned int parent_rows, unsigned int parent_cols) {
+    plane_rows_ = clamp_dimension(requested_rows_, 3, static_cast<int>(parent_rows));
+    plane_cols_ = clamp_dimension(requested_cols_, 6, static_cast<int>(parent_cols));
+
+    plane_origin_y_ = safe_origin(requested_origin_y_, plane_rows_, static_cast<int>(parent_rows));
+    plane_origin_x_ = safe_origin(requested_origin_x_, plane_cols_, static_cast<int>(parent_cols));
+}
+
+void LoggingAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
+    if (!plane_) {
+        return;
+    }
+
+    const int old_rows = plane_rows_;
+    const int old_cols = plane_cols_;
+    layout_plane(std_rows, std_cols);
+    if (ncplane_move_yx(plane_, plane_origin_y_, plane_origin_x_) != 0) {
+        return;
+    }
+    if (plane_rows_ != old_rows || plane_cols_ != old_cols) {
+        if (ncplane_resize_simple(plane_,
+                                  static_cast<unsigned>(plane_rows_),
+                                  static_cast<unsigned>(plane_cols_)) != 0) {
+            return;
+        }
+        // Rewraps the kept entries for the new width on the next redraw.
+        recalculate_content_geometry();
+    }
+    mark_dirty();
+}
+
 void LoggingAnimation::load_messages() {
     messages_.clear();
     sequential_indices_.clear();
 
-    std::ifstream file(messages_file_path_);
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            if (line.empty()) {
-                continue;
-            }
-
+    if (const auto lines = AssetCache::instance().lines(messages_file_path_)) {
+        for (const std::string& line : *lines) {
             MessageEntry entry;
             entry.text = line;
             entry.tags = extract_tags(line);
@@ -373,7 +392,7 @@ void LoggingAnimation::append_next_line() {
 void LoggingAnimation::append_log_entry(const std::string& entry) {
     visible_entries_.push_back(entry);
     trim_history();
-    needs_redraw_ = true;
+    mark_dirty();
 }
 
 void LoggingAnimation::trim_history() {
@@ -700,7 +719,6 @@ void LoggingAnimation::redraw() {
     ncplane_erase(plane_);
     draw_border();
     draw_logs();
-    needs_redraw_ = false;
 }
 
 void LoggingAnimation::render(notcurses* nc) {
@@ -709,9 +727,7 @@ void LoggingAnimation::render(notcurses* nc) {
         return;
     }
 
-    if (needs_redraw_) {
-        redraw();
-    }
+    redraw();
 }
 
 void LoggingAnimation::activate() {
@@ -735,7 +751,7 @@ void LoggingAnimation::activate() {
     latest_metrics_ = {};
     next_peak_report_threshold_ = 0.2f;
     highest_peak_observed_ = 0.0f;
-    needs_redraw_ = true;
+    mark_dirty();
 }
 
 void LoggingAnimation::deactivate() {
@@ -751,13 +767,17 @@ void LoggingAnimation::deactivate() {
     }
     has_latest_metrics_ = false;
     audio_state_initialized_ = false;
-    needs_redraw_ = false;
+    clear_damage();
 }
 
 void LoggingAnimation::bind_events(const AnimationConfig& config, events::EventBus& bus) {
     bind_standard_frame_updates(this, config, bus);
     auto handle = bus.subscribe<events::BeatDetectedEvent>(
-        [this](const events::BeatDetectedEvent& event) { handle_beat_event(event.strength); });
+        [this, config = &config](const events::BeatDetectedEvent& event) {
+            if (matches_analysis(*config, event.source_id, event.source_index, event.profile)) {
+                handle_beat_event(event.strength);
+            }
+        });
     track_subscription(std::move(handle));
 }
 
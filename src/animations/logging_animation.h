@@ -31,8 +31,11 @@ public:
     bool is_active() const override { return is_active_; }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool tracks_damage() const override { return true; }
+    std::optional<std::vector<std::size_t>> required_bands() const override { return std::vector<std::size_t>{}; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     struct Condition {
@@ -65,6 +68,7 @@ private:
 
     void load_messages();
     void ensure_plane(notcurses* nc);
+    void layout_plane(unsigned int parent_rows, unsigned int parent_cols);
     void recalculate_content_geometry();
     void append_next_line();
     void append_log_entry(const std::string& entry);
@@ -92,6 +96,12 @@ private:
     int padding_y_ = 1;
     int padding_x_ = 2;
 
+    // As configured; plane_* is what fits the current terminal.
+    int requested_rows_ = 16;
+    int requested_cols_ = 60;
+    int requested_origin_y_ = 0;
+    int requested_origin_x_ = 0;
+
     int plane_rows_ = 16;
     int plane_cols_ = 60;
     int plane_origin_y_ = 0;
@@ -109,7 +119,6 @@ private:
 
     float line_interval_s_ = 0.4f;
     float time_since_last_line_ = 0.0f;
-    bool needs_redraw_ = true;
 
     std::string messages_file_path_;
     std::string title_;
@@ -0,0 +1,124 @@
+#include "pixel_framebuffer.h"
+
+#include <algorithm>
+
+namespace why {
+namespace animations {
+
+namespace {
+
+bool can_blit(notcurses* nc, ncblitter_e blitter) {
+    switch (blitter) {
+        case NCBLIT_PIXEL:
+            return notcurses_check_pixel_support(nc) > 0;
+        case NCBLIT_3x2:
+            return notcurses_cansextant(nc);
+        case NCBLIT_BRAILLE:
+            return notcurses_canbraille(nc);
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+bool PixelFramebuffer::configure(notcurses* nc, const std::string& requested) {
+    enabled_ = false;
+    if (!nc || requested.empty() || requested == "cells") {
+        return false;
+    }
+
+    std::vector<ncblitter_e> candidates;
+    if (requested == "auto") {
+        candidates = {NCBLIT_PIXEL, NCBLIT_3x2, NCBLIT_BRAILLE};
+    } else if (requested == "pixel") {
+        candidates = {NCBLIT_PIXEL};
+    } else if (requested == "sextant") {
+        candidates = {NCBLIT_3x2};
+    } else if (requested == "braille") {
+        candidates = {NCBLIT_BRAILLE};
+    } else {
+        return false;
+    }
+
+    for (ncblitter_e candidate : candidates) {
+        if (can_blit(nc, candidate)) {
+            blitter_ = candidate;
+            enabled_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PixelFramebuffer::resize(ncplane* plane, unsigned int rows, unsigned int cols) {
+    switch (blitter_) {
+        case NCBLIT_BRAILLE:
+            scale_y_ = 4;
+            scale_x_ = 2;
+            break;
+        case NCBLIT_3x2:
+            scale_y_ = 3;
+            scale_x_ = 2;
+            break;
+        case NCBLIT_PIXEL: {
+            unsigned int cell_y = 0;
+            unsigned int cell_x = 0;
+            ncplane_pixel_geom(plane, nullptr, nullptr, &cell_y, &cell_x, nullptr, nullptr);
+            scale_y_ = std::max(1u, cell_y);
+            scale_x_ = std::max(1u, cell_x);
+            break;
+        }
+        default:
+            scale_y_ = 1;
+            scale_x_ = 1;
+            break;
+    }
+    height_ = rows * scale_y_;
+    width_ = cols * scale_x_;
+    rgba_.assign(static_cast<std::size_t>(height_) * width_ * 4u, 0u);
+}
+
+void PixelFramebuffer::clear() {
+    std::fill(rgba_.begin(), rgba_.end(), 0u);
+}
+
+void PixelFramebuffer::fill_rect(unsigned int y,
+                                 unsigned int x,
+                                 unsigned int rows,
+                                 unsigned int cols,
+                                 std::uint32_t rgb) {
+    const unsigned int end_y = std::min(height_, y + rows);
+    const unsigned int end_x = std::min(width_, x + cols);
+    for (unsigned int row = y; row < end_y; ++row) {
+        for (unsigned int col = x; col < end_x; ++col) {
+            set(row, col, rgb);
+        }
+    }
+}
+
+bool PixelFramebuffer::blit(notcurses* nc, ncplane* plane) {
+    if (!enabled_ || !nc || !plane || height_ == 0u || width_ == 0u) {
+        return false;
+    }
+
+    ncvisual* visual = ncvisual_from_rgba(rgba_.data(),
+                                          static_cast<int>(height_),
+                                          static_cast<int>(width_ * 4u),
+                                          static_cast<int>(width_));
+    if (!visual) {
+        return false;
+    }
+
+    ncvisual_options vopts{};
+    vopts.n = plane;
+    vopts.scaling = NCSCALE_NONE;
+    vopts.blitter = blitter_;
+    vopts.flags = NCVISUAL_OPTION_NODEGRADE;
+    const bool ok = ncvisual_blit(nc, visual, &vopts) != nullptr;
+    ncvisual_destroy(visual);
+    return ok;
+}
+
+} // namespace animations
+} // namespace why
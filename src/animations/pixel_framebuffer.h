@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <notcurses/notcurses.h>
+
+namespace why {
+namespace animations {
+
+// Offscreen RGBA image at sub-cell resolution, pushed to a plane with a single
+// ncvisual_blit() per frame. Depending on the blitter each cell carries 2x4 (braille),
+// 2x3 (sextant) or a full cell's worth of pixels (sixel/kitty), instead of one glyph.
+//
+// Pixels with zero alpha are left untouched on the plane, so whatever sits below shows
+// through exactly as it does around glyph-drawn shapes.
+class PixelFramebuffer {
+public:
+    // Selects `requested` ("braille", "sextant", "pixel" or "auto" for the finest one
+    // available). Returns false and stays disabled for "cells", unknown names and
+    // blitters the terminal cannot draw.
+    bool configure(notcurses* nc, const std::string& requested);
+    bool enabled() const { return enabled_; }
+
+    // Sizes the image to cover `rows` x `cols` cells of `plane` and clears it.
+    void resize(ncplane* plane, unsigned int rows, unsigned int cols);
+    unsigned int height() const { return height_; }
+    unsigned int width() const { return width_; }
+    // Pixels per cell in each direction.
+    unsigned int scale_y() const { return scale_y_; }
+    unsigned int scale_x() const { return scale_x_; }
+
+    void clear();
+
+    void set(unsigned int y, unsigned int x, std::uint32_t rgb, std::uint8_t alpha = 255) {
+        if (y >= height_ || x >= width_) {
+            return;
+        }
+        std::uint8_t* px = rgba_.data() + (static_cast<std::size_t>(y) * width_ + x) * 4u;
+        px[0] = static_cast<std::uint8_t>(rgb >> 16);
+        px[1] = static_cast<std::uint8_t>(rgb >> 8);
+        px[2] = static_cast<std::uint8_t>(rgb);
+        px[3] = alpha;
+    }
+
+    void fill_rect(unsigned int y, unsigned int x, unsigned int rows, unsigned int cols, std::uint32_t rgb);
+
+    // Blits the image onto `plane` at its origin. The caller erases the plane first.
+    bool blit(notcurses* nc, ncplane* plane);
+
+private:
+    bool enabled_ = false;
+    ncblitter_e blitter_ = NCBLIT_DEFAULT;
+    unsigned int scale_y_ = 1;
+    unsigned int scale_x_ = 1;
+    unsigned int height_ = 0;
+    unsigned int width_ = 0;
+    std::vector<std::uint8_t> rgba_;
+};
+
+} // namespace animations
+} // namespace why
@@ -0,0 +1,56 @@
+#include "plane_layout.h"
+
+namespace why {
+namespace animations {
+
+PlaneGeometry fit_plane(const PlaneRequest& request, unsigned int std_rows, unsigned int std_cols) {
+    PlaneGeometry geometry;
+    geometry.y = std_rows > 0u ? std::clamp(request.y, 0, static_cast<int>(std_rows) - 1) : 0;
+    geometry.x = std_cols > 0u ? std::clamp(request.x, 0, static_cast<int>(std_cols) - 1) : 0;
+
+    const unsigned int available_rows = std_rows > static_cast<unsigned int>(geometry.y)
+                                            ? std_rows - static_cast<unsigned int>(geometry.y)
+                                            : 0u;
+    const unsigned int available_cols = std_cols > static_cast<unsigned int>(geometry.x)
+                                            ? std_cols - static_cast<unsigned int>(geometry.x)
+                                            : 0u;
+    geometry.rows = request.rows && available_rows > 0u ? std::clamp(*request.rows, 1u, available_rows)
+                                                        : available_rows;
+    geometry.cols = request.cols && available_cols > 0u ? std::clamp(*request.cols, 1u, available_cols)
+                                                        : available_cols;
+
+    if (geometry.rows == 0u) {
+        geometry.rows = std_rows;
+        geometry.y = 0;
+    }
+    if (geometry.cols == 0u) {
+        geometry.cols = std_cols;
+        geometry.x = 0;
+    }
+    return geometry;
+}
+
+PlaneGeometry fit_plane_loose(const PlaneRequest& request, unsigned int std_rows, unsigned int std_cols) {
+    PlaneGeometry geometry;
+    geometry.y = std::clamp(request.y, 0, static_cast<int>(std_rows));
+    geometry.x = std::clamp(request.x, 0, static_cast<int>(std_cols));
+    geometry.rows = request.rows && *request.rows > 0u && *request.rows <= std_rows ? *request.rows : std_rows;
+    geometry.cols = request.cols && *request.cols > 0u && *request.cols <= std_cols ? *request.cols : std_cols;
+    return geometry;
+}
+
+bool apply_plane_geometry(ncplane* plane, const PlaneGeometry& geometry) {
+    if (!plane || geometry.rows == 0u || geometry.cols == 0u) {
+        return false;
+    }
+    int y = 0;
+    int x = 0;
+    ncplane_yx(plane, &y, &x);
+    if ((y != geometry.y || x != geometry.x) && ncplane_move_yx(plane, geometry.y, geometry.x) != 0) {
+        return false;
+    }
+    return ncplane_resize_simple(plane, geometry.rows, geometry.cols) == 0;
+}
+
+} // namespace animations
+} // namespace why
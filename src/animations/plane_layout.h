@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <notcurses/notcurses.h>
+
+namespace why {
+namespace animations {
+
+// Where an [[animations]] entry asked for its plane: an origin, and a size that is
+// either given or fills the rest of the screen.
+struct PlaneRequest {
+    int y = 0;
+    int x = 0;
+    std::optional<unsigned int> rows; // Unset fills down to the bottom edge
+    std::optional<unsigned int> cols; // Unset fills across to the right edge
+};
+
+struct PlaneGeometry {
+    int y = 0;
+    int x = 0;
+    unsigned int rows = 0;
+    unsigned int cols = 0;
+};
+
+// Fits `request` onto a std_rows x std_cols standard plane: the origin is clamped onto
+// it and the size to what is left below and right of the origin. A dimension with
+// nothing left falls back to the whole screen from 0.
+PlaneGeometry fit_plane(const PlaneRequest& request, unsigned int std_rows, unsigned int std_cols);
+
+// The looser rule Breathe and LightningWave have always used: an unset size, or one
+// larger than the screen, becomes the whole screen, and the origin is clamped to
+// [0, std_rows] x [0, std_cols] without shrinking the size to fit below it.
+PlaneGeometry fit_plane_loose(const PlaneRequest& request, unsigned int std_rows, unsigned int std_cols);
+
+// Moves and resizes `plane` to `geometry`. ncplane_resize_simple() keeps the cells that
+// still fit, anchored at the top left. Returns false when notcurses refused.
+bool apply_plane_geometry(ncplane* plane, const PlaneGeometry& geometry);
+
+// Carries a row-major grid over to a new size: old cell (r, c) moves to
+// (r + row_offset, c + col_offset) when that is inside the new grid; every other new
+// cell is `fill`. Offsets place the old contents, e.g. centred or right-aligned.
+template<typename T>
+void remap_grid(std::vector<T>& grid,
+                unsigned int old_rows,
+                unsigned int old_cols,
+                unsigned int rows,
+                unsigned int cols,
+                const T& fill,
+                int row_offset = 0,
+                int col_offset = 0) {
+    if (old_rows == rows && old_cols == cols && row_offset == 0 && col_offset == 0 &&
+        grid.size() == static_cast<std::size_t>(rows) * cols) {
+        return;
+    }
+    std::vector<T> remapped(static_cast<std::size_t>(rows) * cols, fill);
+    if (grid.size() == static_cast<std::size_t>(old_rows) * old_cols) {
+        const int first_row = std::max(0, -row_offset);
+        const int last_row = std::min(static_cast<int>(old_rows), static_cast<int>(rows) - row_offset);
+        const int first_col = std::max(0, -col_offset);
+        const int last_col = std::min(static_cast<int>(old_cols), static_cast<int>(cols) - col_offset);
+        for (int row = first_row; row < last_row; ++row) {
+            if (first_col >= last_col) {
+                break;
+            }
+            const auto source = grid.begin() + static_cast<std::ptrdiff_t>(row) * old_cols + first_col;
+            std::copy(source,
+                      source + (last_col - first_col),
+                      remapped.begin() + static_cast<std::ptrdiff_t>(row + row_offset) * cols + first_col + col_offset);
+        }
+    }
+    grid.swap(remapped);
+}
+
+} // namespace animations
+} // namespace why
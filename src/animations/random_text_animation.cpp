@@ -2,10 +2,10 @@
 #include <algorithm>
 #include <cctype>
 #include <cmath>
-#include <fstream>
 
 #include "random_text_animation.h"
 #include "animation_event_utils.h"
+#include "asset_cache.h"
 
 namespace why {
 namespace animations {
@@ -22,13 +22,11 @@ RandomTextAnimation::~RandomTextAnimation() {
 
 void RandomTextAnimation::init(notcurses* nc, const AppConfig& config) {
     ncplane* stdplane = notcurses_stdplane(nc);
-    unsigned int plane_rows = 0;
-    unsigned int plane_cols = 0;
-    ncplane_dim_yx(stdplane, &plane_rows, &plane_cols);
+    ncplane_dim_yx(stdplane, &plane_rows_, &plane_cols_);
 
     ncplane_options p_opts{};
-    p_opts.rows = plane_rows;
-    p_opts.cols = plane_cols;
+    p_opts.rows = plane_rows_;
+    p_opts.cols = plane_cols_;
     p_opts.y = 0;
     p_opts.x = 0;
     plane_ = ncplane_create(stdplane, &p_opts);
@@ -137,6 +135,7 @@ void RandomTextAnimation::update(float delta_time,
     // Always update existing lines, regardless of whether the animation is currently spawning new ones
     for (auto& line : active_lines_) {
         if (!line.completed) {
+            const std::size_t revealed_before = line.revealed_chars;
             if (line.char_interval <= 0.0f || type_speed_words_per_s_ <= 0.0f) {
                 line.revealed_chars = line.text.size();
                 line.completed = true;
@@ -153,6 +152,9 @@ void RandomTextAnimation::update(float delta_time,
                     line.time_since_last_char = 0.0f;
                 }
             }
+            if (line.revealed_chars != revealed_before) {
+                mark_line_dirty(line);
+            }
         } else if (!line.fading_out) {
             line.display_elapsed += delta_time;
             if (line.display_elapsed >= display_duration_s_) {
@@ -161,6 +163,7 @@ void RandomTextAnimation::update(float delta_time,
             }
         } else {
             line.fade_elapsed += delta_time;
+            mark_line_dirty(line); // Dims every frame
         }
     }
 
@@ -171,18 +174,17 @@ void RandomTextAnimation::update(float delta_time,
                             if (!line.fading_out) {
                                 return false;
                             }
-                            if (fade_duration_s_ <= 0.0f) {
-                                return true;
+                            if (fade_duration_s_ > 0.0f && line.fade_elapsed < fade_duration_s_) {
+                                return false;
                             }
-                            return line.fade_elapsed >= fade_duration_s_;
+                            mark_line_dirty(line);
+                            return true;
                         }),
         active_lines_.end());
 
     if (had_lines_before_update && active_lines_.empty()) {
         plane_needs_clear_ = true;
     }
-
-    clamp_line_positions();
 }
 
 void RandomTextAnimation::render(notcurses* nc) {
@@ -190,15 +192,24 @@ void RandomTextAnimation::render(notcurses* nc) {
 
     (void)nc;
 
-    ncplane_erase(plane_);
+    erase_damage(plane_);
     plane_needs_clear_ = false;
 
-    unsigned int plane_rows = 0;
-    unsigned int plane_cols = 0;
-    ncplane_dim_yx(plane_, &plane_rows, &plane_cols);
+    const unsigned int plane_rows = plane_rows_;
+    const unsigned int plane_cols = plane_cols_;
 
     ncplane_set_bg_rgb8(plane_, 0, 0, 0);
 
+    const auto row_damaged = [this](int row) {
+        if (fully_damaged()) {
+            return true;
+        }
+        return std::any_of(damaged_rows().begin(), damaged_rows().end(), [row](const RowSpan& span) {
+            return row >= static_cast<int>(span.begin) && row < static_cast<int>(span.end);
+        });
+    };
+
+    // Lines sharing a damaged row are all repainted, in order, so overlaps stay as they were.
     for (const auto& line : active_lines_) {
         if (line.revealed_chars == 0 || line.text.empty()) {
             continue;
@@ -213,6 +224,9 @@ void RandomTextAnimation::render(notcurses* nc) {
         ncplane_set_fg_rgb8(plane_, intensity, intensity, intensity);
 
         int y = plane_rows > 0 ? std::clamp(line.y_pos, 0, static_cast<int>(plane_rows) - 1) : 0;
+        if (!row_damaged(y)) {
+            continue;
+        }
         int max_x = plane_cols > 0 ? static_cast<int>(plane_cols) - 1 : 0;
         int x = std::clamp(line.x_pos, 0, std::max(0, max_x));
 
@@ -230,13 +244,12 @@ void RandomTextAnimation::load_quotes() {
     };
 
     auto try_load = [&](const std::string& path) {
-        std::ifstream file(path);
-        if (!file.is_open()) {
+        const auto lines = AssetCache::instance().lines(path);
+        if (!lines) {
             return false;
         }
 
-        std::string line;
-        while (std::getline(file, line)) {
+        for (const std::string& line : *lines) {
             std::string cleaned = trim(line);
             if (!cleaned.empty()) {
                 quotes_.push_back(cleaned);
@@ -274,6 +287,7 @@ void RandomTextAnimation::spawn_line() {
     }
 
     if (static_cast<int>(active_lines_.size()) >= max_active_lines_) {
+        mark_line_dirty(active_lines_.front());
         active_lines_.erase(active_lines_.begin());
     }
 
@@ -285,9 +299,8 @@ void RandomTextAnimation::spawn_line() {
 
     line.char_interval = compute_char_interval(line.text);
 
-    unsigned int plane_rows = 0;
-    unsigned int plane_cols = 0;
-    ncplane_dim_yx(plane_, &plane_rows, &plane_cols);
+    const unsigned int plane_rows = plane_rows_;
+    const unsigned int plane_cols = plane_cols_;
 
     if (plane_rows > 0) {
         const int max_row_index = static_cast<int>(plane_rows) - 1;
@@ -312,24 +325,43 @@ void RandomTextAnimation::spawn_line() {
         line.x_pos = 0;
     }
 
+    mark_line_dirty(line);
     active_lines_.push_back(std::move(line));
 }
 
-void RandomTextAnimation::clamp_line_positions() {
-    if (!plane_) {
+void RandomTextAnimation::mark_line_dirty(const DisplayedLine& line) {
+    mark_row_dirty(static_cast<unsigned int>(std::max(0, line.y_pos)));
+}
+
+void RandomTextAnimation::on_resize(unsigned int std_rows, unsigned int std_cols) {
+    if (!plane_ || std_rows == 0u || std_cols == 0u) {
         return;
     }
+    if (std_rows == plane_rows_ && std_cols == plane_cols_) {
+        return;
+    }
+    if (ncplane_resize_simple(plane_, std_rows, std_cols) != 0) {
+        return;
+    }
+    plane_rows_ = std_rows;
+    plane_cols_ = std_cols;
+    clamp_line_positions();
+    mark_dirty();
+}
 
-    unsigned int plane_rows = 0;
-    unsigned int plane_cols = 0;
-    ncplane_dim_yx(plane_, &plane_rows, &plane_cols);
-
-    const int max_y = plane_rows > 0 ? static_cast<int>(plane_rows) - 1 : 0;
-    const int max_x = plane_cols > 0 ? static_cast<int>(plane_cols) - 1 : 0;
+void RandomTextAnimation::clamp_line_positions() {
+    const int max_y = plane_rows_ > 0 ? static_cast<int>(plane_rows_) - 1 : 0;
+    const int max_x = plane_cols_ > 0 ? static_cast<int>(plane_cols_) - 1 : 0;
 
     for (auto& line : active_lines_) {
-        line.y_pos = std::clamp(line.y_pos, 0, std::max(0, max_y));
-        line.x_pos = std::clamp(line.x_pos, 0, std::max(0, max_x));
+        const int y = std::clamp(line.y_pos, 0, std::max(0, max_y));
+        const int x = std::clamp(line.x_pos, 0, std::max(0, max_x));
+        if (y != line.y_pos || x != line.x_pos) {
+            // The plane shrank under the line.
+            line.y_pos = y;
+            line.x_pos = x;
+            mark_dirty();
+        }
     }
 }
 
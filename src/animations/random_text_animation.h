@@ -29,8 +29,11 @@ public:
     bool is_active() const override { return is_active_ || !active_lines_.empty() || plane_needs_clear_; }
     int get_z_index() const override { return z_index_; }
     ncplane* get_plane() const override { return plane_; }
+    bool tracks_damage() const override { return true; }
+    std::optional<std::vector<std::size_t>> required_bands() const override { return std::vector<std::size_t>{}; }
 
     void bind_events(const AnimationConfig& config, events::EventBus& bus) override;
+    void on_resize(unsigned int std_rows, unsigned int std_cols) override;
 
 private:
     struct DisplayedLine {
@@ -49,6 +52,7 @@ private:
     void load_quotes();
     void spawn_line();
     void clamp_line_positions();
+    void mark_line_dirty(const DisplayedLine& line);
     float compute_char_interval(const std::string& text) const;
     std::string select_random_quote();
 
@@ -57,6 +61,8 @@ private:
     std::vector<std::string> quotes_;
     std::vector<DisplayedLine> active_lines_;
     ncplane* plane_ = nullptr;
+    unsigned int plane_rows_ = 0; // Always the whole standard plane
+    unsigned int plane_cols_ = 0;
     int z_index_ = 0;
     bool is_active_ = true; // New: internal active state
     bool plane_needs_clear_ = false;
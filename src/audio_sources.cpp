@@ -0,0 +1,322 @@
+#include "audio_sources.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "events/frame_events.h"
+
+namespace why {
+
+namespace {
+
+constexpr const char* kDefaultSourceId = "main";
+
+} // namespace
+
+AudioSource::AudioSource(std::string id,
+                         const AppConfig& config,
+                         std::string file_path,
+                         std::string device,
+                         bool system_audio,
+                         ma_uint32 channels,
+                         bool capture_enabled)
+    : id_(std::move(id)),
+      wants_audio_(!file_path.empty() || capture_enabled),
+      auto_sparse_(config.dsp.auto_sparse),
+      engine_(config.audio.capture.sample_rate,
+              channels,
+              std::max<std::size_t>(1024, config.audio.capture.ring_frames),
+              file_path,
+              std::move(device),
+              system_audio),
+      dsp_(config.audio.capture.sample_rate,
+           channels,
+           config.dsp.fft_size,
+           config.dsp.hop_size,
+           config.dsp.bands,
+           config.dsp.specialized_kernels,
+           config.dsp.zero_pad_factor),
+      scratch_(std::max<std::size_t>(4096,
+                                     std::max<std::size_t>(1024, config.audio.capture.ring_frames) *
+                                         static_cast<std::size_t>(channels))),
+      // The sidecar only stores the mixed bands, so HPSS keeps the source on live analysis.
+      track_path_(config.audio.file.analysis_cache && !config.dsp.hpss ? file_path : std::string{}),
+      file_path_(std::move(file_path)),
+      analysis_cache_enabled_(config.audio.file.analysis_cache),
+      cache_directory_(config.audio.file.cache_directory) {
+    configure_dsp(config);
+
+    analysis_settings_.sample_rate = config.audio.capture.sample_rate;
+    analysis_settings_.fft_size = config.dsp.fft_size;
+    analysis_settings_.hop_size = config.dsp.hop_size;
+    analysis_settings_.bands = config.dsp.bands;
+    analysis_settings_.specialized_kernels = config.dsp.specialized_kernels;
+    analysis_settings_.zero_pad_factor = config.dsp.zero_pad_factor;
+}
+
+void AudioSource::configure_dsp(const AppConfig& config) {
+    for (const DspProfileConfig& profile : config.dsp.profiles) {
+        dsp_.add_profile(profile.name, profile.fft_size, profile.hop_size, profile.bands, profile.zero_pad_factor);
+    }
+    if (config.dsp.hpss) {
+        for (std::size_t profile = 0; profile < dsp_.profile_count(); ++profile) {
+            dsp_.profile(profile).enable_hpss(config.dsp.hpss_time_kernel, config.dsp.hpss_frequency_kernel);
+        }
+    }
+    if (config.dsp.pitch_tracking) {
+        dsp_.enable_pitch_tracking(config.dsp.pitch_min_hz, config.dsp.pitch_max_hz);
+    }
+    subscribed_.assign(dsp_.profile_count(), false);
+    subscribed_[0] = true;
+    update_live_profiles();
+}
+
+void AudioSource::reconfigure_dsp(const AppConfig& config) {
+    auto_sparse_ = config.dsp.auto_sparse;
+    dsp_ = DspEngine(analysis_settings_.sample_rate,
+                     engine_.channels(),
+                     config.dsp.fft_size,
+                     config.dsp.hop_size,
+                     config.dsp.bands,
+                     config.dsp.specialized_kernels,
+                     config.dsp.zero_pad_factor);
+    configure_dsp(config);
+
+    AnalysisSettings settings = analysis_settings_;
+    settings.fft_size = config.dsp.fft_size;
+    settings.hop_size = config.dsp.hop_size;
+    settings.bands = config.dsp.bands;
+    settings.specialized_kernels = config.dsp.specialized_kernels;
+    settings.zero_pad_factor = config.dsp.zero_pad_factor;
+    const std::string track_path = analysis_cache_enabled_ && !config.dsp.hpss ? file_path_ : std::string{};
+    if (settings == analysis_settings_ && track_path == track_path_) {
+        return;
+    }
+
+    join_cache_thread();
+    cancel_cache_.store(false, std::memory_order_relaxed);
+    cache_ready_.store(false, std::memory_order_relaxed);
+    cache_active_ = false;
+    analysis_settings_ = settings;
+    track_path_ = track_path;
+    update_live_profiles();
+    if (metrics_.active) {
+        start_cache_thread();
+    }
+}
+
+AudioSource::~AudioSource() {
+    join_cache_thread();
+}
+
+bool AudioSource::start() {
+    if (!wants_audio_) {
+        return false;
+    }
+    metrics_.active = engine_.start();
+    if (!metrics_.active) {
+        std::cerr << "[audio] failed to start audio backend for source '" << id_ << "'";
+        if (!engine_.last_error().empty()) {
+            std::cerr << ": " << engine_.last_error();
+        }
+        std::cerr << std::endl;
+    }
+
+    if (metrics_.active) {
+        start_cache_thread();
+    }
+    return metrics_.active;
+}
+
+void AudioSource::start_cache_thread() {
+    // The pre-pass decodes the whole track, so it runs off the frame loop; the source is
+    // analysed live until the cache is ready.
+    if (engine_.using_file_stream() && !track_path_.empty() && !cache_thread_.joinable()) {
+        cache_thread_ = std::thread([this]() {
+            std::string error;
+            if (load_or_build_analysis_cache(track_path_,
+                                             cache_directory_,
+                                             analysis_settings_,
+                                             cache_,
+                                             error,
+                                             &cancel_cache_)) {
+                cache_ready_.store(true, std::memory_order_release);
+            } else if (!cancel_cache_.load(std::memory_order_relaxed)) {
+                std::cerr << "[analysis] " << id_ << ": " << error << "; analysing live" << std::endl;
+            }
+        });
+    }
+}
+
+void AudioSource::stop() {
+    join_cache_thread();
+    engine_.stop();
+}
+
+void AudioSource::subscribe_profile(std::size_t profile,
+                                    bool subscribed,
+                                    const std::optional<std::vector<std::size_t>>& bands) {
+    if (profile >= subscribed_.size()) {
+        return;
+    }
+    subscribed_[profile] = subscribed;
+    update_live_profiles();
+
+    SpectrumAnalyzer& analyzer = dsp_.profile(profile);
+    if (!subscribed || !auto_sparse_) {
+        return;
+    }
+    analyzer.set_required_bands(bands);
+    if (analyzer.using_sparse_bank()) {
+        std::clog << "[dsp] source '" << id_ << "'";
+        if (!analyzer.name().empty()) {
+            std::clog << " profile '" << analyzer.name() << "'";
+        }
+        std::clog << " uses a Goertzel bank for " << analyzer.sparse_bin_count() << " bins" << std::endl;
+    }
+}
+
+const std::vector<float>& AudioSource::profile_bands(std::size_t profile) const {
+    if (profile == 0 && cache_active_) {
+        return cached_bands_;
+    }
+    return dsp_.profile(profile).band_energies();
+}
+
+float AudioSource::profile_beat_strength(std::size_t profile) const {
+    if (profile == 0 && cache_active_) {
+        return cached_beat_strength_;
+    }
+    return dsp_.profile(profile).beat_strength();
+}
+
+void AudioSource::update_live_profiles() {
+    // With a ready analysis cache the default profile is read from the sidecar, so only
+    // the extra profiles and the pitch tracker still need the live pipeline.
+    needs_live_analysis_ = dsp_.pitch_tracking();
+    for (std::size_t profile = 0; profile < subscribed_.size(); ++profile) {
+        const bool live = subscribed_[profile] && !(profile == 0 && cache_active_);
+        dsp_.profile(profile).set_active(live);
+        needs_live_analysis_ = needs_live_analysis_ || live;
+    }
+}
+
+void AudioSource::join_cache_thread() {
+    if (cache_thread_.joinable()) {
+        cancel_cache_.store(true, std::memory_order_relaxed);
+        cache_thread_.join();
+    }
+}
+
+void AudioSource::process() {
+    last_read_time_ = {};
+    if (!metrics_.active) {
+        return;
+    }
+
+    if (!cache_active_ && cache_ready_.load(std::memory_order_acquire)) {
+        cache_active_ = true;
+        cached_bands_.assign(cache_.band_count(), 0.0f);
+        update_live_profiles();
+    }
+
+    const auto read_start = std::chrono::steady_clock::now();
+    const std::size_t samples_read = engine_.read_samples(scratch_.data(), scratch_.size());
+    last_read_time_ = std::chrono::steady_clock::now() - read_start;
+    consumed_frames_ += samples_read / engine_.channels();
+    if (cache_active_) {
+        analysis_hop_ = cache_.hop_for_frame(consumed_frames_);
+        const AnalysisHop hop = cache_.hop(analysis_hop_);
+        std::copy(hop.bands, hop.bands + cached_bands_.size(), cached_bands_.begin());
+        cached_beat_strength_ = hop.beat_strength;
+    }
+
+    if (samples_read > 0) {
+        if (needs_live_analysis_) {
+            dsp_.push_samples(scratch_.data(), samples_read);
+        }
+        double sum_squares = 0.0;
+        float peak_value = 0.0f;
+        for (std::size_t i = 0; i < samples_read; ++i) {
+            const float sample = scratch_[i];
+            sum_squares += static_cast<double>(sample) * static_cast<double>(sample);
+            peak_value = std::max(peak_value, std::abs(sample));
+        }
+        const float rms_instant = std::sqrt(sum_squares / static_cast<double>(samples_read));
+        metrics_.rms = metrics_.rms * 0.9f + rms_instant * 0.1f;
+        metrics_.peak = std::max(peak_value, metrics_.peak * 0.95f);
+    } else {
+        metrics_.rms *= 0.98f;
+        metrics_.peak *= 0.98f;
+    }
+    metrics_.dropped = engine_.dropped_samples();
+
+    if (event_bus_ && dsp_.pitch_tracking()) {
+        event_bus_->post(events::PitchEvent{dsp_.pitch_frequency(), dsp_.pitch_confidence(), id_, index_});
+    }
+}
+
+std::vector<std::unique_ptr<AudioSource>> create_audio_sources(const AppConfig& config,
+                                                               const AudioSourceOverrides& overrides) {
+    std::vector<AudioSourceConfig> source_configs;
+    for (const AudioSourceConfig& source_config : config.audio.sources) {
+        if (source_config.enabled) {
+            source_configs.push_back(source_config);
+        }
+    }
+
+    // Without [[audio.sources]] the [audio.capture] / [audio.file] sections describe a
+    // single source, matching the behaviour before multi-source support.
+    const bool synthesized = source_configs.empty();
+    if (synthesized) {
+        AudioSourceConfig source_config;
+        source_config.id = kDefaultSourceId;
+        source_config.device = config.audio.capture.device;
+        source_config.system = config.audio.capture.system;
+        if (config.audio.prefer_file && config.audio.file.enabled) {
+            source_config.file = config.audio.file.path;
+        }
+        source_configs.push_back(source_config);
+    }
+
+    AudioSourceConfig& primary = source_configs.front();
+    if (!overrides.file_path.empty()) {
+        primary.file = overrides.file_path;
+    }
+    if (!overrides.device.empty()) {
+        primary.device = overrides.device;
+    }
+    if (overrides.system == 1) {
+        primary.system = true;
+    } else if (overrides.system == 0) {
+        primary.system = false;
+    }
+
+    std::vector<std::unique_ptr<AudioSource>> sources;
+    sources.reserve(source_configs.size());
+    for (const AudioSourceConfig& source_config : source_configs) {
+        const bool use_file_stream = !source_config.file.empty() && (!synthesized || config.audio.file.enabled);
+        ma_uint32 channels = source_config.channels;
+        if (channels == 0) {
+            channels = use_file_stream ? config.audio.file.channels : config.audio.capture.channels;
+        }
+        if (channels == 0) {
+            channels = 1;
+        }
+
+        // Explicitly listed sources are always opened; the synthesized one honours
+        // audio.capture.enabled like the single-engine path did.
+        const bool capture_enabled = synthesized ? config.audio.capture.enabled : true;
+        sources.push_back(std::make_unique<AudioSource>(source_config.id,
+                                                        config,
+                                                        use_file_stream ? source_config.file : std::string{},
+                                                        source_config.device,
+                                                        source_config.system,
+                                                        channels,
+                                                        capture_enabled));
+    }
+    return sources;
+}
+
+} // namespace why
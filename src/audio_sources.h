@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis_cache.h"
+#include "audio_engine.h"
+#include "config.h"
+#include "dsp.h"
+
+namespace why {
+
+namespace events {
+class EventBus;
+} // namespace events
+
+// Command-line overrides; they apply to the first configured source.
+struct AudioSourceOverrides {
+    std::string file_path;
+    std::string device;
+    int system = -1; // -1 = use config, 0 = mic, 1 = system
+};
+
+// One capture device or file stream together with its own DSP pipeline.
+class AudioSource {
+public:
+    AudioSource(std::string id,
+                const AppConfig& config,
+                std::string file_path,
+                std::string device,
+                bool system_audio,
+                ma_uint32 channels,
+                bool capture_enabled);
+    ~AudioSource();
+
+    AudioSource(const AudioSource&) = delete;
+    AudioSource& operator=(const AudioSource&) = delete;
+
+    bool start();
+    void stop();
+
+    // Rebuilds the analysis from config.dsp (FFT sizes, profiles, HPSS, pitch tracking)
+    // while the audio stream keeps running. As after construction only the default
+    // profile is subscribed, so subscribe the others again afterwards. When the settings
+    // the analysis cache was built with changed, it is dropped and rebuilt in the
+    // background while the source is analysed live.
+    void reconfigure_dsp(const AppConfig& config);
+
+    // Drains the ring buffer and refreshes the level metrics and analysis. File sources
+    // with a ready analysis cache look the analysis up at the playback position instead
+    // of running the DSP pipeline. Sources share no state, so different sources may be
+    // processed concurrently.
+    void process();
+
+    // Events computed during process() (currently PitchEvent) are posted to `bus` from the
+    // processing thread and tagged with `index`; nullptr disables them.
+    void set_event_bus(events::EventBus* bus, std::size_t index) {
+        event_bus_ = bus;
+        index_ = index;
+    }
+
+    // Analysis profiles: 0 is the [dsp] default (named ""), followed by [dsp.profiles.*].
+    // Only subscribed profiles are computed. `bands` lists the bands subscribers read (see
+    // SpectrumAnalyzer::set_required_bands) and is ignored when dsp.auto_sparse is off.
+    void subscribe_profile(std::size_t profile,
+                           bool subscribed,
+                           const std::optional<std::vector<std::size_t>>& bands);
+    std::size_t profile_count() const { return dsp_.profile_count(); }
+    const std::string& profile_name(std::size_t profile) const { return dsp_.profile(profile).name(); }
+    bool profile_subscribed(std::size_t profile) const { return subscribed_[profile]; }
+    const std::vector<float>& profile_bands(std::size_t profile) const;
+    float profile_beat_strength(std::size_t profile) const;
+    // Harmonic/percussive band streams; empty unless dsp.hpss is enabled.
+    const std::vector<float>& profile_harmonic_bands(std::size_t profile) const {
+        return dsp_.profile(profile).harmonic_bands();
+    }
+    const std::vector<float>& profile_percussive_bands(std::size_t profile) const {
+        return dsp_.profile(profile).percussive_bands();
+    }
+
+    bool pitch_tracking() const { return dsp_.pitch_tracking(); }
+    float pitch_frequency() const { return dsp_.pitch_frequency(); }
+    float pitch_confidence() const { return dsp_.pitch_confidence(); }
+
+    const std::string& id() const { return id_; }
+    const AudioMetrics& metrics() const { return metrics_; }
+    const std::vector<float>& bands() const { return profile_bands(0); }
+    float beat_strength() const { return profile_beat_strength(0); }
+    bool using_file_stream() const { return engine_.using_file_stream(); }
+
+    // Whole-track analysis of the default profile and the hop matching the current playback
+    // position, or nullptr while the source is analysed live. Later hops can be read to
+    // anticipate the music.
+    const AnalysisCache* analysis() const { return cache_active_ ? &cache_ : nullptr; }
+    std::size_t analysis_hop() const { return analysis_hop_; }
+
+    // Time the last process() spent pulling samples from the engine; the rest of it was
+    // analysis.
+    std::chrono::steady_clock::duration last_read_time() const { return last_read_time_; }
+
+private:
+    void configure_dsp(const AppConfig& config);
+    void start_cache_thread();
+    void join_cache_thread();
+    void update_live_profiles();
+
+    std::string id_;
+    std::size_t index_ = 0;
+    events::EventBus* event_bus_ = nullptr;
+    bool wants_audio_;
+    bool auto_sparse_;
+    AudioEngine engine_;
+    DspEngine dsp_;
+    std::vector<bool> subscribed_;
+    bool needs_live_analysis_ = true;
+    std::vector<float> scratch_;
+    AudioMetrics metrics_{};
+
+    std::string track_path_;      // Empty when the source is never cached
+    std::string file_path_;       // As streamed; track_path_ is this or empty
+    bool analysis_cache_enabled_; // audio.file.analysis_cache at startup
+    std::string cache_directory_;
+    AnalysisSettings analysis_settings_;
+    AnalysisCache cache_;
+    std::thread cache_thread_;
+    std::atomic<bool> cache_ready_{false};
+    std::atomic<bool> cancel_cache_{false};
+    bool cache_active_ = false;
+    std::vector<float> cached_bands_;
+    float cached_beat_strength_ = 0.0f;
+    std::uint64_t consumed_frames_ = 0;
+    std::size_t analysis_hop_ = 0;
+    std::chrono::steady_clock::duration last_read_time_{};
+};
+
+std::vector<std::unique_ptr<AudioSource>> create_audio_sources(const AppConfig& config,
+                                                               const AudioSourceOverrides& overrides);
+
+} // namespace why
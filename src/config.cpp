@@ -1,11 +1,14 @@
 #include "config.h"
 
 #include <algorithm>
+#include <set>
 #include <sstream>
 
 #include "config/animation_config_parser.h"
+#include "config/audio_source_parser.h"
 #include "config/raw_config.h"
 #include "config/value_parsers.h"
+#include "frame_scheduler.h"
 
 namespace why {
 namespace {
@@ -103,12 +106,69 @@ void populate_audio_config(const RawConfig& raw,
                   audio.file.gain,
                   parse_float32,
                   warnings);
+    assign_scalar(raw,
+                  "audio.file.analysis_cache",
+                  audio.file.analysis_cache,
+                  parse_bool,
+                  warnings);
+    assign_string(raw, "audio.file.cache_directory", audio.file.cache_directory);
 
     assign_scalar(raw,
                   "audio.prefer_file",
                   audio.prefer_file,
                   parse_bool,
                   warnings);
+
+    for (const auto& raw_source_config : raw.source_configs) {
+        auto parsed = config::detail::parse_audio_source_config(raw_source_config, warnings);
+        if (parsed.has_value()) {
+            audio.sources.push_back(*parsed);
+        }
+    }
+}
+
+void populate_dsp_profiles(const RawConfig& raw,
+                           DspConfig& dsp,
+                           std::vector<std::string>& warnings) {
+    using config::detail::parse_size;
+    const std::string prefix = "dsp.profiles.";
+
+    std::set<std::string> names;
+    for (const auto& [key, scalar] : raw.scalars) {
+        if (key.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        const std::size_t dot = key.rfind('.');
+        if (dot > prefix.size()) {
+            names.insert(key.substr(prefix.size(), dot - prefix.size()));
+        }
+    }
+
+    for (const std::string& name : names) {
+        const std::string section = prefix + name + ".";
+        DspProfileConfig profile;
+        profile.name = name;
+        profile.fft_size = dsp.fft_size;
+        profile.hop_size = dsp.hop_size;
+        profile.bands = dsp.bands;
+        profile.zero_pad_factor = dsp.zero_pad_factor;
+        assign_scalar(raw, section + "fft_size", profile.fft_size, parse_size, warnings);
+        assign_scalar(raw, section + "hop_size", profile.hop_size, parse_size, warnings);
+        assign_scalar(raw, section + "bands", profile.bands, parse_size, warnings);
+        assign_scalar(raw, section + "zero_pad_factor", profile.zero_pad_factor, parse_size, warnings);
+
+        const bool valid_fft = profile.fft_size >= 2 && (profile.fft_size & (profile.fft_size - 1)) == 0;
+        const bool valid_hop = profile.hop_size > 0 && profile.hop_size <= profile.fft_size;
+        const bool valid_pad = profile.zero_pad_factor == 1 || profile.zero_pad_factor == 2 ||
+                               profile.zero_pad_factor == 4;
+        if (!valid_fft || !valid_hop || !valid_pad || profile.bands == 0) {
+            warnings.push_back("Ignoring analysis profile '" + name +
+                               "': needs a power-of-two fft_size, 0 < hop_size <= fft_size, bands > 0 and "
+                               "zero_pad_factor 1, 2 or 4");
+            continue;
+        }
+        dsp.profiles.push_back(profile);
+    }
 }
 
 void populate_dsp_config(const RawConfig& raw,
@@ -138,6 +198,38 @@ void populate_dsp_config(const RawConfig& raw,
                   parse_float32,
                   warnings);
     assign_scalar(raw, "dsp.enable_flux", dsp.enable_flux, parse_bool, warnings);
+    assign_scalar(raw,
+                  "dsp.specialized_kernels",
+                  dsp.specialized_kernels,
+                  parse_bool,
+                  warnings);
+    assign_scalar(raw, "dsp.zero_pad_factor", dsp.zero_pad_factor, parse_size, warnings);
+    assign_scalar(raw, "dsp.auto_sparse", dsp.auto_sparse, parse_bool, warnings);
+    assign_scalar(raw, "dsp.hpss", dsp.hpss, parse_bool, warnings);
+    assign_scalar(raw, "dsp.hpss_time_kernel", dsp.hpss_time_kernel, parse_size, warnings);
+    assign_scalar(raw, "dsp.hpss_frequency_kernel", dsp.hpss_frequency_kernel, parse_size, warnings);
+    assign_scalar(raw, "dsp.pitch_tracking", dsp.pitch_tracking, parse_bool, warnings);
+    assign_scalar(raw, "dsp.pitch_min_hz", dsp.pitch_min_hz, parse_float32, warnings);
+    assign_scalar(raw, "dsp.pitch_max_hz", dsp.pitch_max_hz, parse_float32, warnings);
+    if (dsp.pitch_min_hz <= 0.0f || dsp.pitch_max_hz <= dsp.pitch_min_hz) {
+        warnings.push_back("dsp.pitch_min_hz/pitch_max_hz must satisfy 0 < min < max; using 60-1000 Hz");
+        dsp.pitch_min_hz = 60.0f;
+        dsp.pitch_max_hz = 1000.0f;
+    }
+    if (dsp.hpss_time_kernel == 0) {
+        warnings.push_back("dsp.hpss_time_kernel must be at least 1; using 17");
+        dsp.hpss_time_kernel = 17;
+    }
+    if (dsp.hpss_frequency_kernel == 0) {
+        warnings.push_back("dsp.hpss_frequency_kernel must be at least 1; using 17");
+        dsp.hpss_frequency_kernel = 17;
+    }
+    if (dsp.zero_pad_factor != 1 && dsp.zero_pad_factor != 2 && dsp.zero_pad_factor != 4) {
+        warnings.push_back("dsp.zero_pad_factor must be 1, 2 or 4; using 1");
+        dsp.zero_pad_factor = 1;
+    }
+
+    populate_dsp_profiles(raw, dsp, warnings);
 }
 
 void populate_visual_config(const RawConfig& raw,
@@ -145,6 +237,41 @@ void populate_visual_config(const RawConfig& raw,
                             std::vector<std::string>& warnings) {
     using config::detail::parse_double;
     assign_scalar(raw, "visual.target_fps", visual.target_fps, parse_double, warnings);
+    assign_string(raw, "visual.late_frames", visual.late_frames);
+    assign_scalar(raw, "visual.spin_ms", visual.spin_ms, parse_double, warnings);
+    if (!parse_late_frame_policy(visual.late_frames)) {
+        warnings.push_back("visual.late_frames must be \"skip\", \"catch_up\" or \"reset\"; using \"skip\"");
+        visual.late_frames = "skip";
+    }
+    assign_scalar(raw, "visual.colour_step", visual.colour_step, config::detail::parse_uint32, warnings);
+    assign_scalar(raw,
+                  "visual.colour_reuse_threshold",
+                  visual.colour_reuse_threshold,
+                  config::detail::parse_uint32,
+                  warnings);
+    assign_scalar(raw, "visual.bandwidth_kbps", visual.bandwidth_kbps, parse_double, warnings);
+    assign_scalar(raw, "visual.adaptive_quality", visual.adaptive_quality, config::detail::parse_bool, warnings);
+    assign_scalar(raw, "visual.frame_budget_ms", visual.frame_budget_ms, parse_double, warnings);
+    if (visual.colour_step < 1u || visual.colour_step > 128u) {
+        warnings.push_back("visual.colour_step must be between 1 and 128; using 1");
+        visual.colour_step = 1u;
+    }
+    if (visual.colour_reuse_threshold > 255u) {
+        warnings.push_back("visual.colour_reuse_threshold must be at most 255; using 255");
+        visual.colour_reuse_threshold = 255u;
+    }
+    if (visual.bandwidth_kbps < 0.0) {
+        warnings.push_back("visual.bandwidth_kbps must not be negative; using 0 (no budget)");
+        visual.bandwidth_kbps = 0.0;
+    }
+    if (visual.frame_budget_ms < 0.0) {
+        warnings.push_back("visual.frame_budget_ms must not be negative; using 0 (90% of the frame period)");
+        visual.frame_budget_ms = 0.0;
+    }
+    if (visual.spin_ms < 0.0) {
+        warnings.push_back("visual.spin_ms must not be negative; using 0");
+        visual.spin_ms = 0.0;
+    }
 }
 
 void populate_runtime_config(const RawConfig& raw,
@@ -159,6 +286,17 @@ void populate_runtime_config(const RawConfig& raw,
                   runtime.show_overlay_metrics,
                   parse_bool,
                   warnings);
+    assign_scalar(raw,
+                  "runtime.worker_threads",
+                  runtime.worker_threads,
+                  config::detail::parse_size,
+                  warnings);
+    assign_scalar(raw, "runtime.parallel_updates", runtime.parallel_updates, parse_bool, warnings);
+    assign_scalar(raw, "runtime.profiling", runtime.profiling, parse_bool, warnings);
+    assign_string(raw, "runtime.profile_output", runtime.profile_output);
+    assign_string(raw, "runtime.frame_stats_output", runtime.frame_stats_output);
+    assign_scalar(raw, "runtime.pipelined_output", runtime.pipelined_output, parse_bool, warnings);
+    assign_scalar(raw, "runtime.hot_reload", runtime.hot_reload, parse_bool, warnings);
 }
 
 void populate_plugin_config(const RawConfig& raw,
@@ -185,6 +323,41 @@ void populate_animation_configs(const RawConfig& raw,
     }
 }
 
+void validate_analysis_profiles(AppConfig& config, std::vector<std::string>& warnings) {
+    for (AnimationConfig& animation : config.animations) {
+        if (animation.analysis_profile.empty()) {
+            continue;
+        }
+        const bool known = std::any_of(config.dsp.profiles.begin(),
+                                       config.dsp.profiles.end(),
+                                       [&animation](const DspProfileConfig& profile) {
+                                           return profile.name == animation.analysis_profile;
+                                       });
+        if (!known) {
+            warnings.push_back("Animation '" + animation.type + "' uses unknown analysis profile '" +
+                               animation.analysis_profile + "'; using [dsp]");
+            animation.analysis_profile.clear();
+        }
+    }
+}
+
+void validate_band_streams(AppConfig& config, std::vector<std::string>& warnings) {
+    for (AnimationConfig& animation : config.animations) {
+        if (animation.band_stream.empty()) {
+            continue;
+        }
+        if (animation.band_stream != "harmonic" && animation.band_stream != "percussive") {
+            warnings.push_back("Animation '" + animation.type + "' has unknown band_stream '" +
+                               animation.band_stream + "'; using the full mix");
+            animation.band_stream.clear();
+        } else if (!config.dsp.hpss) {
+            warnings.push_back("Animation '" + animation.type + "' reads the " + animation.band_stream +
+                               " band stream, which needs dsp.hpss = true; using the full mix");
+            animation.band_stream.clear();
+        }
+    }
+}
+
 void apply_sanity_defaults(AppConfig& config) {
     if (config.audio.capture.sample_rate == 0) {
         config.audio.capture.sample_rate = 48000;
@@ -227,10 +400,23 @@ ConfigLoadResult load_app_config(const std::string& path) {
     populate_plugin_config(raw, result.config.plugins, result.warnings);
     populate_animation_configs(raw, result.config.animations, result.warnings);
 
+    validate_analysis_profiles(result.config, result.warnings);
+    validate_band_streams(result.config, result.warnings);
     apply_sanity_defaults(result.config);
 
     return result;
 }
 
+ConfigChanges diff_app_config(const AppConfig& before, const AppConfig& after) {
+    ConfigChanges changes;
+    changes.audio = before.audio != after.audio;
+    changes.dsp = before.dsp != after.dsp;
+    changes.visual = before.visual != after.visual;
+    changes.runtime = before.runtime != after.runtime;
+    changes.plugins = before.plugins != after.plugins;
+    changes.animations = before.animations != after.animations;
+    return changes;
+}
+
 } // namespace why
 
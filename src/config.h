@@ -18,6 +18,8 @@ struct AudioCaptureConfig {
     std::string device;
     float input_gain = 1.0f;
     bool system = false;
+
+    bool operator==(const AudioCaptureConfig&) const = default;
 };
 
 struct AudioFileConfig {
@@ -25,12 +27,42 @@ struct AudioFileConfig {
     std::string path;
     std::uint32_t channels = 1;
     float gain = 1.0f;
+    bool analysis_cache = true;                 // Pre-analyse the track and play analysis back from a sidecar file
+    std::string cache_directory = ".why-cache"; // Where sidecars live; empty stores them next to the track
+
+    bool operator==(const AudioFileConfig&) const = default;
+};
+
+struct AudioSourceConfig {
+    std::string id;                 // Name animations use to select this source
+    bool enabled = true;
+    std::string device;             // Capture device name (substring match)
+    bool system = false;            // Capture system/loopback audio instead of a microphone
+    std::string file;               // Stream this file instead of capturing
+    std::uint32_t channels = 0;     // 0 inherits audio.capture.channels / audio.file.channels
+
+    bool operator==(const AudioSourceConfig&) const = default;
 };
 
 struct AudioConfig {
     AudioCaptureConfig capture;
     AudioFileConfig file;
     bool prefer_file = false;
+    std::vector<AudioSourceConfig> sources; // [[audio.sources]]; empty means a single source from capture/file
+
+    bool operator==(const AudioConfig&) const = default;
+};
+
+// Extra FFT/band configuration selected by [[animations]] `analysis_profile`; values
+// not given in [dsp.profiles.<name>] inherit from [dsp].
+struct DspProfileConfig {
+    std::string name;
+    std::size_t fft_size = 1024;
+    std::size_t hop_size = 256;
+    std::size_t bands = 32;
+    std::size_t zero_pad_factor = 1;
+
+    bool operator==(const DspProfileConfig&) const = default;
 };
 
 struct DspConfig {
@@ -42,12 +74,32 @@ struct DspConfig {
     float smoothing_release = 0.05f;
     float beat_sensitivity = 1.0f;
     bool enable_flux = true;
+    bool specialized_kernels = true; // Use compile-time FFT kernels for the 1024/32, 2048/64 and 4096/128 presets
+    std::size_t zero_pad_factor = 1; // 1, 2 or 4: zero-pad each window for finer bin spacing at the same latency
+    bool auto_sparse = true;         // Switch to a Goertzel bank when animations only read a few bands
+    bool hpss = false;               // Split the spectrum into harmonic and percussive band streams
+    std::size_t hpss_time_kernel = 17;      // Hops in the harmonic (time) median
+    std::size_t hpss_frequency_kernel = 17; // Bins in the percussive (frequency) median; made odd
+    bool pitch_tracking = false;     // Run a YIN pitch tracker and publish PitchEvent
+    float pitch_min_hz = 60.0f;
+    float pitch_max_hz = 1000.0f;
+    std::vector<DspProfileConfig> profiles; // [dsp.profiles.<name>], sharing the default profile's input
+
+    bool operator==(const DspConfig&) const = default;
 };
 
 struct VisualConfig {
 
     double target_fps = 60.0;
-
+    std::string late_frames = "skip"; // After a missed deadline: "skip", "catch_up" or "reset"
+    double spin_ms = 1.0;             // Busy-wait this long before each deadline instead of sleeping
+    std::uint32_t colour_step = 1;    // Round animation colour channels to multiples of this; 1 keeps 24-bit
+    std::uint32_t colour_reuse_threshold = 0; // Keep a cell's last colour while no channel moved further
+    double bandwidth_kbps = 0.0;      // Coarsen colours further while output exceeds this; 0 = no budget
+    bool adaptive_quality = false;    // Lower the costliest animations' quality while frames overrun
+    double frame_budget_ms = 0.0;     // Work per frame the governor aims for; 0 = 90% of the frame period
+
+    bool operator==(const VisualConfig&) const = default;
 };
 
 struct RuntimeConfig {
@@ -55,16 +107,30 @@ struct RuntimeConfig {
     bool allow_resize = true;
     bool beat_flash = true;
     bool show_overlay_metrics = false; // New config option, default to false
+    std::size_t worker_threads = 0;    // Worker pool size; 0 sizes it to the available cores
+    bool parallel_updates = false;     // Run independent animation updates on the worker pool
+    bool profiling = false;            // Time event handlers, animations and plug-ins
+    std::string profile_output = "why-profile.json"; // Written at exit while profiling
+    std::string frame_stats_output;    // Frame-time histograms written here at exit; empty skips them
+    bool pipelined_output = false;     // Write frames to the terminal on a separate thread
+    bool hot_reload = true;            // Apply edits to the config file without restarting
+
+    bool operator==(const RuntimeConfig&) const = default;
 };
 
 struct PluginConfig {
     std::string directory = "plugins";
     std::vector<std::string> autoload;
     bool safe_mode = false;
+
+    bool operator==(const PluginConfig&) const = default;
 };
 
 struct AnimationConfig {
     std::string type;
+    std::string source;                  // Audio source id to follow; empty follows the first source
+    std::string analysis_profile;        // [dsp.profiles.<name>] to analyse with; empty uses [dsp]
+    std::string band_stream;             // "harmonic" or "percussive" (needs dsp.hpss); empty uses the full mix
     int z_index = 0;
     bool initially_active = true; // New: whether the animation starts active
     // Trigger conditions
@@ -88,6 +154,7 @@ struct AnimationConfig {
     std::optional<int> matrix_cols;      // Optional number of columns for matrix-style animations
     bool matrix_show_border = true;      // Whether to render a border around the matrix animation
     std::string glyphs_file_path;        // Glyph file override for glyph-based animations
+    std::string blitter = "cells";       // "cells", "braille", "sextant", "pixel" or "auto" (BarVisual, Breathe)
     float matrix_beat_boost = 1.5f;      // Beat multiplier for matrix animations
     float matrix_beat_threshold = 0.6f;  // Beat threshold for matrix animations
     float rain_angle_degrees = 0.0f;     // Angle for cyber rain drops (degrees, relative to vertical)
@@ -116,6 +183,7 @@ struct AnimationConfig {
     float breathe_rms_weight = 1.0f;      // Weight applied to RMS audio energy
     float breathe_beat_weight = 0.6f;     // Weight applied to beat strength
     float breathe_band_weight = 0.5f;     // Weight applied to the selected FFT band
+    float breathe_pitch_radius = 0.0f;    // Radius added at the top of the pitch range (needs dsp.pitch_tracking)
     float log_line_interval_s = 0.4f;     // Interval between log entries when streaming
     bool log_loop_messages = true;        // Whether to loop messages when the end is reached
     bool log_show_border = true;          // Display a frame border around the log window
@@ -123,6 +191,8 @@ struct AnimationConfig {
     int log_padding_x = 2;                // Horizontal padding between border and log text
     std::string log_title;                // Optional title displayed on the top border
     // Add more generic parameters as needed, e.g., std::map<std::string, std::string> params;
+
+    bool operator==(const AnimationConfig&) const = default;
 };
 
 struct AppConfig {
@@ -133,6 +203,8 @@ struct AppConfig {
     RuntimeConfig runtime;
     PluginConfig plugins;
     std::vector<AnimationConfig> animations;
+
+    bool operator==(const AppConfig&) const = default;
 };
 
 struct ConfigLoadResult {
@@ -143,6 +215,20 @@ struct ConfigLoadResult {
 
 ConfigLoadResult load_app_config(const std::string& path);
 
+// The sections that differ between two configs, so a reload only rebuilds what changed.
+struct ConfigChanges {
+    bool audio = false;
+    bool dsp = false;
+    bool visual = false;
+    bool runtime = false;
+    bool plugins = false;
+    bool animations = false;
+
+    bool any() const { return audio || dsp || visual || runtime || plugins || animations; }
+};
+
+ConfigChanges diff_app_config(const AppConfig& before, const AppConfig& after);
+
 
 
 } // namespace why
@@ -21,6 +21,21 @@ std::optional<AnimationConfig> parse_animation_config(
         return std::nullopt;
     }
 
+    const auto source_it = raw_anim_config.find("source");
+    if (source_it != raw_anim_config.end()) {
+        anim_config.source = sanitize_string_value(source_it->second.value);
+    }
+
+    const auto analysis_profile_it = raw_anim_config.find("analysis_profile");
+    if (analysis_profile_it != raw_anim_config.end()) {
+        anim_config.analysis_profile = sanitize_string_value(analysis_profile_it->second.value);
+    }
+
+    const auto band_stream_it = raw_anim_config.find("band_stream");
+    if (band_stream_it != raw_anim_config.end()) {
+        anim_config.band_stream = sanitize_string_value(band_stream_it->second.value);
+    }
+
     const auto z_index_it = raw_anim_config.find("z_index");
     if (z_index_it != raw_anim_config.end()) {
         parse_int32(z_index_it->second.value, anim_config.z_index);
@@ -179,6 +194,11 @@ std::optional<AnimationConfig> parse_animation_config(
         anim_config.glyphs_file_path = sanitize_string_value(glyphs_file_it->second.value);
     }
 
+    const auto blitter_it = raw_anim_config.find("blitter");
+    if (blitter_it != raw_anim_config.end()) {
+        anim_config.blitter = sanitize_string_value(blitter_it->second.value);
+    }
+
     const auto beat_boost_it = raw_anim_config.find("matrix_beat_boost");
     if (beat_boost_it != raw_anim_config.end()) {
         parse_float32(beat_boost_it->second.value, anim_config.matrix_beat_boost);
@@ -331,6 +351,11 @@ std::optional<AnimationConfig> parse_animation_config(
         parse_float32(breathe_band_weight_it->second.value, anim_config.breathe_band_weight);
     }
 
+    const auto breathe_pitch_radius_it = raw_anim_config.find("breathe_pitch_radius");
+    if (breathe_pitch_radius_it != raw_anim_config.end()) {
+        parse_float32(breathe_pitch_radius_it->second.value, anim_config.breathe_pitch_radius);
+    }
+
     return anim_config;
 }
 
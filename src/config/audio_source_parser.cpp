@@ -0,0 +1,57 @@
+#include "audio_source_parser.h"
+
+#include <sstream>
+
+#include "value_parsers.h"
+
+namespace why::config::detail {
+
+std::optional<AudioSourceConfig> parse_audio_source_config(
+    const std::unordered_map<std::string, RawScalar>& raw_source_config,
+    std::vector<std::string>& warnings) {
+    AudioSourceConfig source_config;
+
+    const auto id_it = raw_source_config.find("id");
+    if (id_it != raw_source_config.end()) {
+        source_config.id = sanitize_string_value(id_it->second.value);
+    }
+    if (source_config.id.empty()) {
+        std::ostringstream oss;
+        oss << "Audio source configuration missing 'id' for an entry.";
+        warnings.push_back(oss.str());
+        return std::nullopt;
+    }
+
+    const auto enabled_it = raw_source_config.find("enabled");
+    if (enabled_it != raw_source_config.end()) {
+        parse_bool(enabled_it->second.value, source_config.enabled);
+    }
+
+    const auto device_it = raw_source_config.find("device");
+    if (device_it != raw_source_config.end()) {
+        source_config.device = sanitize_string_value(device_it->second.value);
+    }
+
+    const auto system_it = raw_source_config.find("system");
+    if (system_it != raw_source_config.end()) {
+        parse_bool(system_it->second.value, source_config.system);
+    }
+
+    const auto file_it = raw_source_config.find("file");
+    if (file_it != raw_source_config.end()) {
+        source_config.file = sanitize_string_value(file_it->second.value);
+    }
+
+    const auto channels_it = raw_source_config.find("channels");
+    if (channels_it != raw_source_config.end()) {
+        if (!parse_uint32(channels_it->second.value, source_config.channels)) {
+            std::ostringstream oss;
+            oss << "Invalid value for 'channels' on line " << channels_it->second.line;
+            warnings.push_back(oss.str());
+        }
+    }
+
+    return source_config;
+}
+
+} // namespace why::config::detail
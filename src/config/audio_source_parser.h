@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../config.h"
+#include "raw_config.h"
+
+namespace why::config::detail {
+
+std::optional<AudioSourceConfig> parse_audio_source_config(
+    const std::unordered_map<std::string, RawScalar>& raw_source_config,
+    std::vector<std::string>& warnings);
+
+} // namespace why::config::detail
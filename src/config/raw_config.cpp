@@ -114,7 +114,7 @@ void parse_file(const std::string& path,
 
     std::string line;
     std::string current_section;
-    std::unordered_map<std::string, RawScalar>* current_animation_map = nullptr;
+    std::unordered_map<std::string, RawScalar>* current_table_map = nullptr;
     int line_number = 0;
     while (std::getline(file, line)) {
         ++line_number;
@@ -129,14 +129,17 @@ void parse_file(const std::string& path,
                 std::string array_name = trim(trimmed.substr(2, trimmed.size() - 4));
                 if (array_name == "animations") {
                     out.animation_configs.emplace_back();
-                    current_animation_map = &out.animation_configs.back();
+                    current_table_map = &out.animation_configs.back();
+                } else if (array_name == "audio.sources") {
+                    out.source_configs.emplace_back();
+                    current_table_map = &out.source_configs.back();
                 } else {
-                    current_animation_map = nullptr;
+                    current_table_map = nullptr;
                 }
                 current_section.clear();
             } else {
                 current_section = trim(trimmed.substr(1, trimmed.size() - 2));
-                current_animation_map = nullptr;
+                current_table_map = nullptr;
             }
             continue;
         }
@@ -151,11 +154,11 @@ void parse_file(const std::string& path,
         std::string key = trim(trimmed.substr(0, eq));
         std::string value = strip_inline_comment(trimmed.substr(eq + 1));
 
-        if (current_animation_map) {
+        if (current_table_map) {
             RawScalar scalar;
             scalar.value = value;
             scalar.line = line_number;
-            (*current_animation_map)[key] = scalar;
+            (*current_table_map)[key] = scalar;
         } else {
             std::string full_key = key;
             if (!current_section.empty()) {
@@ -20,6 +20,7 @@ struct RawConfig {
     std::unordered_map<std::string, RawScalar> scalars;
     std::unordered_map<std::string, RawArray> arrays;
     std::vector<std::unordered_map<std::string, RawScalar>> animation_configs;
+    std::vector<std::unordered_map<std::string, RawScalar>> source_configs;
 };
 
 RawConfig parse_raw_config(const std::string& path,
@@ -0,0 +1,111 @@
+#include "config_watcher.h"
+
+#include <cerrno>
+#include <filesystem>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace why {
+
+namespace {
+constexpr int kSettleMs = 50; // Editors write, truncate and rename in quick succession
+} // namespace
+
+ConfigWatcher::ConfigWatcher(std::string path)
+    : path_(std::move(path)) {
+#if defined(__linux__)
+    const std::filesystem::path file(path_);
+    file_name_ = file.filename().string();
+    const std::string directory = file.has_parent_path() ? file.parent_path().string() : std::string(".");
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return;
+    }
+    if (inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe2(wake_fds_, O_CLOEXEC) != 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return;
+    }
+    thread_ = std::thread([this]() { run(); });
+#endif
+}
+
+ConfigWatcher::~ConfigWatcher() {
+#if defined(__linux__)
+    if (thread_.joinable()) {
+        const char stop = 0;
+        while (write(wake_fds_[1], &stop, 1) < 0 && errno == EINTR) {
+        }
+        thread_.join();
+        close(wake_fds_[0]);
+        close(wake_fds_[1]);
+        close(inotify_fd_);
+    }
+#endif
+}
+
+std::optional<ConfigLoadResult> ConfigWatcher::take() {
+    if (!has_parsed_.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_parsed_.store(false, std::memory_order_relaxed);
+    return std::exchange(parsed_, std::nullopt);
+}
+
+void ConfigWatcher::run() {
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+    bool changed = false;
+    while (true) {
+        const int ready = poll(fds, 2, changed ? kSettleMs : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0) {
+            return;
+        }
+        if (ready == 0) {
+            // Quiet for kSettleMs since the last write: parse it.
+            changed = false;
+            ConfigLoadResult result = load_app_config(path_);
+            if (!result.loaded_file) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            parsed_ = std::move(result);
+            has_parsed_.store(true, std::memory_order_release);
+            continue;
+        }
+
+        const ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && file_name_ == event->name) {
+                changed = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+#endif
+}
+
+} // namespace why
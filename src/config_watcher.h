@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "config.h"
+
+namespace why {
+
+// Watches the config file and parses it again on its own thread whenever it is written,
+// so the frame loop only has to pick up a finished AppConfig.
+//
+// The file's directory is watched with inotify rather than the file itself: editors
+// often save by writing a new file and renaming it over the old one. Writes that arrive
+// within 50 ms of each other are parsed once. A file that is missing when it is read
+// (mid-save) is ignored rather than reported as the built-in defaults. Only Linux has
+// inotify; elsewhere watching() is false and nothing is ever reloaded.
+class ConfigWatcher {
+public:
+    explicit ConfigWatcher(std::string path);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool watching() const { return thread_.joinable(); }
+
+    // The newest config parsed since the last call, if any. Cheap when there is none, so
+    // the frame loop calls it every frame.
+    std::optional<ConfigLoadResult> take();
+
+private:
+    void run();
+
+    std::string path_;
+    std::string file_name_; // Of path_, matched against the directory's events
+    int inotify_fd_ = -1;
+    int wake_fds_[2] = {-1, -1}; // Written by the destructor to stop run()
+
+    std::mutex mutex_;
+    std::optional<ConfigLoadResult> parsed_;
+    std::atomic<bool> has_parsed_{false};
+
+    std::thread thread_;
+};
+
+} // namespace why
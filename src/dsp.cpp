@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <string>
+#include <utility>
 #include <stdexcept>
 #include <vector>
 
@@ -15,37 +17,47 @@ namespace why {
 namespace {
 constexpr float kMinDisplayFrequency = 20.0f;
 constexpr float kPi = 3.14159265358979323846f;
+constexpr double kTwoPi = 6.28318530717958647692;
+// Bands starting below this frequency stay analysed in sparse mode so beat detection keeps
+// following the kick drum.
+constexpr float kSparseBeatCutoffHz = 150.0f;
 } // namespace
 
-DspEngine::DspEngine(std::uint32_t sample_rate,
-                     std::uint32_t channels,
-                     std::size_t fft_size,
-                     std::size_t hop_size,
-                     std::size_t bands)
-    : sample_rate_(sample_rate),
-      channels_(channels),
+SpectrumAnalyzer::SpectrumAnalyzer(std::string name,
+                                   std::uint32_t sample_rate,
+                                   std::size_t fft_size,
+                                   std::size_t hop_size,
+                                   std::size_t bands,
+                                   bool use_specialized_kernels,
+                                   std::size_t zero_pad_factor)
+    : name_(std::move(name)),
+      sample_rate_(sample_rate),
       fft_size_(fft_size),
       hop_size_(hop_size),
+      zero_pad_factor_(zero_pad_factor),
+      transform_size_(fft_size * zero_pad_factor),
       window_(fft_size_, 0.0f),
       frame_buffer_(fft_size_, 0.0f),
       band_energies_(bands, 0.0f),
       band_bin_ranges_(bands),
+      band_magnitudes_(bands, 0.0f),
       prev_magnitudes_(bands, 0.0f),
+      sparse_active_(false),
       fft_cfg_(nullptr),
-      fft_in_(fft_size_),
-      fft_out_(fft_size_),
       smoothing_attack_(0.35f),
       smoothing_release_(0.08f),
       flux_average_(0.0f),
-      beat_strength_(0.0f) {
+      beat_strength_(0.0f),
+      above_threshold_(false),
+      onset_(false) {
     if (fft_size_ < 2 || (fft_size_ & (fft_size_ - 1)) != 0) {
         throw std::invalid_argument("FFT size must be a power of two greater than 1");
     }
     if (hop_size_ == 0 || hop_size_ > fft_size_) {
         throw std::invalid_argument("Invalid hop size");
     }
-    if (channels_ == 0) {
-        throw std::invalid_argument("Channels must be non-zero");
+    if (zero_pad_factor_ == 0 || (zero_pad_factor_ & (zero_pad_factor_ - 1)) != 0) {
+        throw std::invalid_argument("Zero-pad factor must be a power of two");
     }
 
     const float denominator = static_cast<float>(fft_size_ - 1);
@@ -55,56 +67,54 @@ DspEngine::DspEngine(std::uint32_t sample_rate,
         window_[i] = w;
     }
 
-    fft_cfg_ = kiss_fft_alloc(static_cast<int>(fft_size_), 0, nullptr, nullptr);
-    if (!fft_cfg_) {
-        throw std::runtime_error("Failed to allocate FFT config");
+    compute_band_ranges();
+
+    if (use_specialized_kernels) {
+        kernel_ = make_specialized_kernel(fft_size_, zero_pad_factor_, band_bin_ranges_);
     }
 
-    compute_band_ranges();
+    if (!kernel_) {
+        const std::size_t half = transform_size_ / 2;
+        fft_cfg_ = kiss_fft_alloc(static_cast<int>(half), 0, nullptr, nullptr);
+        if (!fft_cfg_) {
+            throw std::runtime_error("Failed to allocate FFT config");
+        }
+        // The padded tail of fft_in_ is never written, so it stays zero.
+        fft_in_.assign(half, kiss_fft_cpx{0.0f, 0.0f});
+        fft_out_.assign(half, kiss_fft_cpx{0.0f, 0.0f});
+        spectrum_power_.assign(half + 1, 0.0f);
+        split_re_.resize(half + 1);
+        split_im_.resize(half + 1);
+        for (std::size_t k = 0; k <= half; ++k) {
+            const double phase = kTwoPi * static_cast<double>(k) / static_cast<double>(transform_size_);
+            split_re_[k] = static_cast<float>(std::cos(phase));
+            split_im_[k] = static_cast<float>(-std::sin(phase));
+        }
+    }
 }
 
-DspEngine::~DspEngine() {
+SpectrumAnalyzer::~SpectrumAnalyzer() {
     if (fft_cfg_) {
         kiss_fft_free(fft_cfg_);
         fft_cfg_ = nullptr;
     }
 }
 
-void DspEngine::push_samples(const float* interleaved_samples, std::size_t count) {
-    if (!interleaved_samples || count == 0) {
-        return;
-    }
-
-    const std::size_t frames = count / channels_;
-    for (std::size_t i = 0; i < frames; ++i) {
-        double sum = 0.0;
-        for (std::size_t ch = 0; ch < channels_; ++ch) {
-            sum += interleaved_samples[i * channels_ + ch];
-        }
-        mono_fifo_.push_back(static_cast<float>(sum / static_cast<double>(channels_)));
-    }
-
-    while (mono_fifo_.size() >= hop_size_) {
-        std::memmove(frame_buffer_.data(), frame_buffer_.data() + hop_size_,
-                     (fft_size_ - hop_size_) * sizeof(float));
-
-        for (std::size_t i = 0; i < hop_size_; ++i) {
-            frame_buffer_[fft_size_ - hop_size_ + i] = mono_fifo_.front();
-            mono_fifo_.pop_front();
-        }
-
-        process_frame();
+void SpectrumAnalyzer::set_active(bool active) {
+    if (active && !active_) {
+        samples_until_hop_ = hop_size_;
     }
+    active_ = active;
 }
 
-void DspEngine::compute_band_ranges() {
+void SpectrumAnalyzer::compute_band_ranges() {
     const std::size_t bands = band_energies_.size();
     if (bands == 0) {
         return;
     }
 
     const float nyquist = std::max(static_cast<float>(sample_rate_) * 0.5f, kMinDisplayFrequency * 1.1f);
-    const float bin_width = static_cast<float>(sample_rate_) / static_cast<float>(fft_size_);
+    const float bin_width = static_cast<float>(sample_rate_) / static_cast<float>(transform_size_);
     const float min_freq = std::max(kMinDisplayFrequency, bin_width);
     const float log_min = std::log(min_freq);
     const float log_max = std::log(nyquist);
@@ -118,59 +128,345 @@ void DspEngine::compute_band_ranges() {
         std::size_t bin0 = static_cast<std::size_t>(std::floor(f0 / bin_width));
         std::size_t bin1 = static_cast<std::size_t>(std::ceil(f1 / bin_width));
 
-        bin0 = std::min(bin0, fft_size_ / 2);
-        bin1 = std::clamp(bin1, bin0 + 1, fft_size_ / 2 + 1);
+        bin0 = std::min(bin0, transform_size_ / 2);
+        bin1 = std::clamp(bin1, bin0 + 1, transform_size_ / 2 + 1);
 
         band_bin_ranges_[i] = {bin0, bin1};
     }
 }
 
-void DspEngine::process_frame() {
-    if (!fft_cfg_) {
+void SpectrumAnalyzer::enable_hpss(std::size_t time_kernel, std::size_t frequency_kernel) {
+    const std::size_t bins = transform_size_ / 2 + 1;
+    hpss_ = std::make_unique<HarmonicPercussiveSeparator>(bins, time_kernel, frequency_kernel);
+    harmonic_power_.assign(bins, 0.0f);
+    percussive_power_.assign(bins, 0.0f);
+    harmonic_magnitudes_.assign(band_energies_.size(), 0.0f);
+    percussive_magnitudes_.assign(band_energies_.size(), 0.0f);
+    harmonic_bands_.assign(band_energies_.size(), 0.0f);
+    percussive_bands_.assign(band_energies_.size(), 0.0f);
+    set_required_bands(std::nullopt);
+}
+
+void SpectrumAnalyzer::set_required_bands(const std::optional<std::vector<std::size_t>>& bands) {
+    sparse_active_ = false;
+    sparse_bands_.clear();
+    sparse_offsets_.clear();
+    sparse_slots_.clear();
+    if (!bands.has_value() || hpss_) {
         return;
     }
 
-    const float norm = 1.0f / static_cast<float>(fft_size_);
+    const std::size_t band_count = band_bin_ranges_.size();
+    std::vector<bool> wanted(band_count, false);
+    for (std::size_t band : *bands) {
+        if (band < band_count) {
+            wanted[band] = true;
+        }
+    }
+    const float bin_width = static_cast<float>(sample_rate_) / static_cast<float>(transform_size_);
+    for (std::size_t band = 0; band < band_count; ++band) {
+        if (static_cast<float>(band_bin_ranges_[band].first) * bin_width < kSparseBeatCutoffHz) {
+            wanted[band] = true;
+        }
+    }
 
-    for (std::size_t i = 0; i < fft_size_; ++i) {
-        const float windowed = frame_buffer_[i] * window_[i];
-        fft_in_[i].r = windowed;
-        fft_in_[i].i = 0.0f;
+    // Bands overlap at the low end, so every distinct bin is evaluated once and the
+    // bands gather their bins through sparse_slots_.
+    std::vector<std::size_t> bins;
+    for (std::size_t band = 0; band < band_count; ++band) {
+        if (!wanted[band]) {
+            continue;
+        }
+        for (std::size_t bin = band_bin_ranges_[band].first; bin < band_bin_ranges_[band].second; ++bin) {
+            bins.push_back(bin);
+        }
     }
+    std::sort(bins.begin(), bins.end());
+    bins.erase(std::unique(bins.begin(), bins.end()), bins.end());
 
-    kiss_fft(fft_cfg_, fft_in_.data(), fft_out_.data());
+    // The bank always runs whole lane groups; one lane costs roughly half an FFT stage over
+    // the frame, so it only pays off while the lanes stay within twice the stage count.
+    std::size_t stages = 0;
+    while ((std::size_t{1} << stages) < transform_size_) {
+        ++stages;
+    }
+    const std::size_t lanes = ((bins.size() + GoertzelBank::kLanes - 1) / GoertzelBank::kLanes) * GoertzelBank::kLanes;
+    if (bins.empty() || lanes > 2 * stages) {
+        return;
+    }
 
-    float flux = 0.0f;
-    for (std::size_t band = 0; band < band_bin_ranges_.size(); ++band) {
-        const auto [start_bin, end_bin] = band_bin_ranges_[band];
-        float energy = 0.0f;
-        for (std::size_t bin = start_bin; bin < end_bin && bin <= fft_size_ / 2; ++bin) {
-            const float real = fft_out_[bin].r * norm;
-            const float imag = fft_out_[bin].i * norm;
-            energy += real * real + imag * imag;
+    sparse_offsets_.push_back(0);
+    for (std::size_t band = 0; band < band_count; ++band) {
+        if (!wanted[band]) {
+            continue;
         }
-        const std::size_t bin_count = (end_bin > start_bin) ? (end_bin - start_bin) : 1;
-        const float average_energy = energy / static_cast<float>(bin_count);
-        const float magnitude = std::sqrt(std::max(average_energy, 0.0f));
-        const float previous = (band < prev_magnitudes_.size()) ? prev_magnitudes_[band] : 0.0f;
-        if (band < prev_magnitudes_.size()) {
-            prev_magnitudes_[band] = magnitude;
+        sparse_bands_.push_back(band);
+        for (std::size_t bin = band_bin_ranges_[band].first; bin < band_bin_ranges_[band].second; ++bin) {
+            const auto it = std::lower_bound(bins.begin(), bins.end(), bin);
+            sparse_slots_.push_back(static_cast<std::size_t>(it - bins.begin()));
         }
+        sparse_offsets_.push_back(sparse_slots_.size());
+    }
+
+    goertzel_.configure(bins, transform_size_);
+    sparse_power_.assign(bins.size(), 0.0f);
+    std::fill(band_magnitudes_.begin(), band_magnitudes_.end(), 0.0f);
+    sparse_active_ = true;
+}
+
+void SpectrumAnalyzer::analyze_frame() {
+    if (sparse_active_) {
+        compute_band_magnitudes_sparse();
+    } else if (kernel_) {
+        kernel_->analyze(frame_buffer_.data(), band_magnitudes_.data());
+    } else if (fft_cfg_) {
+        compute_band_magnitudes_generic();
+    } else {
+        return;
+    }
+
+    float flux = 0.0f;
+    for (std::size_t band = 0; band < band_magnitudes_.size(); ++band) {
+        const float magnitude = band_magnitudes_[band];
+        const float previous = prev_magnitudes_[band];
+        prev_magnitudes_[band] = magnitude;
         flux += std::max(0.0f, magnitude - previous);
-        const float current = band_energies_[band];
-        const float target = magnitude;
-        const float alpha = (target > current) ? smoothing_attack_ : smoothing_release_;
-        band_energies_[band] = current + (target - current) * alpha;
+    }
+    smooth_bands(band_magnitudes_, band_energies_);
+
+    if (hpss_) {
+        separate_harmonic_percussive();
     }
 
     flux_average_ = flux_average_ * 0.92f + flux * 0.08f;
     const float baseline = std::max(flux_average_ * 1.35f, 1e-4f);
     float beat_instant = 0.0f;
-    if (flux > baseline) {
+    const bool above_threshold = flux > baseline;
+    if (above_threshold) {
         beat_instant = std::min((flux - baseline) / baseline, 1.0f);
     }
+    onset_ = above_threshold && !above_threshold_;
+    above_threshold_ = above_threshold;
     beat_strength_ = std::max(beat_instant, beat_strength_ * 0.6f);
     beat_strength_ = std::clamp(beat_strength_, 0.0f, 1.0f);
 }
 
+void SpectrumAnalyzer::compute_band_magnitudes_generic() {
+    const std::size_t half = transform_size_ / 2;
+
+    for (std::size_t k = 0; k < fft_size_ / 2; ++k) {
+        fft_in_[k].r = frame_buffer_[2 * k] * window_[2 * k];
+        fft_in_[k].i = frame_buffer_[2 * k + 1] * window_[2 * k + 1];
+    }
+
+    kiss_fft(fft_cfg_, fft_in_.data(), fft_out_.data());
+
+    const float dc = fft_out_[0].r + fft_out_[0].i;
+    const float nyquist = fft_out_[0].r - fft_out_[0].i;
+    spectrum_power_[0] = dc * dc;
+    spectrum_power_[half] = nyquist * nyquist;
+    for (std::size_t k = 1; k < half; ++k) {
+        const float zr = fft_out_[k].r;
+        const float zi = fft_out_[k].i;
+        const float cr = fft_out_[half - k].r;
+        const float ci = -fft_out_[half - k].i;
+        const float er = 0.5f * (zr + cr);
+        const float ei = 0.5f * (zi + ci);
+        const float or_ = 0.5f * (zi - ci);
+        const float oi = -0.5f * (zr - cr);
+        const float xr = er + (or_ * split_re_[k] - oi * split_im_[k]);
+        const float xi = ei + (or_ * split_im_[k] + oi * split_re_[k]);
+        spectrum_power_[k] = xr * xr + xi * xi;
+    }
+
+    bands_from_power(spectrum_power_.data(), band_magnitudes_.data());
+}
+
+void SpectrumAnalyzer::bands_from_power(const float* power, float* magnitudes) const {
+    // Scale by the window length, not the padded length, so zero padding only refines the
+    // bin spacing and leaves band levels unchanged.
+    const float norm = 1.0f / static_cast<float>(fft_size_);
+    const float norm_squared = norm * norm;
+    const std::size_t half = transform_size_ / 2;
+    for (std::size_t band = 0; band < band_bin_ranges_.size(); ++band) {
+        const auto [start_bin, end_bin] = band_bin_ranges_[band];
+        float energy = 0.0f;
+        for (std::size_t bin = start_bin; bin < end_bin && bin <= half; ++bin) {
+            energy += power[bin];
+        }
+        const std::size_t bin_count = (end_bin > start_bin) ? (end_bin - start_bin) : 1;
+        const float average_energy = energy * norm_squared / static_cast<float>(bin_count);
+        magnitudes[band] = std::sqrt(std::max(average_energy, 0.0f));
+    }
+}
+
+void SpectrumAnalyzer::smooth_bands(const std::vector<float>& magnitudes, std::vector<float>& energies) const {
+    for (std::size_t band = 0; band < magnitudes.size(); ++band) {
+        const float current = energies[band];
+        const float target = magnitudes[band];
+        const float alpha = (target > current) ? smoothing_attack_ : smoothing_release_;
+        energies[band] = current + (target - current) * alpha;
+    }
+}
+
+void SpectrumAnalyzer::separate_harmonic_percussive() {
+    const float* power = kernel_ ? kernel_->power() : spectrum_power_.data();
+    hpss_->process(power, harmonic_power_.data(), percussive_power_.data());
+    bands_from_power(harmonic_power_.data(), harmonic_magnitudes_.data());
+    bands_from_power(percussive_power_.data(), percussive_magnitudes_.data());
+    smooth_bands(harmonic_magnitudes_, harmonic_bands_);
+    smooth_bands(percussive_magnitudes_, percussive_bands_);
+}
+
+void SpectrumAnalyzer::compute_band_magnitudes_sparse() {
+    goertzel_.evaluate(frame_buffer_.data(), window_.data(), fft_size_, sparse_power_.data());
+
+    const float norm = 1.0f / static_cast<float>(fft_size_);
+    const float norm_squared = norm * norm;
+    for (std::size_t i = 0; i < sparse_bands_.size(); ++i) {
+        float energy = 0.0f;
+        for (std::size_t slot = sparse_offsets_[i]; slot < sparse_offsets_[i + 1]; ++slot) {
+            energy += sparse_power_[sparse_slots_[slot]];
+        }
+        const std::size_t bin_count = std::max<std::size_t>(1, sparse_offsets_[i + 1] - sparse_offsets_[i]);
+        band_magnitudes_[sparse_bands_[i]] = std::sqrt(std::max(energy * norm_squared / static_cast<float>(bin_count), 0.0f));
+    }
+}
+
+DspEngine::DspEngine(std::uint32_t sample_rate,
+                     std::uint32_t channels,
+                     std::size_t fft_size,
+                     std::size_t hop_size,
+                     std::size_t bands,
+                     bool use_specialized_kernels,
+                     std::size_t zero_pad_factor)
+    : sample_rate_(sample_rate),
+      channels_(channels),
+      use_specialized_kernels_(use_specialized_kernels),
+      history_mask_(0),
+      write_position_(0) {
+    if (channels_ == 0) {
+        throw std::invalid_argument("Channels must be non-zero");
+    }
+    add_profile({}, fft_size, hop_size, bands, zero_pad_factor);
+}
+
+std::size_t DspEngine::add_profile(const std::string& name,
+                                   std::size_t fft_size,
+                                   std::size_t hop_size,
+                                   std::size_t bands,
+                                   std::size_t zero_pad_factor) {
+    profiles_.push_back(std::make_unique<SpectrumAnalyzer>(name,
+                                                           sample_rate_,
+                                                           fft_size,
+                                                           hop_size,
+                                                           bands,
+                                                           use_specialized_kernels_,
+                                                           zero_pad_factor));
+    profiles_.back()->samples_until_hop_ = hop_size;
+    reserve_history(fft_size);
+    return profiles_.size() - 1;
+}
+
+void DspEngine::enable_pitch_tracking(float min_frequency_hz, float max_frequency_hz) {
+    pitch_ = std::make_unique<PitchTracker>(sample_rate_, min_frequency_hz, max_frequency_hz);
+    pitch_frame_.assign(pitch_->window_size(), 0.0f);
+    pitch_hop_ = profiles_.front()->hop_size();
+    pitch_until_hop_ = pitch_hop_;
+    reserve_history(pitch_->window_size());
+}
+
+void DspEngine::reserve_history(std::size_t length) {
+    // The history holds the longest window; grow it (keeping the newest samples in place
+    // relative to write_position_) when a consumer needs more.
+    if (length <= history_.size()) {
+        return;
+    }
+    std::size_t capacity = 1;
+    while (capacity < length) {
+        capacity <<= 1;
+    }
+    std::vector<float> grown(capacity, 0.0f);
+    const std::size_t keep = std::min<std::uint64_t>(history_.size(), write_position_);
+    for (std::size_t i = 0; i < keep; ++i) {
+        const std::uint64_t position = write_position_ - keep + i;
+        grown[position & (capacity - 1)] = history_[position & history_mask_];
+    }
+    history_ = std::move(grown);
+    history_mask_ = capacity - 1;
+}
+
+std::optional<std::size_t> DspEngine::find_profile(const std::string& name) const {
+    for (std::size_t i = 0; i < profiles_.size(); ++i) {
+        if (profiles_[i]->name() == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+void DspEngine::push_samples(const float* interleaved_samples, std::size_t count) {
+    if (!interleaved_samples || count == 0) {
+        return;
+    }
+
+    std::size_t frames = count / channels_;
+    const float* input = interleaved_samples;
+    while (frames > 0) {
+        // Advance to the next hop boundary of any active profile so every profile sees the
+        // window ending exactly at its own hop.
+        std::size_t step = frames;
+        for (const auto& profile : profiles_) {
+            if (profile->active_) {
+                step = std::min(step, profile->samples_until_hop_);
+            }
+        }
+        if (pitch_) {
+            step = std::min(step, pitch_until_hop_);
+        }
+
+        for (std::size_t i = 0; i < step; ++i) {
+            double sum = 0.0;
+            for (std::size_t ch = 0; ch < channels_; ++ch) {
+                sum += input[i * channels_ + ch];
+            }
+            history_[write_position_ & history_mask_] = static_cast<float>(sum / static_cast<double>(channels_));
+            ++write_position_;
+        }
+        input += step * channels_;
+        frames -= step;
+
+        for (const auto& profile : profiles_) {
+            if (!profile->active_) {
+                continue;
+            }
+            profile->samples_until_hop_ -= step;
+            if (profile->samples_until_hop_ == 0) {
+                copy_history(profile->frame_buffer_.data(), profile->fft_size());
+                profile->analyze_frame();
+                profile->samples_until_hop_ = profile->hop_size();
+            }
+        }
+
+        if (pitch_) {
+            pitch_until_hop_ -= step;
+            if (pitch_until_hop_ == 0) {
+                copy_history(pitch_frame_.data(), pitch_frame_.size());
+                pitch_->analyze(pitch_frame_.data());
+                pitch_until_hop_ = pitch_hop_;
+            }
+        }
+    }
+}
+
+void DspEngine::copy_history(float* destination, std::size_t length) const {
+    const std::size_t capacity = history_.size();
+    const std::size_t start = static_cast<std::size_t>((write_position_ - length) & history_mask_);
+    const std::size_t first = std::min(length, capacity - start);
+    std::memcpy(destination, history_.data() + start, first * sizeof(float));
+    if (first < length) {
+        std::memcpy(destination + first, history_.data(), (length - first) * sizeof(float));
+    }
+}
+
 } // namespace why
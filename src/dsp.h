@@ -2,7 +2,9 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -10,51 +12,192 @@ extern "C" {
 #include <kiss_fft.h>
 }
 
+#include "dsp_kernel.h"
+#include "goertzel_bank.h"
+#include "hpss.h"
+#include "pitch_tracker.h"
+
 namespace why {
 
-class DspEngine {
+// One FFT/band configuration ("analysis profile") of a DspEngine: windowing, transform,
+// band mapping, smoothing and beat detection over windows the engine hands it.
+class SpectrumAnalyzer {
 public:
-    static constexpr std::size_t kDefaultFftSize = 1024;
-    static constexpr std::size_t kDefaultHopSize = kDefaultFftSize / 2;
-    static constexpr std::size_t kDefaultBands = 16;
+    SpectrumAnalyzer(std::string name,
+                     std::uint32_t sample_rate,
+                     std::size_t fft_size,
+                     std::size_t hop_size,
+                     std::size_t bands,
+                     bool use_specialized_kernels,
+                     std::size_t zero_pad_factor);
+    ~SpectrumAnalyzer();
 
-    DspEngine(std::uint32_t sample_rate,
-              std::uint32_t channels,
-              std::size_t fft_size = kDefaultFftSize,
-              std::size_t hop_size = kDefaultHopSize,
-              std::size_t bands = kDefaultBands);
-    ~DspEngine();
+    SpectrumAnalyzer(const SpectrumAnalyzer&) = delete;
+    SpectrumAnalyzer& operator=(const SpectrumAnalyzer&) = delete;
 
-    void push_samples(const float* interleaved_samples, std::size_t count);
+    const std::string& name() const { return name_; }
+
+    // Inactive profiles skip their hops entirely; reactivating restarts the hop schedule.
+    bool active() const { return active_; }
+    void set_active(bool active);
 
     const std::vector<float>& band_energies() const { return band_energies_; }
     float beat_strength() const { return beat_strength_; }
+    // True when the most recent hop crossed the flux threshold after being below it.
+    bool onset() const { return onset_; }
+    std::size_t fft_size() const { return fft_size_; }
+    std::size_t hop_size() const { return hop_size_; }
+    std::size_t zero_pad_factor() const { return zero_pad_factor_; }
+
+    // Declares which bands consumers read; std::nullopt means all of them. When the
+    // requested bands (plus the bass bands beat detection needs) span few enough bins the
+    // engine switches to a Goertzel bank and leaves the other bands at zero.
+    void set_required_bands(const std::optional<std::vector<std::size_t>>& bands);
+    bool using_sparse_bank() const { return sparse_active_; }
+    std::size_t sparse_bin_count() const { return sparse_active_ ? goertzel_.bin_count() : 0; }
+    bool using_specialized_kernel() const { return kernel_ != nullptr; }
+
+    // Enables harmonic/percussive separation (see HarmonicPercussiveSeparator) and the
+    // harmonic_bands()/percussive_bands() streams. It needs the full spectrum, so the
+    // profile no longer switches to the sparse bank.
+    void enable_hpss(std::size_t time_kernel, std::size_t frequency_kernel);
+    bool hpss_enabled() const { return hpss_ != nullptr; }
+    // Smoothed band energies of the harmonic and percussive parts; empty unless enabled.
+    const std::vector<float>& harmonic_bands() const { return harmonic_bands_; }
+    const std::vector<float>& percussive_bands() const { return percussive_bands_; }
 
 private:
+    friend class DspEngine;
+
     void compute_band_ranges();
-    void process_frame();
+    void analyze_frame();
+    void compute_band_magnitudes_generic();
+    void compute_band_magnitudes_sparse();
+    void bands_from_power(const float* power, float* magnitudes) const;
+    void separate_harmonic_percussive();
+    void smooth_bands(const std::vector<float>& magnitudes, std::vector<float>& energies) const;
 
+    std::string name_;
     std::uint32_t sample_rate_;
-    std::uint32_t channels_;
     std::size_t fft_size_;
     std::size_t hop_size_;
+    std::size_t zero_pad_factor_;
+    std::size_t transform_size_; // fft_size_ * zero_pad_factor_
 
     std::vector<float> window_;
     std::vector<float> frame_buffer_;
-    std::deque<float> mono_fifo_;
+    bool active_ = true;
+    std::size_t samples_until_hop_ = 0;
 
     std::vector<float> band_energies_;
-    std::vector<std::pair<std::size_t, std::size_t>> band_bin_ranges_;
+    std::vector<BandBinRange> band_bin_ranges_;
+    std::vector<float> band_magnitudes_;
     std::vector<float> prev_magnitudes_;
 
+    std::unique_ptr<SpectrumKernel> kernel_;
+
+    // Sparse mode: sparse_bands_[i] sums sparse_power_ over [sparse_offsets_[i], sparse_offsets_[i + 1]).
+    bool sparse_active_;
+    GoertzelBank goertzel_;
+    std::vector<std::size_t> sparse_bands_;
+    std::vector<std::size_t> sparse_offsets_;
+    std::vector<std::size_t> sparse_slots_;
+    std::vector<float> sparse_power_;
+
+    // Generic real FFT: a transform_size_/2 complex FFT of the even/odd packed frame plus a
+    // split pass using the split_* twiddles.
     kiss_fft_cfg fft_cfg_;
     std::vector<kiss_fft_cpx> fft_in_;
     std::vector<kiss_fft_cpx> fft_out_;
+    std::vector<float> split_re_;
+    std::vector<float> split_im_;
+    std::vector<float> spectrum_power_;
+
+    std::unique_ptr<HarmonicPercussiveSeparator> hpss_;
+    std::vector<float> harmonic_power_;
+    std::vector<float> percussive_power_;
+    std::vector<float> harmonic_magnitudes_;
+    std::vector<float> percussive_magnitudes_;
+    std::vector<float> harmonic_bands_;
+    std::vector<float> percussive_bands_;
 
     float smoothing_attack_;
     float smoothing_release_;
     float flux_average_;
     float beat_strength_;
+    bool above_threshold_;
+    bool onset_;
+};
+
+// Downmixes the input into one shared sample history and runs any number of analysis
+// profiles over it, each on its own hop schedule. Profile 0 is the default profile built
+// from the constructor arguments; the unindexed accessors refer to it.
+class DspEngine {
+public:
+    static constexpr std::size_t kDefaultFftSize = 1024;
+    static constexpr std::size_t kDefaultHopSize = kDefaultFftSize / 2;
+    static constexpr std::size_t kDefaultBands = 16;
+
+    DspEngine(std::uint32_t sample_rate,
+              std::uint32_t channels,
+              std::size_t fft_size = kDefaultFftSize,
+              std::size_t hop_size = kDefaultHopSize,
+              std::size_t bands = kDefaultBands,
+              bool use_specialized_kernels = true,
+              std::size_t zero_pad_factor = 1);
+
+    void push_samples(const float* interleaved_samples, std::size_t count);
+
+    // Adds a named profile reading the same history; returns its index.
+    std::size_t add_profile(const std::string& name,
+                            std::size_t fft_size,
+                            std::size_t hop_size,
+                            std::size_t bands,
+                            std::size_t zero_pad_factor = 1);
+    std::size_t profile_count() const { return profiles_.size(); }
+    SpectrumAnalyzer& profile(std::size_t index) { return *profiles_[index]; }
+    const SpectrumAnalyzer& profile(std::size_t index) const { return *profiles_[index]; }
+    std::optional<std::size_t> find_profile(const std::string& name) const;
+
+    const std::vector<float>& band_energies() const { return profiles_.front()->band_energies(); }
+    float beat_strength() const { return profiles_.front()->beat_strength(); }
+    bool onset() const { return profiles_.front()->onset(); }
+    std::size_t fft_size() const { return profiles_.front()->fft_size(); }
+    std::size_t hop_size() const { return profiles_.front()->hop_size(); }
+    std::size_t zero_pad_factor() const { return profiles_.front()->zero_pad_factor(); }
+    void set_required_bands(const std::optional<std::vector<std::size_t>>& bands) {
+        profiles_.front()->set_required_bands(bands);
+    }
+    bool using_sparse_bank() const { return profiles_.front()->using_sparse_bank(); }
+    std::size_t sparse_bin_count() const { return profiles_.front()->sparse_bin_count(); }
+    bool using_specialized_kernel() const { return profiles_.front()->using_specialized_kernel(); }
+
+    // Runs a YIN pitch tracker over the shared history on the default profile's hop,
+    // independently of which profiles are active.
+    void enable_pitch_tracking(float min_frequency_hz, float max_frequency_hz);
+    bool pitch_tracking() const { return pitch_ != nullptr; }
+    float pitch_frequency() const { return pitch_ ? pitch_->frequency() : 0.0f; }
+    float pitch_confidence() const { return pitch_ ? pitch_->confidence() : 0.0f; }
+
+private:
+    void reserve_history(std::size_t length);
+    void copy_history(float* destination, std::size_t length) const;
+
+    std::uint32_t sample_rate_;
+    std::uint32_t channels_;
+    bool use_specialized_kernels_;
+
+    // Ring of mono samples, power-of-two sized to the longest profile window.
+    std::vector<float> history_;
+    std::size_t history_mask_;
+    std::uint64_t write_position_;
+
+    std::vector<std::unique_ptr<SpectrumAnalyzer>> profiles_;
+
+    std::unique_ptr<PitchTracker> pitch_;
+    std::vector<float> pitch_frame_;
+    std::size_t pitch_hop_ = 0;
+    std::size_t pitch_until_hop_ = 0;
 };
 
 } // namespace why
@@ -0,0 +1,39 @@
+#include "dsp_kernel.h"
+
+namespace why {
+
+namespace {
+
+template<std::size_t FftSize, std::size_t Bands>
+std::unique_ptr<SpectrumKernel> make_kernel(std::size_t zero_pad_factor, const std::vector<BandBinRange>& band_ranges) {
+    switch (zero_pad_factor) {
+    case 1:
+        return std::make_unique<DspKernel<FftSize, Bands, 1>>(band_ranges);
+    case 2:
+        return std::make_unique<DspKernel<FftSize, Bands, 2>>(band_ranges);
+    case 4:
+        return std::make_unique<DspKernel<FftSize, Bands, 4>>(band_ranges);
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<SpectrumKernel> make_specialized_kernel(std::size_t fft_size,
+                                                        std::size_t zero_pad_factor,
+                                                        const std::vector<BandBinRange>& band_ranges) {
+    const std::size_t bands = band_ranges.size();
+    if (fft_size == 1024 && bands == 32) {
+        return make_kernel<1024, 32>(zero_pad_factor, band_ranges);
+    }
+    if (fft_size == 2048 && bands == 64) {
+        return make_kernel<2048, 64>(zero_pad_factor, band_ranges);
+    }
+    if (fft_size == 4096 && bands == 128) {
+        return make_kernel<4096, 128>(zero_pad_factor, band_ranges);
+    }
+    return nullptr;
+}
+
+} // namespace why
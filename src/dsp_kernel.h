@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace why {
+
+using BandBinRange = std::pair<std::size_t, std::size_t>;
+
+// Fixed-shape spectrum analyser used by DspEngine for its most common FFT/band presets.
+class SpectrumKernel {
+public:
+    virtual ~SpectrumKernel() = default;
+
+    virtual std::size_t fft_size() const = 0;
+    virtual std::size_t zero_pad_factor() const = 0;
+    virtual std::size_t band_count() const = 0;
+
+    // Windows `frame` (fft_size() samples), zero-pads it to fft_size() * zero_pad_factor(),
+    // transforms it and writes the RMS magnitude of every band into `band_magnitudes`
+    // (band_count() values).
+    virtual void analyze(const float* frame, float* band_magnitudes) = 0;
+
+    // Unnormalised |X[k]|^2 of the last analysed frame for the
+    // fft_size() * zero_pad_factor() / 2 + 1 non-negative frequency bins.
+    virtual const float* power() const = 0;
+};
+
+// Returns a compile-time specialised kernel for the given shape, or nullptr when no
+// specialisation exists and the caller should use the generic FFT path. Band ranges are in
+// bins of the zero-padded transform.
+std::unique_ptr<SpectrumKernel> make_specialized_kernel(std::size_t fft_size,
+                                                        std::size_t zero_pad_factor,
+                                                        const std::vector<BandBinRange>& band_ranges);
+
+namespace detail {
+
+constexpr double kKernelPi = 3.14159265358979323846;
+
+// Taylor-series sine that is usable in constant expressions; accurate to double precision
+// after range reduction to [-pi/2, pi/2].
+constexpr double constexpr_sin(double x) {
+    const double two_pi = 2.0 * kKernelPi;
+    const long long turns = static_cast<long long>(x / two_pi);
+    x -= static_cast<double>(turns) * two_pi;
+    if (x > kKernelPi) {
+        x -= two_pi;
+    } else if (x < -kKernelPi) {
+        x += two_pi;
+    }
+    if (x > kKernelPi / 2.0) {
+        x = kKernelPi - x;
+    } else if (x < -kKernelPi / 2.0) {
+        x = -kKernelPi - x;
+    }
+
+    const double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; ++n) {
+        term *= -x2 / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexpr_cos(double x) {
+    return constexpr_sin(x + kKernelPi / 2.0);
+}
+
+template<std::size_t N>
+constexpr std::array<float, N> make_hann_window() {
+    std::array<float, N> window{};
+    const double denominator = static_cast<double>(N - 1);
+    for (std::size_t i = 0; i < N; ++i) {
+        const double phase = (2.0 * kKernelPi * static_cast<double>(i)) / denominator;
+        window[i] = static_cast<float>(0.5 - 0.5 * constexpr_cos(phase));
+    }
+    return window;
+}
+
+template<std::size_t N>
+constexpr std::array<std::uint32_t, N> make_bit_reversal() {
+    std::array<std::uint32_t, N> table{};
+    std::size_t bits = 0;
+    while ((std::size_t{1} << bits) < N) {
+        ++bits;
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        std::size_t reversed = 0;
+        for (std::size_t b = 0; b < bits; ++b) {
+            if (i & (std::size_t{1} << b)) {
+                reversed |= std::size_t{1} << (bits - 1 - b);
+            }
+        }
+        table[i] = static_cast<std::uint32_t>(reversed);
+    }
+    return table;
+}
+
+// exp(-2*pi*i*k/Period) for k in [0, Count).
+template<std::size_t Count, std::size_t Period>
+constexpr std::array<float, Count> make_twiddle_real() {
+    std::array<float, Count> table{};
+    for (std::size_t k = 0; k < Count; ++k) {
+        table[k] = static_cast<float>(constexpr_cos(2.0 * kKernelPi * static_cast<double>(k) / static_cast<double>(Period)));
+    }
+    return table;
+}
+
+template<std::size_t Count, std::size_t Period>
+constexpr std::array<float, Count> make_twiddle_imag() {
+    std::array<float, Count> table{};
+    for (std::size_t k = 0; k < Count; ++k) {
+        table[k] = static_cast<float>(-constexpr_sin(2.0 * kKernelPi * static_cast<double>(k) / static_cast<double>(Period)));
+    }
+    return table;
+}
+
+} // namespace detail
+
+// Real-input FFT of FftSize * PadFactor points computed as a half-length complex FFT plus a
+// split pass; the window covers the first FftSize samples and the rest is zero padding.
+// Window, twiddle and bit-reversal tables are built at compile time and the band loop is
+// unrolled over Bands.
+template<std::size_t FftSize, std::size_t Bands, std::size_t PadFactor = 1>
+class DspKernel final : public SpectrumKernel {
+    static_assert(FftSize >= 4 && (FftSize & (FftSize - 1)) == 0, "FFT size must be a power of two");
+    static_assert(PadFactor >= 1 && (PadFactor & (PadFactor - 1)) == 0, "Pad factor must be a power of two");
+    static_assert(Bands > 0, "At least one band is required");
+
+public:
+    static constexpr std::size_t kTransformSize = FftSize * PadFactor;
+    static constexpr std::size_t kHalf = kTransformSize / 2;
+    static constexpr std::size_t kBins = kHalf + 1;
+
+    explicit DspKernel(const std::vector<BandBinRange>& band_ranges) {
+        for (std::size_t band = 0; band < Bands; ++band) {
+            std::size_t start = 0;
+            std::size_t end = 1;
+            if (band < band_ranges.size()) {
+                start = std::min(band_ranges[band].first, kHalf);
+                end = std::min(band_ranges[band].second, kBins);
+            }
+            if (end <= start) {
+                end = start + 1;
+            }
+            band_starts_[band] = static_cast<std::uint32_t>(start);
+            band_ends_[band] = static_cast<std::uint32_t>(end);
+            band_scales_[band] = kNorm * kNorm / static_cast<float>(end - start);
+        }
+    }
+
+    std::size_t fft_size() const override { return FftSize; }
+    std::size_t zero_pad_factor() const override { return PadFactor; }
+    std::size_t band_count() const override { return Bands; }
+
+    void analyze(const float* frame, float* band_magnitudes) override {
+        load_frame(frame);
+        transform();
+        compute_power();
+        accumulate_bands(band_magnitudes, std::make_index_sequence<Bands>{});
+    }
+
+    const float* power() const override { return power_.data(); }
+
+private:
+    static constexpr float kNorm = 1.0f / static_cast<float>(FftSize);
+    static constexpr std::array<float, FftSize> kWindow = detail::make_hann_window<FftSize>();
+    static constexpr std::array<std::uint32_t, kHalf> kBitReversal = detail::make_bit_reversal<kHalf>();
+    static constexpr std::array<float, kHalf / 2> kTwiddleRe = detail::make_twiddle_real<kHalf / 2, kHalf>();
+    static constexpr std::array<float, kHalf / 2> kTwiddleIm = detail::make_twiddle_imag<kHalf / 2, kHalf>();
+    static constexpr std::array<float, kBins> kSplitRe = detail::make_twiddle_real<kBins, kTransformSize>();
+    static constexpr std::array<float, kBins> kSplitIm = detail::make_twiddle_imag<kBins, kTransformSize>();
+
+    void load_frame(const float* frame) {
+        // Even samples become the real part and odd samples the imaginary part of a
+        // half-length complex sequence, stored in bit-reversed order for the in-place FFT.
+        constexpr std::size_t kLoaded = FftSize / 2;
+        for (std::size_t k = 0; k < kLoaded; ++k) {
+            const std::size_t dst = kBitReversal[k];
+            re_[dst] = frame[2 * k] * kWindow[2 * k];
+            im_[dst] = frame[2 * k + 1] * kWindow[2 * k + 1];
+        }
+        if constexpr (PadFactor > 1) {
+            for (std::size_t k = kLoaded; k < kHalf; ++k) {
+                const std::size_t dst = kBitReversal[k];
+                re_[dst] = 0.0f;
+                im_[dst] = 0.0f;
+            }
+        }
+    }
+
+    void transform() {
+        for (std::size_t size = 2; size <= kHalf; size <<= 1) {
+            const std::size_t half = size >> 1;
+            const std::size_t step = kHalf / size;
+            for (std::size_t start = 0; start < kHalf; start += size) {
+                for (std::size_t j = 0; j < half; ++j) {
+                    const float wr = kTwiddleRe[j * step];
+                    const float wi = kTwiddleIm[j * step];
+                    const std::size_t a = start + j;
+                    const std::size_t b = a + half;
+                    const float tr = re_[b] * wr - im_[b] * wi;
+                    const float ti = re_[b] * wi + im_[b] * wr;
+                    re_[b] = re_[a] - tr;
+                    im_[b] = im_[a] - ti;
+                    re_[a] += tr;
+                    im_[a] += ti;
+                }
+            }
+        }
+    }
+
+    void compute_power() {
+        const float dc = re_[0] + im_[0];
+        const float nyquist = re_[0] - im_[0];
+        power_[0] = dc * dc;
+        power_[kHalf] = nyquist * nyquist;
+
+        for (std::size_t k = 1; k < kHalf; ++k) {
+            const float zr = re_[k];
+            const float zi = im_[k];
+            const float cr = re_[kHalf - k];
+            const float ci = -im_[kHalf - k];
+            // Even/odd spectra recovered from Z[k] and conj(Z[N/2 - k]).
+            const float er = 0.5f * (zr + cr);
+            const float ei = 0.5f * (zi + ci);
+            const float or_ = 0.5f * (zi - ci);
+            const float oi = -0.5f * (zr - cr);
+            const float wr = kSplitRe[k];
+            const float wi = kSplitIm[k];
+            const float xr = er + (or_ * wr - oi * wi);
+            const float xi = ei + (or_ * wi + oi * wr);
+            power_[k] = xr * xr + xi * xi;
+        }
+    }
+
+    template<std::size_t... BandIndex>
+    void accumulate_bands(float* band_magnitudes, std::index_sequence<BandIndex...>) const {
+        (accumulate_band<BandIndex>(band_magnitudes), ...);
+    }
+
+    template<std::size_t Band>
+    void accumulate_band(float* band_magnitudes) const {
+        float energy = 0.0f;
+        for (std::uint32_t bin = band_starts_[Band]; bin < band_ends_[Band]; ++bin) {
+            energy += power_[bin];
+        }
+        band_magnitudes[Band] = std::sqrt(std::max(energy * band_scales_[Band], 0.0f));
+    }
+
+    std::array<float, kHalf> re_{};
+    std::array<float, kHalf> im_{};
+    std::array<float, kBins> power_{};
+    std::array<std::uint32_t, Bands> band_starts_{};
+    std::array<std::uint32_t, Bands> band_ends_{};
+    std::array<float, Bands> band_scales_{};
+};
+
+} // namespace why
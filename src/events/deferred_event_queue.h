@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace why {
+namespace events {
+
+// Lock-free multi-producer, single-consumer queue of events posted from other threads and
+// dispatched later on the consumer (render) thread. Events are copied into one of two
+// bump-allocated arenas; the consumer flips arenas at every drain and recycles the one
+// whose events it has just dispatched, so posting never touches the heap. When an arena
+// fills up within a frame further posts are dropped and counted.
+class DeferredEventQueue {
+public:
+    using DispatchFn = void (*)(void* context, const void* payload);
+
+    static constexpr std::size_t kDefaultArenaBytes = 64 * 1024;
+
+    explicit DeferredEventQueue(std::size_t arena_bytes = kDefaultArenaBytes) {
+        const std::size_t slots = (arena_bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        for (Arena& arena : arenas_) {
+            arena.storage.resize(slots);
+        }
+    }
+
+    DeferredEventQueue(const DeferredEventQueue&) = delete;
+    DeferredEventQueue& operator=(const DeferredEventQueue&) = delete;
+
+    // Any thread. Copies `event` and queues `dispatch(context, copy)` for the next drain.
+    // Anything the event references must stay valid until then.
+    template<typename EventT>
+    bool post(const EventT& event, DispatchFn dispatch) {
+        static_assert(std::is_trivially_destructible_v<EventT>, "Deferred events are never destroyed");
+        static_assert(alignof(EventT) <= alignof(std::max_align_t), "Over-aligned event");
+        constexpr std::size_t bytes = round_up(sizeof(Node)) + round_up(sizeof(EventT));
+
+        Arena& arena = enter_arena();
+        void* memory = allocate(arena, bytes);
+        if (!memory) {
+            arena.writers.fetch_sub(1);
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Node* node = ::new (memory) Node{nullptr, dispatch};
+        ::new (static_cast<void*>(reinterpret_cast<unsigned char*>(node) + round_up(sizeof(Node)))) EventT(event);
+
+        node->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        arena.writers.fetch_sub(1);
+        return true;
+    }
+
+    // Consumer thread only. Dispatches everything posted before the call, each producer's
+    // events in the order it posted them. Events posted by the handlers themselves wait
+    // for the next drain.
+    void drain(void* context) {
+        // Direct new posts to the other arena, then wait out posts still writing into the
+        // current one; after that every node in it is reachable from head_.
+        const unsigned previous = current_.load();
+        current_.store(previous ^ 1u);
+        Arena& arena = arenas_[previous];
+        while (arena.writers.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        Node* reversed = head_.exchange(nullptr, std::memory_order_acquire);
+        Node* ordered = nullptr;
+        while (reversed) {
+            Node* next = reversed->next;
+            reversed->next = ordered;
+            ordered = reversed;
+            reversed = next;
+        }
+        for (Node* node = ordered; node; node = node->next) {
+            node->dispatch(context, reinterpret_cast<const unsigned char*>(node) + round_up(sizeof(Node)));
+        }
+
+        // Nodes in the other arena that were just dispatched stay valid until that arena is
+        // recycled at the next drain.
+        arena.used.store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Node {
+        Node* next;
+        DispatchFn dispatch;
+    };
+
+    struct Arena {
+        std::vector<std::max_align_t> storage;
+        std::atomic<std::size_t> used{0};
+        std::atomic<int> writers{0};
+    };
+
+    static constexpr std::size_t round_up(std::size_t bytes) {
+        constexpr std::size_t align = alignof(std::max_align_t);
+        return (bytes + align - 1) / align * align;
+    }
+
+    // Registers the caller as a writer of the current arena. The re-check pairs with the
+    // flip in drain(): a writer either registers before the consumer starts waiting or
+    // sees the flip and moves to the new arena.
+    Arena& enter_arena() {
+        while (true) {
+            const unsigned index = current_.load();
+            Arena& arena = arenas_[index];
+            arena.writers.fetch_add(1);
+            if (current_.load() == index) {
+                return arena;
+            }
+            arena.writers.fetch_sub(1);
+        }
+    }
+
+    static void* allocate(Arena& arena, std::size_t bytes) {
+        const std::size_t capacity = arena.storage.size() * sizeof(std::max_align_t);
+        const std::size_t offset = arena.used.fetch_add(bytes, std::memory_order_relaxed);
+        if (offset + bytes > capacity) {
+            return nullptr;
+        }
+        return reinterpret_cast<unsigned char*>(arena.storage.data()) + offset;
+    }
+
+    std::array<Arena, 2> arenas_;
+    std::atomic<unsigned> current_{0};
+    std::atomic<Node*> head_{nullptr};
+    std::atomic<std::size_t> dropped_{0};
+};
+
+} // namespace events
+} // namespace why
@@ -1,40 +1,52 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
-#include <functional>
-#include <typeindex>
-#include <typeinfo>
-#include <unordered_map>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "deferred_event_queue.h"
+#include "inline_delegate.h"
+#include "../profiler.h"
+
 namespace why {
 namespace events {
 
+// Dense channel index of an event type. Every published type specialises this next to its
+// definition (see frame_events.h) with a unique value below kMaxEventSlots and a `name`
+// for profiling; unregistered types fail to compile instead of silently missing their
+// subscribers.
+template<typename EventT>
+struct EventSlot;
+
+inline constexpr std::size_t kMaxEventSlots = 16;
+
+// Subscribing, unsubscribing and publishing belong to the render thread; handlers may
+// subscribe and unsubscribe (themselves included) while an event is being dispatched.
+// Other threads hand events over with post(), which dispatch_deferred() delivers.
 class EventBus {
 public:
     EventBus() = default;
     EventBus(const EventBus&) = delete;
     EventBus& operator=(const EventBus&) = delete;
 
-    template<typename EventT>
-    using Handler = std::function<void(const EventT&)>;
-
     class SubscriptionHandle {
     public:
         SubscriptionHandle() = default;
         SubscriptionHandle(const SubscriptionHandle&) = delete;
         SubscriptionHandle& operator=(const SubscriptionHandle&) = delete;
         SubscriptionHandle(SubscriptionHandle&& other) noexcept
-            : bus_(other.bus_), type_(other.type_), id_(other.id_) {
+            : bus_(other.bus_), slot_(other.slot_), id_(other.id_) {
             other.bus_ = nullptr;
         }
         SubscriptionHandle& operator=(SubscriptionHandle&& other) noexcept {
             if (this != &other) {
                 reset();
                 bus_ = other.bus_;
-                type_ = other.type_;
+                slot_ = other.slot_;
                 id_ = other.id_;
                 other.bus_ = nullptr;
             }
@@ -44,9 +56,9 @@ public:
 
         void reset() {
             if (bus_) {
-                bus_->unsubscribe(type_, id_);
+                bus_->unsubscribe(slot_, id_);
                 bus_ = nullptr;
-                type_ = std::type_index(typeid(void));
+                slot_ = 0;
                 id_ = 0;
             }
         }
@@ -55,78 +67,177 @@ public:
 
     private:
         friend class EventBus;
-        SubscriptionHandle(EventBus* bus, std::type_index type, std::size_t id)
-            : bus_(bus), type_(type), id_(id) {}
+        SubscriptionHandle(EventBus* bus, std::size_t slot, std::size_t id)
+            : bus_(bus), slot_(slot), id_(id) {}
 
         EventBus* bus_ = nullptr;
-        std::type_index type_{typeid(void)};
+        std::size_t slot_ = 0;
         std::size_t id_ = 0;
     };
 
-    template<typename EventT>
-    SubscriptionHandle subscribe(Handler<EventT> handler) {
-        auto wrapper = [handler = std::move(handler)](const void* event_ptr) {
-            handler(*static_cast<const EventT*>(event_ptr));
-        };
-        const std::type_index key(typeid(EventT));
-        auto& bucket = subscribers_[key];
+    // Handlers are stored inline (see InlineDelegate), so they must capture little: a
+    // `this` pointer and a pointer to long-lived configuration rather than copies.
+    template<typename EventT, typename Callable>
+    SubscriptionHandle subscribe(Callable&& handler) {
+        constexpr std::size_t slot = slot_of<EventT>();
         const std::size_t id = next_id_++;
-        bucket.push_back(SubscriberEntry{id, true, std::move(wrapper)});
-        return SubscriptionHandle(this, key, id);
+        Subscriber subscriber{id, true, kNoProbe, make_thunk<EventT>(std::forward<Callable>(handler))};
+        if (profiler_) {
+            const std::string owner = subscriber_label_.empty() ? "subscriber" : subscriber_label_;
+            subscriber.probe = profiler_->probe(owner + " <- " + EventSlot<std::remove_cv_t<EventT>>::name);
+        }
+        // Growing a channel mid-dispatch would move the running handler, so new
+        // subscribers join once the outermost publish returns.
+        if (dispatch_depth_ > 0) {
+            pending_.push_back(PendingSubscriber{slot, std::move(subscriber)});
+        } else {
+            channels_[slot].push_back(std::move(subscriber));
+        }
+        return SubscriptionHandle(this, slot, id);
     }
 
     template<typename EventT>
-    void publish(const EventT& event) const {
-        auto it = subscribers_.find(std::type_index(typeid(EventT)));
-        if (it == subscribers_.end()) {
-            return;
-        }
-        for (const auto& entry : it->second) {
-            if (entry.active) {
-                entry.handler(&event);
+    void publish(const EventT& event) {
+        const auto& channel = channels_[slot_of<EventT>()];
+        ++dispatch_depth_;
+        if (profiler_) {
+            publish_profiled(channel, &event);
+        } else {
+            for (std::size_t i = 0; i < channel.size(); ++i) {
+                if (channel[i].active) {
+                    channel[i].handler(&event);
+                }
             }
         }
+        if (--dispatch_depth_ == 0 && (needs_compaction_ || !pending_.empty())) {
+            apply_pending_changes();
+        }
     }
 
+    // Any thread. Queues a copy of `event` for the next dispatch_deferred(); see
+    // DeferredEventQueue for lifetime rules. Returns false when the frame arena is full.
+    template<typename EventT>
+    bool post(const EventT& event) {
+        return deferred_.post(event, [](void* bus, const void* payload) {
+            static_cast<EventBus*>(bus)->publish(*static_cast<const EventT*>(payload));
+        });
+    }
+
+    // Render thread. Publishes every posted event; call once per frame at a fixed point.
+    void dispatch_deferred() { deferred_.drain(this); }
+
+    std::size_t dropped_deferred_events() const { return deferred_.dropped(); }
+
+    // Times every handler subscribed from now on under "<label> <- <event>"; call before
+    // subscribing. nullptr turns timing off again.
+    void set_profiler(Profiler* profiler) { profiler_ = profiler; }
+
+    // Names the owner of the subscriptions made until the label is changed or cleared.
+    void set_subscriber_label(std::string label) { subscriber_label_ = std::move(label); }
+
     void reset() {
-        subscribers_.clear();
+        for (auto& channel : channels_) {
+            channel.clear();
+        }
+        pending_.clear();
+        needs_compaction_ = false;
         next_id_ = 0;
     }
 
 private:
-    using HandlerWrapper = std::function<void(const void*)>;
+    // The event type is erased to one pointer cast inside the stored callable, so a
+    // publish costs one indirect call per subscriber.
+    using Handler = InlineDelegate<void(const void*)>;
+
+    static constexpr Profiler::ProbeId kNoProbe = static_cast<Profiler::ProbeId>(-1);
 
-    struct SubscriberEntry {
+    struct Subscriber {
         std::size_t id;
         bool active;
-        HandlerWrapper handler;
+        Profiler::ProbeId probe;
+        Handler handler;
     };
 
-    void unsubscribe(const std::type_index& type, std::size_t id) {
-        auto it = subscribers_.find(type);
-        if (it == subscribers_.end()) {
+    struct PendingSubscriber {
+        std::size_t slot;
+        Subscriber subscriber;
+    };
+
+    template<typename EventT>
+    static constexpr std::size_t slot_of() {
+        constexpr std::size_t slot = EventSlot<std::remove_cv_t<EventT>>::value;
+        static_assert(slot < kMaxEventSlots, "Event slot out of range; raise kMaxEventSlots");
+        return slot;
+    }
+
+    template<typename EventT, typename Callable>
+    static Handler make_thunk(Callable&& handler) {
+        return Handler([handler = std::forward<Callable>(handler)](const void* event_ptr) mutable {
+            handler(*static_cast<const EventT*>(event_ptr));
+        });
+    }
+
+    void publish_profiled(const std::vector<Subscriber>& channel, const void* event) {
+        for (std::size_t i = 0; i < channel.size(); ++i) {
+            if (!channel[i].active) {
+                continue;
+            }
+            ProfileScope scope(channel[i].probe == kNoProbe ? nullptr : profiler_, channel[i].probe);
+            channel[i].handler(event);
+        }
+    }
+
+    void unsubscribe(std::size_t slot, std::size_t id) {
+        auto& channel = channels_[slot];
+        if (dispatch_depth_ == 0) {
+            channel.erase(std::remove_if(channel.begin(),
+                                         channel.end(),
+                                         [id](const Subscriber& subscriber) { return subscriber.id == id; }),
+                          channel.end());
             return;
         }
-        auto& entries = it->second;
-        for (auto& entry : entries) {
-            if (entry.id == id) {
-                entry.active = false;
-                break;
+
+        // The handler may be running right now; silence it and erase it afterwards.
+        for (Subscriber& subscriber : channel) {
+            if (subscriber.id == id) {
+                subscriber.active = false;
+                needs_compaction_ = true;
+            }
+        }
+        for (PendingSubscriber& pending : pending_) {
+            if (pending.subscriber.id == id) {
+                pending.subscriber.active = false;
+            }
+        }
+    }
+
+    void apply_pending_changes() {
+        if (needs_compaction_) {
+            for (auto& channel : channels_) {
+                channel.erase(std::remove_if(channel.begin(),
+                                             channel.end(),
+                                             [](const Subscriber& subscriber) { return !subscriber.active; }),
+                              channel.end());
             }
+            needs_compaction_ = false;
         }
-        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const SubscriberEntry& entry) {
-                           return !entry.active;
-                       }),
-                       entries.end());
-        if (entries.empty()) {
-            subscribers_.erase(it);
+        for (PendingSubscriber& pending : pending_) {
+            if (pending.subscriber.active) {
+                channels_[pending.slot].push_back(std::move(pending.subscriber));
+            }
         }
+        pending_.clear();
     }
 
-    std::unordered_map<std::type_index, std::vector<SubscriberEntry>> subscribers_;
+    std::array<std::vector<Subscriber>, kMaxEventSlots> channels_;
+    std::vector<PendingSubscriber> pending_;
+    std::size_t dispatch_depth_ = 0;
+    bool needs_compaction_ = false;
     std::size_t next_id_ = 0;
+    Profiler* profiler_ = nullptr;
+    std::string subscriber_label_;
+    DeferredEventQueue deferred_;
 };
 
 } // namespace events
 } // namespace why
-
@@ -1,21 +1,66 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include "../analysis_cache.h"
 #include "../audio_engine.h"
+#include "event_bus.h"
 
 namespace why {
 namespace events {
 
+// Published each frame for every audio source and subscribed analysis profile;
+// source_index 0 is the primary source and profile "" the [dsp] default.
 struct FrameUpdateEvent {
     float delta_time;
     const AudioMetrics& metrics;
     const std::vector<float>& bands;
+    const std::vector<float>& harmonic_bands;   // Empty unless dsp.hpss is enabled
+    const std::vector<float>& percussive_bands; // Empty unless dsp.hpss is enabled
     float beat_strength;
+    const std::string& source_id;
+    std::size_t source_index;
+    const std::string& profile;
+    const AnalysisCache* analysis; // Whole-track analysis for cached file sources, else nullptr
+    std::size_t analysis_hop;      // Hop in `analysis` matching this frame
+};
+template<> struct EventSlot<FrameUpdateEvent> : std::integral_constant<std::size_t, 0> {
+    static constexpr const char* name = "FrameUpdateEvent";
+};
+
+// Posted by sources with dsp.pitch_tracking enabled from their processing thread and
+// delivered at the start of the next animation update.
+struct PitchEvent {
+    float frequency;  // Hz; 0 when the latest window was unvoiced
+    float confidence; // 0..1
+    const std::string& source_id;
+    std::size_t source_index;
+};
+template<> struct EventSlot<PitchEvent> : std::integral_constant<std::size_t, 1> {
+    static constexpr const char* name = "PitchEvent";
 };
 
 struct BeatDetectedEvent {
     float strength;
+    const std::string& source_id;
+    std::size_t source_index;
+    const std::string& profile;
+};
+template<> struct EventSlot<BeatDetectedEvent> : std::integral_constant<std::size_t, 2> {
+    static constexpr const char* name = "BeatDetectedEvent";
+};
+
+// Published by the renderer once the terminal has been resized, before the next frame's
+// updates, with the new size of the standard plane.
+struct ResizeEvent {
+    unsigned int rows;
+    unsigned int cols;
+};
+template<> struct EventSlot<ResizeEvent> : std::integral_constant<std::size_t, 3> {
+    static constexpr const char* name = "ResizeEvent";
 };
 
 } // namespace events
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace why {
+namespace events {
+
+template<typename Signature, std::size_t Capacity = 64>
+class InlineDelegate;
+
+// Move-only callable wrapper that stores the callable in an inline buffer and dispatches
+// through a single function pointer. Unlike std::function it never allocates: callables
+// larger than Capacity are rejected at compile time, so captures should stay small
+// (pointers rather than copies of configuration structs).
+template<typename R, typename... Args, std::size_t Capacity>
+class InlineDelegate<R(Args...), Capacity> {
+public:
+    InlineDelegate() = default;
+
+    template<typename F,
+             typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<Fn, InlineDelegate>>>
+    InlineDelegate(F&& callable) {
+        static_assert(sizeof(Fn) <= Capacity, "Callable too large for InlineDelegate; capture less");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "Over-aligned callable");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>, "Callable must be nothrow movable");
+        ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(callable));
+        invoke_ = [](void* storage, Args... args) -> R {
+            return (*std::launder(static_cast<Fn*>(storage)))(std::forward<Args>(args)...);
+        };
+        relocate_ = [](void* destination, void* source) noexcept {
+            Fn* callable_ptr = std::launder(static_cast<Fn*>(source));
+            if (destination) {
+                ::new (destination) Fn(std::move(*callable_ptr));
+            }
+            callable_ptr->~Fn();
+        };
+    }
+
+    InlineDelegate(InlineDelegate&& other) noexcept { take(other); }
+
+    InlineDelegate& operator=(InlineDelegate&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    InlineDelegate(const InlineDelegate&) = delete;
+    InlineDelegate& operator=(const InlineDelegate&) = delete;
+
+    ~InlineDelegate() { reset(); }
+
+    void reset() noexcept {
+        if (relocate_) {
+            relocate_(nullptr, storage_);
+            invoke_ = nullptr;
+            relocate_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+    // Like std::function, calling is const even when the stored callable is mutable.
+    R operator()(Args... args) const {
+        return invoke_(const_cast<unsigned char*>(storage_), std::forward<Args>(args)...);
+    }
+
+private:
+    void take(InlineDelegate& other) noexcept {
+        if (other.relocate_) {
+            other.relocate_(storage_, other.storage_);
+            invoke_ = other.invoke_;
+            relocate_ = other.relocate_;
+            other.invoke_ = nullptr;
+            other.relocate_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    R (*invoke_)(void*, Args...) = nullptr;
+    void (*relocate_)(void* destination, void* source) noexcept = nullptr;
+};
+
+} // namespace events
+} // namespace why
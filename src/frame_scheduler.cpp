@@ -0,0 +1,222 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <thread>
+
+namespace why {
+
+namespace {
+
+// Behind by more than this many periods, catch-up gives up and re-anchors on the present.
+constexpr std::int64_t kMaxCatchUpFrames = 4;
+
+std::uint64_t to_ns(std::chrono::steady_clock::duration elapsed) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return ns < 0 ? 0u : static_cast<std::uint64_t>(ns);
+}
+
+void write_histogram(std::ostream& out, const char* name, const FrameHistogram& histogram) {
+    out << "    \"" << name << "\": {\"count\": " << histogram.count() << ", \"mean_us\": " << histogram.mean_us()
+        << ", \"p50_us\": " << histogram.percentile_us(0.50) << ", \"p99_us\": " << histogram.percentile_us(0.99)
+        << ", \"max_us\": " << histogram.max_us() << ", \"buckets\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < FrameHistogram::kBuckets; ++i) {
+        if (histogram.buckets()[i] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << "[" << FrameHistogram::bucket_lower_us(i) << ", " << histogram.buckets()[i]
+            << "]";
+        first = false;
+    }
+    out << "]}";
+}
+
+} // namespace
+
+const char* frame_stage_name(FrameStage stage) {
+    switch (stage) {
+    case FrameStage::Read:
+        return "read";
+    case FrameStage::Dsp:
+        return "dsp";
+    case FrameStage::Plugins:
+        return "plugins";
+    case FrameStage::Update:
+        return "update";
+    case FrameStage::Render:
+        return "render";
+    case FrameStage::Rasterize:
+        return "rasterize";
+    case FrameStage::Count:
+        break;
+    }
+    return "?";
+}
+
+std::optional<LateFramePolicy> parse_late_frame_policy(const std::string& name) {
+    if (name == "skip") {
+        return LateFramePolicy::Skip;
+    }
+    if (name == "catch_up") {
+        return LateFramePolicy::CatchUp;
+    }
+    if (name == "reset") {
+        return LateFramePolicy::Reset;
+    }
+    return std::nullopt;
+}
+
+void FrameHistogram::add(std::chrono::steady_clock::duration elapsed) {
+    const std::uint64_t ns = to_ns(elapsed);
+    const double us = static_cast<double>(ns) / 1000.0;
+    std::size_t bucket = 0;
+    if (us >= 1.0) {
+        bucket = std::min(kBuckets - 1,
+                          static_cast<std::size_t>(std::log2(us) * static_cast<double>(kBucketsPerOctave)));
+    }
+    ++buckets_[bucket];
+    ++count_;
+    total_ns_ += ns;
+    max_ns_ = std::max(max_ns_, ns);
+}
+
+double FrameHistogram::bucket_lower_us(std::size_t bucket) {
+    return bucket == 0 ? 0.0 : std::exp2(static_cast<double>(bucket) / static_cast<double>(kBucketsPerOctave));
+}
+
+double FrameHistogram::percentile_us(double fraction) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    const auto target = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i];
+        if (seen >= std::max<std::uint64_t>(1, target)) {
+            if (i == 0) {
+                return 0.0; // Under a microsecond
+            }
+            const double low = bucket_lower_us(i);
+            const double high = bucket_lower_us(i + 1);
+            return std::min(std::sqrt(low * high), max_us());
+        }
+    }
+    return max_us();
+}
+
+FrameScheduler::FrameScheduler(double target_fps, LateFramePolicy policy, Clock::duration spin, bool pace)
+    : target_fps_(target_fps),
+      period_(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_fps))),
+      policy_(policy),
+      spin_(std::max(spin, Clock::duration::zero())),
+      pace_(pace) {}
+
+void FrameScheduler::set_pacing(double target_fps, LateFramePolicy policy, Clock::duration spin) {
+    target_fps_ = target_fps;
+    period_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_fps));
+    policy_ = policy;
+    spin_ = std::max(spin, Clock::duration::zero());
+}
+
+FrameScheduler::Clock::time_point FrameScheduler::begin_frame() {
+    const Clock::time_point now = Clock::now();
+    if (!started_) {
+        started_ = true;
+        deadline_ = now;
+    } else {
+        interval_.add(now - frame_start_);
+        if (pace_) {
+            lateness_.add(now - deadline_);
+        }
+    }
+    frame_start_ = now;
+    stage_times_.fill(Clock::duration::zero());
+    return now;
+}
+
+void FrameScheduler::finish_frame() {
+    const Clock::time_point now = Clock::now();
+    ++frames_;
+    last_work_ = now - frame_start_;
+    work_.add(last_work_);
+    for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+        stages_[i].add(stage_times_[i]);
+    }
+    if (!pace_) {
+        return;
+    }
+
+    Clock::time_point next = deadline_ + period_;
+    if (now > next) {
+        ++late_frames_;
+        const std::int64_t behind = (now - next) / period_;
+        switch (policy_) {
+        case LateFramePolicy::Skip:
+            next += period_ * (behind + 1);
+            missed_deadlines_ += static_cast<std::uint64_t>(behind + 1);
+            break;
+        case LateFramePolicy::CatchUp:
+            if (behind >= kMaxCatchUpFrames) {
+                next = now;
+                missed_deadlines_ += static_cast<std::uint64_t>(behind);
+            }
+            break;
+        case LateFramePolicy::Reset:
+            next = now;
+            missed_deadlines_ += static_cast<std::uint64_t>(behind);
+            break;
+        }
+    }
+    deadline_ = next;
+    wait_until(next);
+}
+
+void FrameScheduler::wait_until(Clock::time_point deadline) const {
+    // sleep_until() may wake a scheduler tick late, so the last stretch is spun.
+    if (spin_ > Clock::duration::zero()) {
+        const Clock::time_point wake = deadline - spin_;
+        if (Clock::now() < wake) {
+            std::this_thread::sleep_until(wake);
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        return;
+    }
+    std::this_thread::sleep_until(deadline);
+}
+
+bool FrameScheduler::write_json(const std::string& path, std::string* error) const {
+    std::ofstream out(path);
+    if (!out) {
+        if (error) {
+            *error = "cannot open " + path + " for writing";
+        }
+        return false;
+    }
+
+    out << "{\n  \"target_fps\": " << target_fps_ << ",\n  \"frames\": " << frames_ << ",\n  \"late_frames\": "
+        << late_frames_ << ",\n  \"missed_deadlines\": " << missed_deadlines_ << ",\n  \"histograms\": {\n";
+    write_histogram(out, "frame", work_);
+    out << ",\n";
+    write_histogram(out, "interval", interval_);
+    out << ",\n";
+    write_histogram(out, "lateness", lateness_);
+    for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+        out << ",\n";
+        write_histogram(out, frame_stage_name(static_cast<FrameStage>(i)), stages_[i]);
+    }
+    out << "\n  }\n}\n";
+
+    if (!out) {
+        if (error) {
+            *error = "failed writing " + path;
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace why
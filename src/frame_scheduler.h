@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace why {
+
+// Parts of a frame, in the order the main loop runs them.
+enum class FrameStage : std::size_t {
+    Read,      // Pulling samples from the audio engines
+    Dsp,       // Analysing them
+    Plugins,
+    Update,    // Events and animation state
+    Render,    // Animations drawing into their planes
+    Rasterize, // notcurses_render(), or only rasterising into a buffer with pipelined output
+    Count,
+};
+
+inline constexpr std::size_t kFrameStageCount = static_cast<std::size_t>(FrameStage::Count);
+
+const char* frame_stage_name(FrameStage stage);
+
+// What to do once a frame ends after the next frame's deadline.
+enum class LateFramePolicy {
+    Skip,    // Drop the deadlines that already passed and stay on the original grid
+    CatchUp, // Start the missed frames straight away until back on schedule
+    Reset,   // Start the next frame now and count deadlines from there
+};
+
+std::optional<LateFramePolicy> parse_late_frame_policy(const std::string& name);
+
+// Log-spaced histogram of durations: four buckets per power of two from 1 us to ~4 s.
+// Percentiles are read from bucket midpoints, so they are accurate to about 10%.
+class FrameHistogram {
+public:
+    static constexpr std::size_t kBucketsPerOctave = 4;
+    static constexpr std::size_t kBuckets = 22 * kBucketsPerOctave;
+
+    void add(std::chrono::steady_clock::duration elapsed);
+
+    std::uint64_t count() const { return count_; }
+    double mean_us() const { return count_ ? static_cast<double>(total_ns_) / 1000.0 / static_cast<double>(count_) : 0.0; }
+    double max_us() const { return static_cast<double>(max_ns_) / 1000.0; }
+    double percentile_us(double fraction) const;
+
+    const std::array<std::uint64_t, kBuckets>& buckets() const { return buckets_; }
+    static double bucket_lower_us(std::size_t bucket);
+
+private:
+    std::array<std::uint64_t, kBuckets> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t total_ns_ = 0;
+    std::uint64_t max_ns_ = 0;
+};
+
+// Paces the main loop on absolute deadlines (start + n * period), so sleep overshoot does
+// not accumulate into a lower frame rate, and keeps histograms of how each frame went.
+//
+// The loop calls begin_frame(), reports the stages it timed, and calls finish_frame(),
+// which sleeps until shortly before the next deadline and spins for the rest. Without
+// pacing (headless runs) nothing waits and only the histograms are kept.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FrameScheduler(double target_fps, LateFramePolicy policy, Clock::duration spin, bool pace);
+
+    // Changes the pacing settings from the next deadline on (the last one plus the new
+    // period); the histograms carry on.
+    void set_pacing(double target_fps, LateFramePolicy policy, Clock::duration spin);
+
+    Clock::time_point begin_frame();
+    void record_stage(FrameStage stage, Clock::duration elapsed) {
+        stage_times_[static_cast<std::size_t>(stage)] += elapsed;
+    }
+    void finish_frame();
+
+    double target_fps() const { return target_fps_; }
+    std::uint64_t frames() const { return frames_; }
+    std::uint64_t late_frames() const { return late_frames_; }       // Ended past the next deadline
+    std::uint64_t missed_deadlines() const { return missed_deadlines_; } // Deadlines skipped entirely
+
+    Clock::duration last_work() const { return last_work_; }     // Of the last finished frame
+    const FrameHistogram& work() const { return work_; }         // begin_frame() to finish_frame()
+    const FrameHistogram& interval() const { return interval_; } // Start to start
+    const FrameHistogram& lateness() const { return lateness_; } // Start past its deadline
+    const FrameHistogram& stage(FrameStage stage) const { return stages_[static_cast<std::size_t>(stage)]; }
+
+    bool write_json(const std::string& path, std::string* error = nullptr) const;
+
+private:
+    void wait_until(Clock::time_point deadline) const;
+
+    double target_fps_;
+    Clock::duration period_;
+    LateFramePolicy policy_;
+    Clock::duration spin_;
+    bool pace_;
+
+    bool started_ = false;
+    Clock::time_point deadline_{};
+    Clock::time_point frame_start_{};
+    std::array<Clock::duration, kFrameStageCount> stage_times_{};
+
+    std::uint64_t frames_ = 0;
+    Clock::duration last_work_{};
+    std::uint64_t late_frames_ = 0;
+    std::uint64_t missed_deadlines_ = 0;
+    FrameHistogram work_;
+    FrameHistogram interval_;
+    FrameHistogram lateness_;
+    std::array<FrameHistogram, kFrameStageCount> stages_;
+};
+
+} // namespace why
@@ -0,0 +1,49 @@
+#include "goertzel_bank.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace why {
+
+namespace {
+constexpr double kTwoPi = 6.28318530717958647692;
+} // namespace
+
+void GoertzelBank::configure(const std::vector<std::size_t>& bins, std::size_t transform_size) {
+    bin_count_ = bins.size();
+    const std::size_t padded = ((bin_count_ + kLanes - 1) / kLanes) * kLanes;
+    coefficients_.assign(padded, 0.0f);
+    for (std::size_t i = 0; i < bin_count_; ++i) {
+        const double omega = kTwoPi * static_cast<double>(bins[i]) / static_cast<double>(transform_size);
+        coefficients_[i] = static_cast<float>(2.0 * std::cos(omega));
+    }
+}
+
+void GoertzelBank::evaluate(const float* frame, const float* window, std::size_t length, float* power) {
+    windowed_.resize(length);
+    for (std::size_t n = 0; n < length; ++n) {
+        windowed_[n] = frame[n] * window[n];
+    }
+
+    for (std::size_t group = 0; group < coefficients_.size(); group += kLanes) {
+        const float* coeff = coefficients_.data() + group;
+        float s1[kLanes] = {};
+        float s2[kLanes] = {};
+        for (std::size_t n = 0; n < length; ++n) {
+            const float x = windowed_[n];
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                const float s0 = x + coeff[lane] * s1[lane] - s2[lane];
+                s2[lane] = s1[lane];
+                s1[lane] = s0;
+            }
+        }
+
+        const std::size_t lanes = std::min(kLanes, bin_count_ - group);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            power[group + lane] =
+                std::max(s1[lane] * s1[lane] + s2[lane] * s2[lane] - coeff[lane] * s1[lane] * s2[lane], 0.0f);
+        }
+    }
+}
+
+} // namespace why
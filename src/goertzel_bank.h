@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace why {
+
+// Evaluates a handful of DFT bins directly with the Goertzel recurrence. Bins are processed
+// in fixed groups of kLanes independent recurrences held as structure-of-arrays, so the
+// per-sample update vectorises across bins and hides the recurrence latency; for a few bins
+// this is cheaper than a full FFT of the frame.
+class GoertzelBank {
+public:
+    static constexpr std::size_t kLanes = 16;
+
+    // `bins` index the DFT of length `transform_size`; frames may be shorter (zero padded).
+    void configure(const std::vector<std::size_t>& bins, std::size_t transform_size);
+
+    // Windows `length` samples of `frame` and writes the unnormalised power of every
+    // configured bin into `power` (bin_count() values), matching |X[k]|^2 of an FFT.
+    void evaluate(const float* frame, const float* window, std::size_t length, float* power);
+
+    std::size_t bin_count() const { return bin_count_; }
+
+private:
+    std::size_t bin_count_ = 0;
+    std::vector<float> coefficients_; // Padded to a multiple of kLanes; spare lanes are idle
+    std::vector<float> windowed_;
+};
+
+} // namespace why
@@ -0,0 +1,86 @@
+#include "hpss.h"
+
+#include <algorithm>
+
+namespace why {
+
+SlidingMedian::SlidingMedian(std::size_t window)
+    : arrivals_(std::max<std::size_t>(1, window), 0.0f),
+      sorted_(std::max<std::size_t>(1, window), 0.0f) {}
+
+void SlidingMedian::reset() {
+    head_ = 0;
+    size_ = 0;
+}
+
+void SlidingMedian::push(float value) {
+    const std::size_t window = arrivals_.size();
+    if (size_ == window) {
+        pop();
+    }
+    arrivals_[(head_ + size_) % window] = value;
+
+    const auto end = sorted_.begin() + static_cast<std::ptrdiff_t>(size_);
+    const auto it = std::upper_bound(sorted_.begin(), end, value);
+    std::copy_backward(it, end, end + 1);
+    *it = value;
+    ++size_;
+}
+
+void SlidingMedian::pop() {
+    if (size_ == 0) {
+        return;
+    }
+    erase_sorted(arrivals_[head_]);
+    head_ = (head_ + 1) % arrivals_.size();
+    --size_;
+}
+
+void SlidingMedian::erase_sorted(float value) {
+    const auto end = sorted_.begin() + static_cast<std::ptrdiff_t>(size_);
+    const auto it = std::lower_bound(sorted_.begin(), end, value);
+    if (it != end) {
+        std::copy(it + 1, end, it);
+    }
+}
+
+HarmonicPercussiveSeparator::HarmonicPercussiveSeparator(std::size_t bins,
+                                                         std::size_t time_kernel,
+                                                         std::size_t frequency_kernel)
+    : time_medians_(bins, SlidingMedian(time_kernel)),
+      frequency_median_(frequency_kernel | 1),
+      frequency_half_width_((frequency_kernel | 1) / 2) {}
+
+void HarmonicPercussiveSeparator::process(const float* power, float* harmonic, float* percussive) {
+    const std::size_t bins = time_medians_.size();
+    const std::size_t half_width = frequency_half_width_;
+
+    // Slide a centred window along frequency: bin b sees [b - half_width, b + half_width],
+    // clipped at both ends of the spectrum.
+    frequency_median_.reset();
+    for (std::size_t bin = 0; bin < std::min(half_width, bins); ++bin) {
+        frequency_median_.push(power[bin]);
+    }
+
+    for (std::size_t bin = 0; bin < bins; ++bin) {
+        if (bin + half_width < bins) {
+            frequency_median_.push(power[bin + half_width]);
+        } else if (bin > half_width) {
+            frequency_median_.pop();
+        }
+        const float percussive_estimate = frequency_median_.median();
+
+        SlidingMedian& time_median = time_medians_[bin];
+        time_median.push(power[bin]);
+        const float harmonic_estimate = time_median.median();
+
+        // Medians are order statistics, so filtering power equals squaring the filtered
+        // magnitudes; the masks are therefore the usual power-2 Wiener masks.
+        const float total = harmonic_estimate + percussive_estimate;
+        const float harmonic_share = (total > 0.0f) ? harmonic_estimate / total : 0.5f;
+        harmonic[bin] = power[bin] * harmonic_share;
+        percussive[bin] = power[bin] - harmonic[bin];
+    }
+}
+
+} // namespace why
@@ -3,18 +3,88 @@
 #include <cmath>
 #include <clocale>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 
-#include "audio_engine.h"
+#include "audio_sources.h"
 #include "config.h"
-#include "dsp.h"
+#include "config_watcher.h"
+#include "frame_scheduler.h"
 #include "plugins.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "terminal_writer.h"
+#include "worker_pool.h"
 #include "animations/random_text_animation.h"
 
+namespace {
+
+constexpr long kDefaultHeadlessFrames = 600;
+
+// Frame-time percentiles of a headless run: the whole frame and its stages, then one
+// line per probe.
+void print_headless_report(const why::FrameScheduler& scheduler,
+                           const why::TerminalWriter* writer,
+                           const why::OutputBudget& output,
+                           const std::string& quality,
+                           const why::Profiler& profiler,
+                           double elapsed_s) {
+    const auto print_histogram = [](const char* name, const why::FrameHistogram& histogram) {
+        std::printf("%-48s %8llu %9.1f %9.1f %9.1f %9.1f\n",
+                    name,
+                    static_cast<unsigned long long>(histogram.count()),
+                    histogram.mean_us(),
+                    histogram.percentile_us(0.50),
+                    histogram.percentile_us(0.99),
+                    histogram.max_us());
+    };
+
+    const auto frames = static_cast<unsigned long long>(scheduler.frames());
+    std::printf("[headless] %llu frames in %.3f s (%.1f fps)\n",
+                frames,
+                elapsed_s,
+                elapsed_s > 0.0 ? static_cast<double>(frames) / elapsed_s : 0.0);
+    std::printf("%-48s %8s %9s %9s %9s %9s\n", "stage", "frames", "mean_us", "p50_us", "p99_us", "max_us");
+    print_histogram("frame", scheduler.work());
+    for (std::size_t i = 0; i < why::kFrameStageCount; ++i) {
+        const auto stage = static_cast<why::FrameStage>(i);
+        print_histogram(why::frame_stage_name(stage), scheduler.stage(stage));
+    }
+    const double output_kb_per_frame =
+        output.frames() ? static_cast<double>(output.total_bytes()) / 1024.0 / static_cast<double>(output.frames()) : 0.0;
+    std::printf("[headless] terminal output: %llu bytes, %.1f KB/frame (colour step %u, reuse %u at exit)\n",
+                static_cast<unsigned long long>(output.total_bytes()),
+                output_kb_per_frame,
+                output.quantization().step,
+                output.quantization().reuse_threshold);
+    if (!quality.empty()) {
+        std::printf("[headless] reduced quality at exit: %s\n", quality.c_str());
+    }
+    if (writer) {
+        print_histogram("write (output thread)", writer->write_times());
+        std::printf("[headless] output: %llu frames written (%llu bytes), %llu not sent while writing\n",
+                    static_cast<unsigned long long>(writer->written_frames()),
+                    static_cast<unsigned long long>(writer->written_bytes()),
+                    static_cast<unsigned long long>(writer->skipped_frames()));
+    }
+    std::printf("\n%-48s %8s %9s %9s %9s %9s\n", "probe", "calls", "mean_us", "p50_us", "p99_us", "max_us");
+    for (const why::Profiler::Stats& stats : profiler.snapshot()) {
+        std::printf("%-48.48s %8llu %9.1f %9.1f %9.1f %9.1f\n",
+                    stats.name.c_str(),
+                    static_cast<unsigned long long>(stats.calls),
+                    stats.mean_us,
+                    stats.p50_us,
+                    stats.p99_us,
+                    stats.max_us);
+    }
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
     std::setlocale(LC_ALL, "");
 
@@ -22,6 +92,8 @@ int main(int argc, char** argv) {
     std::string file_path;
     std::string device_name_override;
     int system_override = -1; // -1 = use config, 0 = mic, 1 = system
+    bool headless = false;
+    long headless_frames = kDefaultHeadlessFrames;
     for (int i = 1; i < argc; ++i) {
         const std::string arg = argv[i];
         if ((arg == "--config" || arg == "-c") && i + 1 < argc) {
@@ -47,10 +119,19 @@ int main(int argc, char** argv) {
             system_override = 0;
             continue;
         }
+        if (arg == "--headless") {
+            headless = true;
+            continue;
+        }
+        if (arg == "--frames" && i + 1 < argc) {
+            headless_frames = std::max(1L, std::strtol(argv[i + 1], nullptr, 10));
+            ++i;
+            continue;
+        }
     }
 
     const why::ConfigLoadResult config_result = why::load_app_config(config_path);
-    const why::AppConfig& config = config_result.config;
+    why::AppConfig config = config_result.config; // Replaced by hot reloads
     if (!config_result.loaded_file) {
         std::clog << "[config] using built-in defaults (missing '" << config_path << "')" << std::endl;
     } else {
@@ -60,125 +141,218 @@ int main(int argc, char** argv) {
         std::cerr << "[config] " << warning << std::endl;
     }
 
-    if (file_path.empty() && config.audio.prefer_file && config.audio.file.enabled && !config.audio.file.path.empty()) {
-        file_path = config.audio.file.path;
+    why::AudioSourceOverrides overrides;
+    overrides.file_path = file_path;
+    overrides.device = device_name_override;
+    overrides.system = system_override;
+    std::vector<std::unique_ptr<why::AudioSource>> sources = why::create_audio_sources(config, overrides);
+    for (const auto& source : sources) {
+        source->start();
     }
 
-    std::string capture_device = config.audio.capture.device;
-    if (!device_name_override.empty()) {
-        capture_device = device_name_override;
+    // Each source owns its own ring buffer and DSP state, so their analyses run side by
+    // side; the calling thread takes one share of the work. Parallel animation updates
+    // share the pool, so it may also grow to one thread per animation.
+    std::size_t parallel_items = sources.size();
+    if (config.runtime.parallel_updates) {
+        parallel_items = std::max(parallel_items, config.animations.size());
     }
-    bool use_system_audio = config.audio.capture.system;
-    if (system_override == 1) {
-        use_system_audio = true;
-    } else if (system_override == 0) {
-        use_system_audio = false;
-    }
-
-    const bool use_file_stream = config.audio.file.enabled && !file_path.empty();
-    const ma_uint32 sample_rate = config.audio.capture.sample_rate;
-    ma_uint32 channels = use_file_stream ? config.audio.file.channels : config.audio.capture.channels;
-    if (channels == 0) {
-        channels = 1;
-    }
-    const std::size_t ring_frames = std::max<std::size_t>(1024, config.audio.capture.ring_frames);
-
-    why::AudioEngine audio(sample_rate,
-                           channels,
-                           ring_frames,
-                           use_file_stream ? file_path : std::string{},
-                           capture_device,
-                           use_system_audio);
-    bool audio_active = false;
-    if (use_file_stream || config.audio.capture.enabled) {
-        audio_active = audio.start();
-        if (!audio_active) {
-            std::cerr << "[audio] failed to start audio backend";
-            if (!audio.last_error().empty()) {
-                std::cerr << ": " << audio.last_error();
-            }
-            std::cerr << std::endl;
+    why::WorkerPool worker_pool(
+        why::WorkerPool::resolve_worker_count(config.runtime.worker_threads, parallel_items - 1));
+    const auto stop_sources = [&sources]() {
+        for (const auto& source : sources) {
+            source->stop();
         }
-    }
+    };
 
-    why::DspEngine dsp(sample_rate,
-                       channels,
-                       config.dsp.fft_size,
-                       config.dsp.hop_size,
-                       config.dsp.bands);
+    // Null unless runtime.profiling is on (or the run is headless, which reports the
+    // timings); every instrumented call site checks the pointer.
+    std::unique_ptr<why::Profiler> profiler;
+    if (config.runtime.profiling || headless) {
+        profiler = std::make_unique<why::Profiler>();
+    }
 
     why::PluginManager plugin_manager;
     why::register_builtin_plugins(plugin_manager);
+    plugin_manager.set_profiler(profiler.get());
     plugin_manager.load_from_config(config);
     for (const std::string& warning : plugin_manager.warnings()) {
         std::cerr << "[plugin] " << warning << std::endl;
     }
 
-    notcurses_options opts{};
-    opts.flags = NCOPTION_SUPPRESS_BANNERS;
-    notcurses* nc = notcurses_init(&opts, nullptr);
+    std::FILE* headless_sink = nullptr;
+    notcurses* nc = why::start_notcurses(headless ? why::RenderBackend::Headless : why::RenderBackend::Terminal,
+                                         &headless_sink);
     if (!nc) {
         std::cerr << "Failed to initialize notcurses" << std::endl;
-        audio.stop();
+        stop_sources();
         return 1;
     }
 
 
 
-    const std::chrono::duration<double> frame_time(1.0 / config.visual.target_fps);
+    // Frames go to the same stream notcurses was started on.
+    std::unique_ptr<why::TerminalWriter> terminal_writer;
+    if (config.runtime.pipelined_output) {
+        terminal_writer = std::make_unique<why::TerminalWriter>(fileno(headless_sink ? headless_sink : stdout));
+    }
 
-    const std::size_t scratch_samples = std::max<std::size_t>(4096, ring_frames * static_cast<std::size_t>(channels));
-    std::vector<float> audio_scratch(scratch_samples);
-    why::AudioMetrics audio_metrics{};
-    audio_metrics.active = audio_active;
+    const std::chrono::duration<double> frame_time(1.0 / config.visual.target_fps);
 
     // Load animations from config
-    why::load_animations_from_config(nc, config);
+    why::Renderer renderer;
+    renderer.set_profiler(profiler.get());
+    renderer.load_animations(nc, config);
+    renderer.configure_source_analysis(sources, plugin_manager.uses_band_energies());
+    renderer.connect_source_events(sources);
+    if (config.runtime.parallel_updates) {
+        renderer.set_worker_pool(&worker_pool);
+    }
+
+    // Headless runs go flat out; the histograms are still kept for the report.
+    using Clock = why::FrameScheduler::Clock;
+    why::FrameScheduler scheduler(
+        config.visual.target_fps,
+        why::parse_late_frame_policy(config.visual.late_frames).value_or(why::LateFramePolicy::Skip),
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(config.visual.spin_ms)),
+        !headless);
+    renderer.set_frame_scheduler(&scheduler);
+    renderer.set_terminal_writer(terminal_writer.get());
+
+    // Headless runs are benchmarks, so they keep the config they started with.
+    std::unique_ptr<why::ConfigWatcher> config_watcher;
+    if (config.runtime.hot_reload && !headless) {
+        config_watcher = std::make_unique<why::ConfigWatcher>(config_path);
+        if (!config_watcher->watching()) {
+            std::cerr << "[config] cannot watch '" << config_path << "'; edits need a restart" << std::endl;
+            config_watcher.reset();
+        }
+    }
+
+    // Applies a config the watcher parsed, between two frames. Only what changed is
+    // rebuilt; the audio streams keep running throughout.
+    const auto apply_reload = [&](why::ConfigLoadResult reloaded) {
+        for (const std::string& warning : reloaded.warnings) {
+            std::cerr << "[config] " << warning << std::endl;
+        }
+        why::AppConfig& next = reloaded.config;
+        // Settings the running process was built around stay as they are.
+        if (next.audio != config.audio) {
+            std::clog << "[config] [audio] changes take effect after a restart" << std::endl;
+            next.audio = config.audio;
+        }
+        if (next.runtime.worker_threads != config.runtime.worker_threads ||
+            next.runtime.profiling != config.runtime.profiling ||
+            next.runtime.pipelined_output != config.runtime.pipelined_output ||
+            next.runtime.hot_reload != config.runtime.hot_reload) {
+            std::clog << "[config] runtime.worker_threads, profiling, pipelined_output and hot_reload take effect "
+                         "after a restart"
+                      << std::endl;
+            next.runtime.worker_threads = config.runtime.worker_threads;
+            next.runtime.profiling = config.runtime.profiling;
+            next.runtime.pipelined_output = config.runtime.pipelined_output;
+            next.runtime.hot_reload = config.runtime.hot_reload;
+        }
+
+        const why::ConfigChanges changes = why::diff_app_config(config, next);
+        if (!changes.any()) {
+            return;
+        }
+        const auto reload_start = Clock::now();
+        if (changes.dsp) {
+            for (const auto& source : sources) {
+                source->reconfigure_dsp(next);
+            }
+        }
+        // on_load() sees the whole config; beat-flash-debug reads [runtime] and [dsp] too.
+        if (changes.plugins || changes.runtime || changes.dsp) {
+            plugin_manager.load_from_config(next);
+            for (const std::string& warning : plugin_manager.warnings()) {
+                std::cerr << "[plugin] " << warning << std::endl;
+            }
+        }
+        std::size_t rebuilt = 0;
+        if (changes.animations || changes.dsp) {
+            rebuilt = renderer.reload_animations(nc, config, next);
+        }
+        if (changes.visual) {
+            renderer.apply_visual_config(next.visual);
+            scheduler.set_pacing(
+                next.visual.target_fps,
+                why::parse_late_frame_policy(next.visual.late_frames).value_or(why::LateFramePolicy::Skip),
+                std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(next.visual.spin_ms)));
+        }
+        if (next.runtime.parallel_updates != config.runtime.parallel_updates) {
+            renderer.set_worker_pool(next.runtime.parallel_updates ? &worker_pool : nullptr);
+        }
+        if (changes.animations || changes.dsp || changes.plugins || changes.runtime) {
+            renderer.configure_source_analysis(sources, plugin_manager.uses_band_energies());
+        }
+        config = std::move(next);
+        const auto reload_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - reload_start).count();
+        std::clog << "[config] reloaded '" << config_path << "' in " << reload_us << " us (" << rebuilt
+                  << " animation(s) rebuilt)" << std::endl;
+    };
 
     bool running = true;
-    const auto start_time = std::chrono::steady_clock::now();
+    const auto start_time = Clock::now();
 
     while (running) {
-        const auto now = std::chrono::steady_clock::now();
-        const auto elapsed = now - start_time;
-        const float time_s = std::chrono::duration_cast<std::chrono::duration<float>>(elapsed).count();
-
-        if (audio_active) {
-            const std::size_t samples_read = audio.read_samples(audio_scratch.data(), audio_scratch.size());
-            if (samples_read > 0) {
-                dsp.push_samples(audio_scratch.data(), samples_read);
-                double sum_squares = 0.0;
-                float peak_value = 0.0f;
-                for (std::size_t i = 0; i < samples_read; ++i) {
-                    const float sample = audio_scratch[i];
-                    sum_squares += static_cast<double>(sample) * static_cast<double>(sample);
-                    peak_value = std::max(peak_value, std::abs(sample));
-                }
-                const float rms_instant = std::sqrt(sum_squares / static_cast<double>(samples_read));
-                audio_metrics.rms = audio_metrics.rms * 0.9f + rms_instant * 0.1f;
-                audio_metrics.peak = std::max(peak_value, audio_metrics.peak * 0.95f);
-            } else {
-                audio_metrics.rms *= 0.98f;
-                audio_metrics.peak *= 0.98f;
+        const auto frame_start = scheduler.begin_frame();
+        float time_s = 0.0f;
+        if (headless) {
+            // Frames run back to back; animations still see the configured frame rate.
+            time_s = static_cast<float>(static_cast<double>(scheduler.frames()) * frame_time.count());
+        } else {
+            time_s = std::chrono::duration_cast<std::chrono::duration<float>>(frame_start - start_time).count();
+        }
+
+        auto stage_start = frame_start;
+        const auto end_stage = [&scheduler, &stage_start](why::FrameStage stage) {
+            const auto now = Clock::now();
+            scheduler.record_stage(stage, now - stage_start);
+            stage_start = now;
+        };
+
+        worker_pool.parallel_for(sources.size(), [&sources](std::size_t index) {
+            sources[index]->process();
+        });
+        // Sources are processed side by side, so the slowest read bounds the read stage.
+        {
+            const auto now = Clock::now();
+            const auto audio_time = now - stage_start;
+            Clock::duration read_time{};
+            for (const auto& source : sources) {
+                read_time = std::max(read_time, source->last_read_time());
             }
-            audio_metrics.dropped = audio.dropped_samples();
+            read_time = std::min(read_time, audio_time);
+            scheduler.record_stage(why::FrameStage::Read, read_time);
+            scheduler.record_stage(why::FrameStage::Dsp, audio_time - read_time);
+            stage_start = now;
         }
 
-        plugin_manager.notify_frame(audio_metrics, dsp.band_energies(), dsp.beat_strength(), time_s);
+        const why::AudioSource& primary = *sources.front();
+        plugin_manager.notify_frame(primary.metrics(), primary.bands(), primary.beat_strength(), time_s);
+        end_stage(why::FrameStage::Plugins);
 
-        why::render_frame(nc,
-                       time_s,
-                       audio_metrics,
-                       dsp.band_energies(),
-                       dsp.beat_strength(),
-                       audio.using_file_stream(),
-                       config.runtime.show_metrics,
-                       config.runtime.show_overlay_metrics);
+        renderer.update(time_s, sources);
+        end_stage(why::FrameStage::Update);
 
-        if (notcurses_render(nc) != 0) {
+        renderer.draw(nc, time_s, sources, config.runtime.show_metrics, config.runtime.show_overlay_metrics);
+        end_stage(why::FrameStage::Render);
+
+        if (!renderer.present(nc, time_s)) {
             std::cerr << "Failed to render frame" << std::endl;
             break;
         }
+        end_stage(why::FrameStage::Rasterize);
+
+        if (headless) {
+            scheduler.finish_frame();
+            running = scheduler.frames() < static_cast<std::uint64_t>(headless_frames);
+            continue;
+        }
 
         ncinput input{};
         const timespec ts{0, 0};
@@ -193,26 +367,69 @@ int main(int argc, char** argv) {
                 break;
             }
 
-
-
             if (key == NCKEY_RESIZE) {
+                if (config.runtime.allow_resize) {
+                    renderer.resize(nc);
+                }
                 break;
             }
         }
 
-        const auto frame_end = std::chrono::steady_clock::now();
-        if (frame_end - now < frame_time) {
-            std::this_thread::sleep_for(frame_time - (frame_end - now));
+        if (config_watcher) {
+            if (auto reloaded = config_watcher->take()) {
+                apply_reload(std::move(*reloaded));
+            }
         }
+
+        scheduler.finish_frame();
     }
 
-    audio.stop();
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+    stop_sources();
 
-    if (notcurses_stop(nc) != 0) {
+    // notcurses_stop() writes to the terminal too, so the last frames go out first.
+    if (terminal_writer) {
+        terminal_writer->drain();
+    }
+    // The animations' planes belong to nc, so they go before it does.
+    const std::string quality_summary = renderer.quality_summary();
+    renderer.shutdown();
+    const bool stopped = notcurses_stop(nc) == 0;
+    if (headless_sink) {
+        std::fclose(headless_sink);
+    }
+    if (!stopped) {
         std::cerr << "Failed to stop notcurses cleanly" << std::endl;
         return 1;
     }
 
+    if (headless) {
+        print_headless_report(scheduler,
+                              terminal_writer.get(),
+                              renderer.output_budget(),
+                              quality_summary,
+                              *profiler,
+                              elapsed_s);
+    }
+
+    if (!config.runtime.frame_stats_output.empty()) {
+        std::string error;
+        if (scheduler.write_json(config.runtime.frame_stats_output, &error)) {
+            std::clog << "[frames] Wrote " << config.runtime.frame_stats_output << std::endl;
+        } else {
+            std::cerr << "[frames] " << error << std::endl;
+        }
+    }
+
+    if (config.runtime.profiling) {
+        std::string error;
+        if (profiler->write_json(config.runtime.profile_output, &error)) {
+            std::clog << "[profile] Wrote " << config.runtime.profile_output << std::endl;
+        } else {
+            std::cerr << "[profile] " << error << std::endl;
+        }
+    }
+
     return 0;
 }
 
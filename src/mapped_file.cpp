@@ -0,0 +1,90 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace why {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        fallback_ = std::move(other.fallback_);
+        mapped_ = other.mapped_;
+        size_ = other.size_;
+        data_ = mapped_ ? other.data_ : fallback_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info {};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                ::close(fd);
+                data_ = static_cast<const unsigned char*>(mapping);
+                size_ = static_cast<std::size_t>(info.st_size);
+                mapped_ = true;
+                return true;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        return false;
+    }
+    const std::streamoff length = stream.tellg();
+    if (length <= 0) {
+        return false;
+    }
+    fallback_.resize(static_cast<std::size_t>(length));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(fallback_.data()), length)) {
+        fallback_.clear();
+        return false;
+    }
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#if !defined(_WIN32)
+    if (mapped_ && data_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+    fallback_.shrink_to_fit();
+}
+
+} // namespace why
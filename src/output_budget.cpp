@@ -0,0 +1,73 @@
+#include "output_budget.h"
+
+#include <algorithm>
+#include <array>
+
+namespace why {
+
+namespace {
+
+constexpr float kWindowS = 0.5f;
+constexpr double kRelaxFraction = 0.7;
+
+struct Level {
+    std::uint32_t step;
+    std::uint32_t reuse_threshold;
+};
+
+// Level 0 is the configured floor; every step roughly halves the distinct colours of a
+// ramp and widens the band in which a cell keeps its previous colour.
+constexpr std::array<Level, 6> kLevels = {{
+    {1, 0},
+    {4, 2},
+    {8, 4},
+    {16, 8},
+    {32, 16},
+    {64, 32},
+}};
+
+} // namespace
+
+OutputBudget::OutputBudget(double budget_kbps, const animations::ColourQuantization& floor)
+    : budget_kbps_(budget_kbps), floor_(floor) {}
+
+animations::ColourQuantization OutputBudget::quantization() const {
+    const Level& level = kLevels[level_];
+    return animations::ColourQuantization{std::max(floor_.step, level.step),
+                                          std::max(floor_.reuse_threshold, level.reuse_threshold)};
+}
+
+void OutputBudget::record_frame(std::uint64_t bytes, float time_s) {
+    total_bytes_ += bytes;
+    ++frames_;
+
+    if (!window_started_ || time_s < window_start_s_) {
+        window_started_ = true;
+        window_start_s_ = time_s;
+        window_bytes_ = 0;
+        window_frames_ = 0;
+    }
+    window_bytes_ += bytes;
+    ++window_frames_;
+
+    const float elapsed_s = time_s - window_start_s_;
+    if (elapsed_s < kWindowS) {
+        return;
+    }
+    kbps_ = static_cast<double>(window_bytes_) / 1024.0 / static_cast<double>(elapsed_s);
+    bytes_per_frame_ = static_cast<double>(window_bytes_) / static_cast<double>(window_frames_);
+    window_start_s_ = time_s;
+    window_bytes_ = 0;
+    window_frames_ = 0;
+
+    if (!budgeted()) {
+        return;
+    }
+    if (kbps_ > budget_kbps_ && level_ + 1 < kLevels.size()) {
+        ++level_;
+    } else if (kbps_ < budget_kbps_ * kRelaxFraction && level_ > 0) {
+        --level_;
+    }
+}
+
+} // namespace why
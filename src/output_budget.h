@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "animations/colour_budget.h"
+
+namespace why {
+
+// Counts the bytes each frame sends to the terminal and, with a budget, keeps the rate
+// under it by coarsening animation colours (see animations::ColourBudget).
+//
+// The rate is measured over half-second windows of animation time. A window over budget
+// moves one quantisation level up; one under 70% of the budget moves one level back down
+// towards the configured floor.
+class OutputBudget {
+public:
+    OutputBudget() = default;
+    // `budget_kbps` <= 0 only counts bytes; `floor` is the finest quantisation ever used.
+    OutputBudget(double budget_kbps, const animations::ColourQuantization& floor);
+
+    void record_frame(std::uint64_t bytes, float time_s);
+
+    bool budgeted() const { return budget_kbps_ > 0.0; }
+    double budget_kbps() const { return budget_kbps_; }
+    double kbps() const { return kbps_; }                      // Over the last full window
+    double bytes_per_frame() const { return bytes_per_frame_; } // Over the last full window
+    std::uint64_t total_bytes() const { return total_bytes_; }
+    std::uint64_t frames() const { return frames_; }
+    std::size_t level() const { return level_; }
+    animations::ColourQuantization quantization() const;
+
+private:
+    double budget_kbps_ = 0.0;
+    animations::ColourQuantization floor_;
+    std::size_t level_ = 0;
+
+    bool window_started_ = false;
+    float window_start_s_ = 0.0f;
+    std::uint64_t window_bytes_ = 0;
+    std::uint64_t window_frames_ = 0;
+
+    double kbps_ = 0.0;
+    double bytes_per_frame_ = 0.0;
+    std::uint64_t total_bytes_ = 0;
+    std::uint64_t frames_ = 0;
+};
+
+} // namespace why
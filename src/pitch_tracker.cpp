@@ -0,0 +1,163 @@
+#include "pitch_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace why {
+
+namespace {
+constexpr double kTwoPi = 6.28318530717958647692;
+// Cumulative-mean-normalised difference below which a lag counts as periodic.
+constexpr float kYinThreshold = 0.15f;
+// Windows quieter than this (mean square) are reported as unvoiced.
+constexpr double kSilenceEnergy = 1e-8;
+} // namespace
+
+PitchTracker::PitchTracker(std::uint32_t sample_rate, float min_frequency_hz, float max_frequency_hz)
+    : sample_rate_(sample_rate),
+      fft_cfg_(nullptr) {
+    if (sample_rate_ == 0 || min_frequency_hz <= 0.0f || max_frequency_hz <= min_frequency_hz) {
+        throw std::invalid_argument("Invalid pitch range");
+    }
+
+    min_lag_ = std::max<std::size_t>(2, static_cast<std::size_t>(std::floor(sample_rate_ / max_frequency_hz)));
+    max_lag_ = static_cast<std::size_t>(std::ceil(sample_rate_ / min_frequency_hz)) + 1;
+    window_size_ = 1;
+    while (window_size_ < 2 * max_lag_) {
+        window_size_ <<= 1;
+    }
+    transform_size_ = 2 * window_size_;
+
+    const std::size_t half = transform_size_ / 2;
+    fft_cfg_ = kiss_fft_alloc(static_cast<int>(half), 0, nullptr, nullptr);
+    if (!fft_cfg_) {
+        throw std::runtime_error("Failed to allocate FFT config");
+    }
+    fft_in_.assign(half, kiss_fft_cpx{0.0f, 0.0f});
+    fft_out_.assign(half, kiss_fft_cpx{0.0f, 0.0f});
+    split_re_.resize(half + 1);
+    split_im_.resize(half + 1);
+    for (std::size_t k = 0; k <= half; ++k) {
+        const double phase = kTwoPi * static_cast<double>(k) / static_cast<double>(transform_size_);
+        split_re_[k] = static_cast<float>(std::cos(phase));
+        split_im_[k] = static_cast<float>(-std::sin(phase));
+    }
+
+    padded_.assign(transform_size_, 0.0f);
+    power_.assign(half + 1, 0.0f);
+    spectrum_re_.assign(half + 1, 0.0f);
+    energy_prefix_.assign(window_size_ + 1, 0.0);
+    difference_.assign(max_lag_ + 2, 0.0f);
+}
+
+PitchTracker::~PitchTracker() {
+    if (fft_cfg_) {
+        kiss_fft_free(fft_cfg_);
+        fft_cfg_ = nullptr;
+    }
+}
+
+void PitchTracker::real_fft(const float* input, std::vector<float>& real_out, std::vector<float>* power_out) {
+    const std::size_t half = transform_size_ / 2;
+    for (std::size_t k = 0; k < half; ++k) {
+        fft_in_[k].r = input[2 * k];
+        fft_in_[k].i = input[2 * k + 1];
+    }
+    kiss_fft(fft_cfg_, fft_in_.data(), fft_out_.data());
+
+    const float dc = fft_out_[0].r + fft_out_[0].i;
+    const float nyquist = fft_out_[0].r - fft_out_[0].i;
+    real_out[0] = dc;
+    real_out[half] = nyquist;
+    if (power_out) {
+        (*power_out)[0] = dc * dc;
+        (*power_out)[half] = nyquist * nyquist;
+    }
+    for (std::size_t k = 1; k < half; ++k) {
+        const float zr = fft_out_[k].r;
+        const float zi = fft_out_[k].i;
+        const float cr = fft_out_[half - k].r;
+        const float ci = -fft_out_[half - k].i;
+        const float er = 0.5f * (zr + cr);
+        const float ei = 0.5f * (zi + ci);
+        const float or_ = 0.5f * (zi - ci);
+        const float oi = -0.5f * (zr - cr);
+        const float xr = er + (or_ * split_re_[k] - oi * split_im_[k]);
+        real_out[k] = xr;
+        if (power_out) {
+            const float xi = ei + (or_ * split_im_[k] + oi * split_re_[k]);
+            (*power_out)[k] = xr * xr + xi * xi;
+        }
+    }
+}
+
+void PitchTracker::analyze(const float* frame) {
+    frequency_ = 0.0f;
+    confidence_ = 0.0f;
+
+    energy_prefix_[0] = 0.0;
+    for (std::size_t i = 0; i < window_size_; ++i) {
+        energy_prefix_[i + 1] = energy_prefix_[i] + static_cast<double>(frame[i]) * static_cast<double>(frame[i]);
+    }
+    if (energy_prefix_[window_size_] < kSilenceEnergy * static_cast<double>(window_size_)) {
+        return;
+    }
+
+    // Autocorrelation r[tau] = sum x[j] x[j + tau] as the inverse transform of |X|^2. The
+    // power spectrum is real and even, so its inverse equals its forward transform / N and
+    // the same real-FFT path serves both directions.
+    std::copy(frame, frame + window_size_, padded_.begin());
+    std::fill(padded_.begin() + static_cast<std::ptrdiff_t>(window_size_), padded_.end(), 0.0f);
+    real_fft(padded_.data(), spectrum_re_, &power_);
+
+    const std::size_t half = transform_size_ / 2;
+    for (std::size_t n = 0; n < transform_size_; ++n) {
+        padded_[n] = power_[n <= half ? n : transform_size_ - n];
+    }
+    real_fft(padded_.data(), spectrum_re_, nullptr);
+    const float inverse_scale = 1.0f / static_cast<float>(transform_size_);
+
+    // d(tau) = sum (x[j] - x[j + tau])^2 over the overlapping part of the window, then
+    // YIN's cumulative-mean normalisation.
+    const double total_energy = energy_prefix_[window_size_];
+    difference_[0] = 1.0f;
+    double running_sum = 0.0;
+    for (std::size_t lag = 1; lag <= max_lag_; ++lag) {
+        const double head = energy_prefix_[window_size_ - lag];
+        const double tail = total_energy - energy_prefix_[lag];
+        const double autocorrelation = static_cast<double>(spectrum_re_[lag] * inverse_scale);
+        const double difference = std::max(0.0, head + tail - 2.0 * autocorrelation);
+        running_sum += difference;
+        difference_[lag] = running_sum > 0.0 ? static_cast<float>(difference * static_cast<double>(lag) / running_sum)
+                                             : 1.0f;
+    }
+
+    std::size_t lag = min_lag_;
+    while (lag <= max_lag_ && difference_[lag] >= kYinThreshold) {
+        ++lag;
+    }
+    if (lag > max_lag_) {
+        return;
+    }
+    while (lag + 1 <= max_lag_ && difference_[lag + 1] < difference_[lag]) {
+        ++lag;
+    }
+
+    // Parabolic interpolation around the minimum for sub-sample lag resolution.
+    float refined = static_cast<float>(lag);
+    if (lag > 1 && lag < max_lag_) {
+        const float left = difference_[lag - 1];
+        const float centre = difference_[lag];
+        const float right = difference_[lag + 1];
+        const float denominator = left - 2.0f * centre + right;
+        if (denominator > 0.0f) {
+            refined += 0.5f * (left - right) / denominator;
+        }
+    }
+
+    frequency_ = static_cast<float>(sample_rate_) / refined;
+    confidence_ = std::clamp(1.0f - difference_[lag], 0.0f, 1.0f);
+}
+
+} // namespace why
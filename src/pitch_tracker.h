@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <kiss_fft.h>
+}
+
+namespace why {
+
+// YIN fundamental-frequency estimator. The difference function is derived from the
+// autocorrelation, which is computed with two real FFTs (each a half-length complex FFT
+// plus a split pass) instead of the O(W^2) lag loop, so a hop costs about as much as one
+// extra spectrum of the window.
+class PitchTracker {
+public:
+    PitchTracker(std::uint32_t sample_rate, float min_frequency_hz, float max_frequency_hz);
+    ~PitchTracker();
+
+    PitchTracker(const PitchTracker&) = delete;
+    PitchTracker& operator=(const PitchTracker&) = delete;
+
+    // Samples analyze() expects: a power of two covering two periods of the lowest pitch.
+    std::size_t window_size() const { return window_size_; }
+
+    // Estimates the pitch of the newest window_size() mono samples in `frame`.
+    void analyze(const float* frame);
+
+    // Fundamental of the last window in Hz, or 0 when it was unvoiced.
+    float frequency() const { return frequency_; }
+    // 1 - the normalised difference at the chosen lag; 0 when unvoiced.
+    float confidence() const { return confidence_; }
+
+private:
+    void real_fft(const float* input, std::vector<float>& real_out, std::vector<float>* power_out);
+
+    std::uint32_t sample_rate_;
+    std::size_t window_size_;
+    std::size_t transform_size_; // 2 * window_size_, so the autocorrelation does not wrap
+    std::size_t min_lag_;
+    std::size_t max_lag_;
+
+    kiss_fft_cfg fft_cfg_;
+    std::vector<kiss_fft_cpx> fft_in_;
+    std::vector<kiss_fft_cpx> fft_out_;
+    std::vector<float> split_re_;
+    std::vector<float> split_im_;
+
+    std::vector<float> padded_;  // transform_size_ real inputs
+    std::vector<float> power_;   // transform_size_ / 2 + 1 bins
+    std::vector<float> spectrum_re_;
+    std::vector<double> energy_prefix_;
+    std::vector<float> difference_;
+
+    float frequency_ = 0.0f;
+    float confidence_ = 0.0f;
+};
+
+} // namespace why
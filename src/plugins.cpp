@@ -49,6 +49,8 @@ public:
         write_log(beat_strength, time_s);
     }
 
+    bool uses_band_energies() const override { return false; }
+
 private:
     void open_log(const std::string& directory) {
         log_.close();
@@ -105,6 +107,7 @@ void PluginManager::register_factory(const std::string& id, PluginFactory factor
 void PluginManager::load_from_config(const AppConfig& config) {
     warnings_.clear();
     active_.clear();
+    probes_.clear();
     if (config.plugins.safe_mode) {
         warnings_.push_back("Plug-ins disabled by plugins.safe_mode");
         return;
@@ -121,6 +124,9 @@ void PluginManager::load_from_config(const AppConfig& config) {
             continue;
         }
         plugin->on_load(config);
+        if (profiler_) {
+            probes_.push_back(profiler_->probe("plugin " + plugin->id() + " on_frame"));
+        }
         active_.push_back(std::move(plugin));
     }
 }
@@ -129,11 +135,34 @@ void PluginManager::notify_frame(const AudioMetrics& metrics,
                                  const std::vector<float>& bands,
                                  float beat_strength,
                                  double time_s) {
+    if (profiler_) {
+        for (std::size_t i = 0; i < active_.size(); ++i) {
+            ProfileScope scope(profiler_, probes_[i]);
+            active_[i]->on_frame(metrics, bands, beat_strength, time_s);
+        }
+        return;
+    }
     for (const std::unique_ptr<Plugin>& plugin : active_) {
         plugin->on_frame(metrics, bands, beat_strength, time_s);
     }
 }
 
+void PluginManager::set_profiler(Profiler* profiler) {
+    profiler_ = profiler;
+    probes_.clear();
+    if (profiler_) {
+        for (const std::unique_ptr<Plugin>& plugin : active_) {
+            probes_.push_back(profiler_->probe("plugin " + plugin->id() + " on_frame"));
+        }
+    }
+}
+
+bool PluginManager::uses_band_energies() const {
+    return std::any_of(active_.begin(), active_.end(), [](const std::unique_ptr<Plugin>& plugin) {
+        return plugin->uses_band_energies();
+    });
+}
+
 void register_builtin_plugins(PluginManager& manager) {
     manager.register_factory("beat-flash-debug", []() { return std::make_unique<BeatFlashDebugPlugin>(); });
 }
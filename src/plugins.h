@@ -8,6 +8,7 @@
 
 #include "audio_engine.h"
 #include "config.h"
+#include "profiler.h"
 
 namespace why {
 
@@ -20,6 +21,9 @@ public:
                           const std::vector<float>& bands,
                           float beat_strength,
                           double time_s) = 0;
+    // Plug-ins that only look at metrics/beat strength return false so the primary source
+    // may switch to sparse band analysis.
+    virtual bool uses_band_energies() const { return true; }
 };
 
 using PluginFactory = std::function<std::unique_ptr<Plugin>()>;
@@ -33,11 +37,18 @@ public:
                       float beat_strength,
                       double time_s);
 
+    bool uses_band_energies() const;
+
+    // Times each loaded plug-in's on_frame.
+    void set_profiler(Profiler* profiler);
+
     const std::vector<std::string>& warnings() const { return warnings_; }
 
 private:
     std::unordered_map<std::string, PluginFactory> factories_;
     std::vector<std::unique_ptr<Plugin>> active_;
+    Profiler* profiler_ = nullptr;
+    std::vector<Profiler::ProbeId> probes_; // Parallel to active_ while profiling
     std::vector<std::string> warnings_;
 };
 
@@ -0,0 +1,116 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace why {
+
+namespace {
+
+double to_us(std::uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+void write_json_string(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+Profiler::ProbeId Profiler::probe(const std::string& name) {
+    for (std::size_t i = 0; i < probes_.size(); ++i) {
+        if (probes_[i].name == name) {
+            return i;
+        }
+    }
+    probes_.push_back(Probe{});
+    probes_.back().name = name;
+    return probes_.size() - 1;
+}
+
+void Profiler::record(ProbeId id, Clock::duration elapsed) {
+    Probe& probe = probes_[id];
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    const std::uint64_t clamped = ns < 0 ? 0 : static_cast<std::uint64_t>(ns);
+    probe.samples_ns[probe.calls % kWindow] =
+        static_cast<std::uint32_t>(std::min<std::uint64_t>(clamped, std::numeric_limits<std::uint32_t>::max()));
+    probe.total_ns += clamped;
+    ++probe.calls;
+}
+
+std::vector<Profiler::Stats> Profiler::snapshot() const {
+    std::vector<Stats> result;
+    std::vector<std::uint32_t> window;
+    for (const Probe& probe : probes_) {
+        if (probe.calls == 0) {
+            continue;
+        }
+        const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(probe.calls, kWindow));
+        window.assign(probe.samples_ns.begin(), probe.samples_ns.begin() + count);
+        std::sort(window.begin(), window.end());
+
+        Stats stats;
+        stats.name = probe.name;
+        stats.calls = probe.calls;
+        stats.mean_us = to_us(probe.total_ns) / static_cast<double>(probe.calls);
+        stats.p50_us = to_us(window[(count - 1) / 2]);
+        stats.p99_us = to_us(window[(count - 1) * 99 / 100]);
+        stats.max_us = to_us(window.back());
+        result.push_back(std::move(stats));
+    }
+    std::sort(result.begin(), result.end(), [](const Stats& a, const Stats& b) { return a.p99_us > b.p99_us; });
+    return result;
+}
+
+bool Profiler::write_json(const std::string& path, std::string* error) const {
+    std::ofstream out(path);
+    if (!out) {
+        if (error) {
+            *error = "cannot open " + path + " for writing";
+        }
+        return false;
+    }
+
+    const std::vector<Stats> stats = snapshot();
+    out << "{\n  \"window\": " << kWindow << ",\n  \"probes\": [";
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        const Stats& entry = stats[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(out, entry.name);
+        out << ", \"calls\": " << entry.calls << ", \"mean_us\": " << entry.mean_us
+            << ", \"p50_us\": " << entry.p50_us << ", \"p99_us\": " << entry.p99_us
+            << ", \"max_us\": " << entry.max_us << "}";
+    }
+    out << (stats.empty() ? "]\n}\n" : "\n  ]\n}\n");
+
+    if (!out) {
+        if (error) {
+            *error = "failed writing " + path;
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace why
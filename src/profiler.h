@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace why {
+
+// Rolling timings for named probes (an event subscriber, one animation's update or render,
+// a plug-in's on_frame). Every probe keeps its call count, total time and the last
+// kWindow samples, from which percentiles are computed on demand.
+//
+// Instrumented code holds a `Profiler*` that is null while profiling is off, so the
+// disabled path costs one pointer test. Not thread-safe: probes are registered and
+// recorded on the render thread only.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ProbeId = std::size_t;
+
+    static constexpr std::size_t kWindow = 256;
+
+    struct Stats {
+        std::string name;
+        std::uint64_t calls = 0;
+        double mean_us = 0.0;
+        double p50_us = 0.0;
+        double p99_us = 0.0;
+        double max_us = 0.0; // Within the rolling window
+    };
+
+    // Returns the probe called `name`, registering it on first use.
+    ProbeId probe(const std::string& name);
+
+    void record(ProbeId id, Clock::duration elapsed);
+
+    // One entry per probe that has been recorded at least once, slowest p99 first.
+    std::vector<Stats> snapshot() const;
+
+    bool write_json(const std::string& path, std::string* error = nullptr) const;
+
+private:
+    struct Probe {
+        std::string name;
+        std::uint64_t calls = 0;
+        std::uint64_t total_ns = 0;
+        std::array<std::uint32_t, kWindow> samples_ns{};
+    };
+
+    std::vector<Probe> probes_;
+};
+
+// Times the enclosing scope into `id` when `profiler` is non-null.
+class ProfileScope {
+public:
+    ProfileScope(Profiler* profiler, Profiler::ProbeId id) : profiler_(profiler), id_(id) {
+        if (profiler_) {
+            start_ = Profiler::Clock::now();
+        }
+    }
+    ~ProfileScope() {
+        if (profiler_) {
+            profiler_->record(id_, Profiler::Clock::now() - start_);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler_;
+    Profiler::ProbeId id_;
+    Profiler::Clock::time_point start_{};
+};
+
+} // namespace why
@@ -1,31 +1,117 @@
 #include "renderer.h"
 
-#include <string>
-#include <random>
+#include <algorithm>
 #include <chrono>
-
-#include "animations/random_text_animation.h"
-#include "animations/animation_manager.h"
+#include <cstdio>
+#include <string>
 
 namespace why {
 
 namespace {
-static animations::AnimationManager animation_manager;
+constexpr std::size_t kOverlayProbeRows = 5;
+constexpr float kOverlayProbeRefreshS = 0.5f;
 } // namespace
 
-// set_active_animation is removed, AnimationManager handles adding animations
-void load_animations_from_config(notcurses* nc, const AppConfig& config) {
-    animation_manager.load_animations(nc, config);
+notcurses* start_notcurses(RenderBackend backend, std::FILE** sink) {
+    *sink = nullptr;
+    notcurses_options opts{};
+    opts.flags = NCOPTION_SUPPRESS_BANNERS;
+    if (backend == RenderBackend::Terminal) {
+        return notcurses_init(&opts, nullptr);
+    }
+
+    *sink = std::fopen("/dev/null", "w");
+    if (!*sink) {
+        return nullptr;
+    }
+    opts.flags |= NCOPTION_NO_ALTERNATE_SCREEN | NCOPTION_NO_QUIT_SIGHANDLERS | NCOPTION_NO_WINCH_SIGHANDLER |
+                  NCOPTION_PRESERVE_CURSOR | NCOPTION_NO_CLEAR_BITMAPS;
+    notcurses* nc = notcurses_init(&opts, *sink);
+    if (!nc) {
+        std::fclose(*sink);
+        *sink = nullptr;
+    }
+    return nc;
+}
+
+void Renderer::load_animations(notcurses* nc, const AppConfig& config) {
+    animation_manager_.load_animations(nc, config);
+    apply_visual_config(config.visual);
+}
+
+void Renderer::apply_visual_config(const VisualConfig& visual) {
+    const animations::ColourQuantization floor{visual.colour_step, visual.colour_reuse_threshold};
+    output_budget_ = OutputBudget(visual.bandwidth_kbps, floor);
+    animations::ColourBudget::instance().set(output_budget_.quantization());
+
+    adaptive_quality_ = visual.adaptive_quality;
+    std::chrono::duration<double, std::milli> budget(0.0);
+    if (adaptive_quality_) {
+        budget = std::chrono::duration<double, std::milli>(
+            visual.frame_budget_ms > 0.0 ? visual.frame_budget_ms : 900.0 / visual.target_fps);
+    }
+    animation_manager_.set_frame_budget(std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget));
+}
+
+void Renderer::set_profiler(Profiler* profiler) {
+    profiler_ = profiler;
+    overlay_probes_.clear();
+    overlay_stale_ = true;
+    animation_manager_.set_profiler(profiler);
+}
+
+void Renderer::set_worker_pool(WorkerPool* pool) {
+    animation_manager_.set_worker_pool(pool);
+}
+
+void Renderer::connect_source_events(const std::vector<std::unique_ptr<AudioSource>>& sources) {
+    for (std::size_t index = 0; index < sources.size(); ++index) {
+        sources[index]->set_event_bus(&animation_manager_.event_bus(), index);
+    }
+}
+
+void Renderer::configure_source_analysis(const std::vector<std::unique_ptr<AudioSource>>& sources,
+                                         bool primary_needs_all_bands) {
+    for (std::size_t index = 0; index < sources.size(); ++index) {
+        AudioSource& source = *sources[index];
+        for (std::size_t profile = 0; profile < source.profile_count(); ++profile) {
+            const std::string& name = source.profile_name(profile);
+            const bool primary_default = index == 0 && profile == 0;
+            if (primary_default && primary_needs_all_bands) {
+                source.subscribe_profile(profile, true, std::nullopt);
+                continue;
+            }
+            const bool subscribed = primary_default || animation_manager_.has_subscribers(source.id(), index, name);
+            source.subscribe_profile(profile, subscribed, animation_manager_.required_bands(source.id(), index, name));
+        }
+    }
 }
 
-void render_frame(notcurses* nc,
-               float time_s,
-               const AudioMetrics& metrics,
-               const std::vector<float>& bands,
-               float beat_strength,
-               bool file_stream,
-               bool show_metrics,
-               bool show_overlay_metrics) {
+void Renderer::update(float time_s, const std::vector<std::unique_ptr<AudioSource>>& sources) {
+    float delta_time = 0.0f;
+    if (first_frame_) {
+        first_frame_ = false;
+    } else {
+        delta_time = time_s - previous_time_s_;
+        if (delta_time < 0.0f) {
+            delta_time = 0.0f;
+        } else if (delta_time > 1.0f) {
+            delta_time = 1.0f;
+        }
+    }
+    previous_time_s_ = time_s;
+
+    if (adaptive_quality_ && frame_scheduler_ && frame_scheduler_->frames() > 0) {
+        animation_manager_.report_frame_time(frame_scheduler_->last_work());
+    }
+    animation_manager_.update_all(delta_time, sources);
+}
+
+void Renderer::draw(notcurses* nc,
+                    float time_s,
+                    const std::vector<std::unique_ptr<AudioSource>>& sources,
+                    bool show_metrics,
+                    bool show_overlay_metrics) {
     ncplane* stdplane = notcurses_stdplane(nc);
     unsigned int plane_rows = 0;
     unsigned int plane_cols = 0;
@@ -34,40 +120,194 @@ void render_frame(notcurses* nc,
     // Clear the standard plane (background)
     ncplane_erase(stdplane);
 
-    static float previous_time_s = time_s;
-    static bool first_frame = true;
-    float delta_time = 0.0f;
-    if (first_frame) {
-        first_frame = false;
+    animation_manager_.render_all(nc);
+
+    // Display overlay metrics if requested (primary source)
+    if (show_overlay_metrics && show_metrics && !sources.empty()) {
+        draw_overlay(stdplane, plane_rows, time_s, sources);
+    }
+}
+
+bool Renderer::present(notcurses* nc, float time_s) {
+    std::uint64_t bytes = 0;
+    if (!terminal_writer_) {
+        if (notcurses_render(nc) != 0) {
+            return false;
+        }
+        ncstats stats{};
+        notcurses_stats(nc, &stats);
+        bytes = stats.raster_bytes - std::min(raster_bytes_, stats.raster_bytes);
+        raster_bytes_ = stats.raster_bytes;
+    } else if (terminal_writer_->failed()) {
+        return false;
+    } else if (!terminal_writer_->ready()) {
+        // Leave the frame unrasterised: the planes keep their contents and the next
+        // frame that gets through is diffed against the last one written.
+        terminal_writer_->skip_frame();
     } else {
-        delta_time = time_s - previous_time_s;
-        if (delta_time < 0.0f) {
-            delta_time = 0.0f;
-        } else if (delta_time > 1.0f) {
-            delta_time = 1.0f;
+        char* buffer = nullptr;
+        std::size_t length = 0;
+        if (ncpile_render_to_buffer(notcurses_stdplane(nc), &buffer, &length) != 0) {
+            return false;
         }
+        bytes = length;
+        terminal_writer_->submit(buffer, length);
     }
-    previous_time_s = time_s;
 
-    // Update and render all animations managed by the AnimationManager
-    animation_manager.update_all(delta_time, metrics, bands, beat_strength);
-    animation_manager.render_all(nc);
+    const std::size_t level = output_budget_.level();
+    output_budget_.record_frame(bytes, time_s);
+    if (output_budget_.level() != level) {
+        animations::ColourBudget::instance().set(output_budget_.quantization());
+    }
+    return true;
+}
 
-    // Display overlay metrics if requested
-    if (show_overlay_metrics && show_metrics) {
-        ncplane_set_fg_rgb8(stdplane, 200, 200, 200); // White foreground
-        ncplane_set_bg_rgb8(stdplane, 0, 0, 0);     // Black background
-        ncplane_printf_yx(stdplane, plane_rows - 3, 0,
-                          "Audio %s",
-                          metrics.active ? (file_stream ? "file" : "capturing") : "inactive");
+void Renderer::resize(notcurses* nc) {
+    if (terminal_writer_) {
+        terminal_writer_->drain();
+    }
+    unsigned int rows = 0;
+    unsigned int cols = 0;
+    if (notcurses_refresh(nc, &rows, &cols) != 0) {
+        return;
+    }
+    animation_manager_.resize(rows, cols);
+}
+
+void Renderer::draw_overlay(ncplane* stdplane,
+                            unsigned int plane_rows,
+                            float time_s,
+                            const std::vector<std::unique_ptr<AudioSource>>& sources) {
+    const AudioSource& primary = *sources.front();
+    const AudioMetrics& metrics = primary.metrics();
+    ncplane_set_fg_rgb8(stdplane, 200, 200, 200); // White foreground
+    ncplane_set_bg_rgb8(stdplane, 0, 0, 0);     // Black background
+    ncplane_printf_yx(stdplane, plane_rows - 3, 0,
+                      "Audio %s (%s, %zu source%s)",
+                      metrics.active ? (primary.using_file_stream() ? "file" : "capturing") : "inactive",
+                      primary.id().c_str(),
+                      sources.size(),
+                      sources.size() == 1 ? "" : "s");
+
+    ncplane_printf_yx(stdplane, plane_rows - 2, 0,
+                      "RMS: %.3f | Peak: %.3f | Dropped: %zu | Beat: %.2f",
+                      metrics.rms,
+                      metrics.peak,
+                      metrics.dropped,
+                      primary.beat_strength());
 
-        ncplane_printf_yx(stdplane, plane_rows - 2, 0,
-                          "RMS: %.3f | Peak: %.3f | Dropped: %zu | Beat: %.2f",
-                          metrics.rms,
-                          metrics.peak,
-                          metrics.dropped,
-                          beat_strength);
+    unsigned int next_row = plane_rows >= 4 ? plane_rows - 4 : 0u;
+    if (plane_rows >= 4) {
+        const animations::ColourQuantization quantization = output_budget_.quantization();
+        ncplane_printf_yx(stdplane, static_cast<int>(next_row), 0,
+                          "Output %.1f KB/frame %.0f KB/s | colour step %u reuse %u",
+                          output_budget_.bytes_per_frame() / 1024.0,
+                          output_budget_.kbps(),
+                          quantization.step,
+                          quantization.reuse_threshold);
+        if (output_budget_.budgeted()) {
+            ncplane_printf(stdplane, " | budget %.0f KB/s", output_budget_.budget_kbps());
+        }
+        next_row = next_row > 0u ? next_row - 1u : 0u;
+    }
+    if (adaptive_quality_ && plane_rows >= 4) {
+        const std::string lowered = animation_manager_.quality_summary();
+        ncplane_printf_yx(stdplane, static_cast<int>(next_row), 0, "Quality: %s",
+                          lowered.empty() ? "full" : lowered.c_str());
+        next_row = next_row > 0u ? next_row - 1u : 0u;
+    }
+    if (frame_scheduler_ && plane_rows >= 4) {
+        const unsigned int used = draw_frame_stats(stdplane, next_row);
+        next_row = next_row >= used ? next_row - used : 0u;
+    }
+
+    if (!profiler_ || plane_rows < 4) {
+        return;
+    }
+    // Percentiles sort every probe's window, so the list is refreshed twice a second.
+    if (overlay_stale_ || time_s - overlay_refresh_s_ >= kOverlayProbeRefreshS || time_s < overlay_refresh_s_) {
+        overlay_probes_ = profiler_->snapshot();
+        if (overlay_probes_.size() > kOverlayProbeRows) {
+            overlay_probes_.resize(kOverlayProbeRows);
+        }
+        overlay_refresh_s_ = time_s;
+        overlay_stale_ = false;
+    }
+    for (std::size_t i = 0; i < overlay_probes_.size() && i <= next_row; ++i) {
+        const Profiler::Stats& stats = overlay_probes_[i];
+        ncplane_printf_yx(stdplane, static_cast<int>(next_row - i), 0,
+                          "%-40.40s p50 %7.1fus p99 %7.1fus n=%llu",
+                          stats.name.c_str(),
+                          stats.p50_us,
+                          stats.p99_us,
+                          static_cast<unsigned long long>(stats.calls));
+    }
+}
+
+unsigned int Renderer::draw_frame_stats(ncplane* stdplane, unsigned int bottom_row) {
+    static constexpr const char* kLevels[] = {" ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    static constexpr std::size_t kMaxHistogramCols = 48;
+
+    const FrameScheduler& scheduler = *frame_scheduler_;
+    const FrameHistogram& work = scheduler.work();
+    ncplane_printf_yx(stdplane, static_cast<int>(bottom_row), 0,
+                      "Frame p50 %.2fms p99 %.2fms max %.2fms | %.1f/%.0f fps | late %llu missed %llu",
+                      work.percentile_us(0.50) / 1000.0,
+                      work.percentile_us(0.99) / 1000.0,
+                      work.max_us() / 1000.0,
+                      scheduler.interval().mean_us() > 0.0 ? 1e6 / scheduler.interval().mean_us() : 0.0,
+                      scheduler.target_fps(),
+                      static_cast<unsigned long long>(scheduler.late_frames()),
+                      static_cast<unsigned long long>(scheduler.missed_deadlines()));
+    if (terminal_writer_) {
+        ncplane_printf(stdplane, " | unsent %llu", static_cast<unsigned long long>(terminal_writer_->skipped_frames()));
+    }
+    if (bottom_row == 0u) {
+        return 1u;
+    }
+
+    std::string stages = "p50 us:";
+    char buffer[32];
+    for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+        const auto stage = static_cast<FrameStage>(i);
+        std::snprintf(buffer, sizeof(buffer), " %s %.0f", frame_stage_name(stage),
+                      scheduler.stage(stage).percentile_us(0.50));
+        stages += buffer;
+    }
+    ncplane_putstr_yx(stdplane, static_cast<int>(bottom_row - 1), 0, stages.c_str());
+    if (bottom_row == 1u) {
+        return 2u;
+    }
+
+    // Frame-time histogram over the occupied buckets, one column per bucket.
+    const auto& buckets = work.buckets();
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::uint64_t peak = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        if (peak == 0) {
+            first = i;
+        }
+        last = i;
+        peak = std::max(peak, buckets[i]);
+    }
+    if (peak == 0) {
+        return 2u;
+    }
+    last = std::min(last, first + kMaxHistogramCols - 1);
+    std::snprintf(buffer, sizeof(buffer), "%.0fus ", FrameHistogram::bucket_lower_us(first));
+    std::string histogram = buffer;
+    for (std::size_t i = first; i <= last; ++i) {
+        const std::size_t level = buckets[i] == 0 ? 0 : 1 + static_cast<std::size_t>((buckets[i] * 7) / peak);
+        histogram += kLevels[level];
     }
+    std::snprintf(buffer, sizeof(buffer), " %.0fus", FrameHistogram::bucket_lower_us(last + 1));
+    histogram += buffer;
+    ncplane_putstr_yx(stdplane, static_cast<int>(bottom_row - 2), 0, histogram.c_str());
+    return 3u;
 }
 
 } // namespace why
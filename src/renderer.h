@@ -1,26 +1,129 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <notcurses/notcurses.h>
 
 #include "audio_engine.h"
+#include "audio_sources.h"
 #include "animations/animation.h"
 #include "animations/animation_manager.h" // Include AnimationManager
 #include "config.h" // Include AppConfig
+#include "frame_scheduler.h"
+#include "output_budget.h"
+#include "profiler.h"
+#include "terminal_writer.h"
+#include "worker_pool.h"
 
 namespace why {
 
-void render_frame(notcurses* nc,
-               float time_s,
-               const AudioMetrics& metrics,
-               const std::vector<float>& bands,
-               float beat_strength,
-               bool file_stream,
-               bool show_metrics,
-               bool show_overlay_metrics);
+enum class RenderBackend {
+    Terminal,
+    // Renders through notcurses as usual, but into /dev/null and without taking over the
+    // screen, so the whole update+render pipeline can be timed without a TTY.
+    Headless,
+};
 
-void load_animations_from_config(notcurses* nc, const AppConfig& config);
+// Starts notcurses for `backend`. For the headless backend `sink` receives the output
+// stream, to be closed after notcurses_stop(); it stays null otherwise.
+notcurses* start_notcurses(RenderBackend backend, std::FILE** sink);
 
-} // namespace why
+// Owns the loaded animations and draws them, plus the metrics overlay, once per frame.
+// update() and draw() are separate so the frame scheduler can time them apart.
+class Renderer {
+public:
+    // Delivers this frame's events and advances every animation to `time_s`.
+    void update(float time_s, const std::vector<std::unique_ptr<AudioSource>>& sources);
+
+    void draw(notcurses* nc,
+              float time_s,
+              const std::vector<std::unique_ptr<AudioSource>>& sources,
+              bool show_metrics,
+              bool show_overlay_metrics);
+
+    // Rasterises the drawn frame and writes it out: through notcurses_render(), or, with a
+    // terminal writer, into a buffer that the writer's thread writes while the next frame
+    // is built. Skips the frame when the writer is still behind. Counts the bytes sent
+    // against the output budget. False on failure.
+    bool present(notcurses* nc, float time_s);
+
+    // Call on NCKEY_RESIZE. Lets notcurses pick up the new terminal size, then lays every
+    // animation's plane out again for it. A pending pipelined frame is written first, as
+    // notcurses_refresh() writes to the terminal itself. Planes keep their layout when
+    // notcurses cannot refresh.
+    void resize(notcurses* nc);
+
+    // Also applies the colour quantisation, bandwidth budget and adaptive quality settings
+    // from config.visual.
+    void load_animations(notcurses* nc, const AppConfig& config);
+
+    // Rebuilds only the animations a config reload changed; see
+    // AnimationManager::reload_animations. Returns how many were created.
+    std::size_t reload_animations(notcurses* nc, const AppConfig& before, const AppConfig& after) {
+        return animation_manager_.reload_animations(nc, before, after);
+    }
+
+    // Destroys the animations and their planes; call before notcurses_stop().
+    void shutdown() { animation_manager_.clear(); }
+
+    // The colour quantisation, bandwidth budget and adaptive quality settings. Restarts
+    // the output budget's measurement.
+    void apply_visual_config(const VisualConfig& visual);
+
+    const OutputBudget& output_budget() const { return output_budget_; }
+    // Animations running below full quality; see AnimationManager::set_frame_budget.
+    std::string quality_summary() const { return animation_manager_.quality_summary(); }
+
+    // Tells every source which analysis profiles the loaded animations follow and which
+    // bands they read, so unused profiles and idle parts of the spectrum are skipped. The
+    // primary source always keeps its default profile for plug-ins and the overlay;
+    // `primary_needs_all_bands` keeps that profile on the full spectrum.
+    void configure_source_analysis(const std::vector<std::unique_ptr<AudioSource>>& sources,
+                                   bool primary_needs_all_bands);
 
+    // Runs the update phase of animations that support it across `pool` (nullptr turns it
+    // off again); see AnimationManager::set_worker_pool.
+    void set_worker_pool(WorkerPool* pool);
+
+    // Profiles the animations (call before load_animations) and lists the slowest probes
+    // in the overlay when overlay metrics are shown. nullptr turns it off.
+    void set_profiler(Profiler* profiler);
+
+    // Lets sources post events from their processing threads to the animations' bus.
+    void connect_source_events(const std::vector<std::unique_ptr<AudioSource>>& sources);
+
+    // Shows the frame-time histogram and per-stage times in the overlay. nullptr hides them.
+    void set_frame_scheduler(const FrameScheduler* scheduler) { frame_scheduler_ = scheduler; }
+
+    // Hands rasterised frames to `writer` instead of writing them inline. nullptr turns it off.
+    void set_terminal_writer(TerminalWriter* writer) { terminal_writer_ = writer; }
+
+private:
+    void draw_overlay(ncplane* stdplane,
+                      unsigned int plane_rows,
+                      float time_s,
+                      const std::vector<std::unique_ptr<AudioSource>>& sources);
+    // Draws the frame lines above the audio lines; returns how many rows they took.
+    unsigned int draw_frame_stats(ncplane* stdplane, unsigned int bottom_row);
+
+    animations::AnimationManager animation_manager_;
+    Profiler* profiler_ = nullptr;
+    const FrameScheduler* frame_scheduler_ = nullptr;
+    TerminalWriter* terminal_writer_ = nullptr;
+    OutputBudget output_budget_;
+    std::uint64_t raster_bytes_ = 0; // notcurses_stats() total after the last frame
+
+    bool adaptive_quality_ = false;
+    float previous_time_s_ = 0.0f;
+    bool first_frame_ = true;
+
+    std::vector<Profiler::Stats> overlay_probes_; // Slowest probes, refreshed periodically
+    float overlay_refresh_s_ = 0.0f;
+    bool overlay_stale_ = true;
+};
+
+} // namespace why
@@ -0,0 +1,107 @@
+#include "terminal_writer.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace why {
+
+TerminalWriter::TerminalWriter(int fd)
+    : fd_(fd),
+      thread_([this]() { run(); }) {}
+
+TerminalWriter::~TerminalWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    frame_ready_.notify_one();
+    thread_.join();
+    std::free(pending_.data);
+}
+
+bool TerminalWriter::ready() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.data == nullptr;
+}
+
+void TerminalWriter::submit(char* buffer, std::size_t length) {
+    if (failed()) {
+        std::free(buffer);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::free(pending_.data); // Only non-null if the caller ignored ready()
+        pending_ = Frame{buffer, length};
+    }
+    frame_ready_.notify_one();
+}
+
+void TerminalWriter::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    frame_written_.wait(lock, [this]() { return pending_.data == nullptr && !writing_; });
+}
+
+FrameHistogram TerminalWriter::write_times() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_times_;
+}
+
+void TerminalWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        frame_ready_.wait(lock, [this]() { return stopping_ || pending_.data != nullptr; });
+        if (pending_.data == nullptr) {
+            return; // Stopping with nothing left to write
+        }
+        const Frame frame = pending_;
+        pending_ = Frame{};
+        writing_ = true;
+        lock.unlock();
+
+        const auto start = FrameScheduler::Clock::now();
+        const bool written = !failed() && write_all(frame.data, frame.length);
+        const auto elapsed = FrameScheduler::Clock::now() - start;
+        std::free(frame.data);
+        if (written) {
+            written_frames_.fetch_add(1, std::memory_order_relaxed);
+            written_bytes_.fetch_add(frame.length, std::memory_order_relaxed);
+        }
+
+        lock.lock();
+        if (written) {
+            write_times_.add(elapsed);
+        }
+        writing_ = false;
+        frame_written_.notify_all();
+    }
+}
+
+bool TerminalWriter::write_all(const char* data, std::size_t length) {
+    while (length > 0) {
+        const ssize_t count = ::write(fd_, data, length);
+        if (count > 0) {
+            data += count;
+            length -= static_cast<std::size_t>(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // The terminal may be non-blocking; wait until it takes more.
+            pollfd pfd{fd_, POLLOUT, 0};
+            if (::poll(&pfd, 1, -1) >= 0 || errno == EINTR) {
+                continue;
+            }
+        }
+        failed_.store(true, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+} // namespace why
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "frame_scheduler.h"
+
+namespace why {
+
+// Writes rasterised frames to the terminal on its own thread, so a slow terminal (SSH,
+// tmux) stalls this thread instead of the frame loop.
+//
+// The frame loop renders each frame into a buffer with ncpile_render_to_buffer() and
+// submits it. One frame is written while at most one more waits; when that slot is
+// still taken the loop should not render at all. notcurses diffs every frame against the
+// last one it rasterised, so a rasterised frame can never be dropped — only frames that
+// were never rasterised can.
+class TerminalWriter {
+public:
+    explicit TerminalWriter(int fd);
+    ~TerminalWriter(); // Writes out whatever is still queued
+
+    TerminalWriter(const TerminalWriter&) = delete;
+    TerminalWriter& operator=(const TerminalWriter&) = delete;
+
+    // False while a frame is still waiting behind the one being written.
+    bool ready() const;
+
+    // Queues `buffer` (malloc'd, as ncpile_render_to_buffer() returns it) and takes
+    // ownership of it. Only call when ready().
+    void submit(char* buffer, std::size_t length);
+
+    // Counts a frame the loop did not render because the writer was not ready.
+    void skip_frame() { skipped_frames_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Blocks until every submitted frame has been written. Call before notcurses_stop(),
+    // which writes to the same terminal.
+    void drain();
+
+    // Set once a write fails for good (the terminal went away); later frames are discarded.
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+    std::uint64_t written_frames() const { return written_frames_.load(std::memory_order_relaxed); }
+    std::uint64_t skipped_frames() const { return skipped_frames_.load(std::memory_order_relaxed); }
+    std::uint64_t written_bytes() const { return written_bytes_.load(std::memory_order_relaxed); }
+
+    // How long each frame took to write.
+    FrameHistogram write_times() const;
+
+private:
+    struct Frame {
+        char* data = nullptr;
+        std::size_t length = 0;
+    };
+
+    void run();
+    bool write_all(const char* data, std::size_t length);
+
+    int fd_;
+    mutable std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::condition_variable frame_written_;
+    Frame pending_;
+    bool writing_ = false;
+    bool stopping_ = false;
+    FrameHistogram write_times_;
+
+    std::atomic<bool> failed_{false};
+    std::atomic<std::uint64_t> written_frames_{0};
+    std::atomic<std::uint64_t> skipped_frames_{0};
+    std::atomic<std::uint64_t> written_bytes_{0};
+
+    std::thread thread_; // Last, so it starts after everything above is constructed
+};
+
+} // namespace why
@@ -0,0 +1,162 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+namespace why {
+
+namespace {
+
+std::uint64_t pack_range(std::uint64_t begin, std::uint64_t end) {
+    return begin | (end << 32);
+}
+
+std::uint64_t range_begin(std::uint64_t bounds) {
+    return bounds & 0xffffffffu;
+}
+
+std::uint64_t range_end(std::uint64_t bounds) {
+    return bounds >> 32;
+}
+
+} // namespace
+
+WorkerPool::WorkerPool(std::size_t worker_count)
+    : ranges_(std::make_unique<Range[]>(worker_count + 1)) {
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i + 1); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+std::size_t WorkerPool::resolve_worker_count(std::size_t configured, std::size_t max_useful) {
+    std::size_t count = configured;
+    if (count == 0) {
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? static_cast<std::size_t>(hardware - 1) : 0;
+    }
+    return std::min(count, max_useful);
+}
+
+void WorkerPool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (workers_.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    const std::size_t participants = workers_.size() + 1;
+    for (std::size_t p = 0; p < participants; ++p) {
+        const std::uint64_t begin = count * p / participants;
+        const std::uint64_t end = count * (p + 1) / participants;
+        ranges_[p].bounds.store(pack_range(begin, end), std::memory_order_relaxed);
+    }
+    remaining_.store(count, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        ++generation_;
+    }
+    work_ready_.notify_all();
+
+    run_items(0, fn);
+
+    // Workers that woke up late may still be looking for work; `fn` has to outlive them.
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this]() {
+        return remaining_.load(std::memory_order_acquire) == 0 && busy_workers_ == 0;
+    });
+    job_ = nullptr;
+}
+
+bool WorkerPool::take_front(Range& range, std::size_t& index) {
+    std::uint64_t bounds = range.bounds.load(std::memory_order_acquire);
+    while (range_begin(bounds) < range_end(bounds)) {
+        const std::uint64_t next = pack_range(range_begin(bounds) + 1, range_end(bounds));
+        if (range.bounds.compare_exchange_weak(bounds, next, std::memory_order_acq_rel)) {
+            index = static_cast<std::size_t>(range_begin(bounds));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkerPool::steal_into(std::size_t thief) {
+    const std::size_t participants = workers_.size() + 1;
+    for (std::size_t offset = 1; offset < participants; ++offset) {
+        Range& victim = ranges_[(thief + offset) % participants];
+        std::uint64_t bounds = victim.bounds.load(std::memory_order_acquire);
+        while (range_begin(bounds) < range_end(bounds)) {
+            const std::uint64_t available = range_end(bounds) - range_begin(bounds);
+            const std::uint64_t split = range_end(bounds) - (available + 1) / 2;
+            if (victim.bounds.compare_exchange_weak(bounds,
+                                                    pack_range(range_begin(bounds), split),
+                                                    std::memory_order_acq_rel)) {
+                // The thief's own range is empty, so nobody else can be modifying it.
+                ranges_[thief].bounds.store(pack_range(split, range_end(bounds)), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run_items(std::size_t participant, const std::function<void(std::size_t)>& fn) {
+    Range& own = ranges_[participant];
+    while (true) {
+        std::size_t index = 0;
+        while (take_front(own, index)) {
+            fn(index);
+            remaining_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        if (!steal_into(participant)) {
+            return;
+        }
+    }
+}
+
+void WorkerPool::worker_loop(std::size_t participant) {
+    std::size_t seen_generation = 0;
+    while (true) {
+        const std::function<void(std::size_t)>* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [this, seen_generation]() {
+                return stopping_ || generation_ != seen_generation;
+            });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+            job = job_;
+            if (!job) {
+                continue;
+            }
+            ++busy_workers_;
+        }
+        run_items(participant, *job);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busy_workers_;
+        }
+        work_done_.notify_one();
+    }
+}
+
+} // namespace why
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace why {
+
+// Small fixed-size pool for fork/join work on the frame loop. The calling thread takes part
+// in every parallel_for, so a pool with zero workers simply runs the loop inline.
+//
+// Each participant starts on its own contiguous share of the indices and, once that runs
+// dry, steals the back half of another participant's remaining range. Uneven items (one
+// heavy animation among light ones) therefore balance out without a shared counter that
+// every item has to go through.
+class WorkerPool {
+public:
+    explicit WorkerPool(std::size_t worker_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Invokes fn(i) for every i in [0, count) and returns once all calls have finished.
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+    std::size_t worker_count() const { return workers_.size(); }
+
+    // Worker count for a configured size; 0 means one worker per remaining hardware core.
+    static std::size_t resolve_worker_count(std::size_t configured, std::size_t max_useful);
+
+private:
+    // [begin, end) packed as two 32-bit halves so owner and thieves update it with one CAS.
+    struct alignas(64) Range {
+        std::atomic<std::uint64_t> bounds{0};
+    };
+
+    void worker_loop(std::size_t participant);
+    void run_items(std::size_t participant, const std::function<void(std::size_t)>& fn);
+    bool take_front(Range& range, std::size_t& index);
+    bool steal_into(std::size_t thief);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Range[]> ranges_; // One per participant; the caller is participant 0
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+
+    const std::function<void(std::size_t)>* job_ = nullptr;
+    std::atomic<std::size_t> remaining_{0};
+    std::size_t busy_workers_ = 0;
+    std::size_t generation_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace why